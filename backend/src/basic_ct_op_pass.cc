@@ -18,26 +18,139 @@
 
 #include "include/basic_ct_op_pass.h"
 
+#include <algorithm>
 #include <cwchar>
+#include <optional>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include "include/add_cp.h"
 #include "include/ct_program.h"
 #include "include/dag.h"
 #include "include/debug_info.h"
 #include "include/dictionary.h"
 #include "include/extended_std.h"
 #include "include/laid_out_tensor.h"
+#include "include/mul_cp.h"
 #include "include/program_context.h"
+#include "include/ram_dictionary.h"
 #include "include/t_op.h"
 #include "include/utils.h"
+#include "include/zero_c.h"
 
 namespace fhelipe {
 
+namespace {
+
+using LeveledTOpNode = std::shared_ptr<Node<LeveledTOp>>;
+
+// A TOp lowered into a CtProgram of its own, on stand-ins for the chunks of
+// its parents
+struct LoweredTOp {
+  std::unique_ptr<ct_program::CtProgram> ct_program;
+  // Stand-in -> the chunk it stands in for
+  std::unordered_map<const Node<CtOp>*, TOp::Chunk> stand_ins;
+  std::optional<TOp::LaidOutTensorCt> tensor;
+};
+
+// Groups `nodes`, which are in topological order, so that the parents of every
+// node are in earlier groups
+std::vector<std::vector<LeveledTOpNode>> Waves(
+    const std::vector<LeveledTOpNode>& nodes) {
+  std::unordered_map<const Node<LeveledTOp>*, int> node_wave;
+  std::vector<std::vector<LeveledTOpNode>> result;
+  for (const auto& node : nodes) {
+    int wave = 0;
+    for (const auto& parent : node->Parents()) {
+      wave = std::max(wave, node_wave.at(parent.get()) + 1);
+    }
+    node_wave.emplace(node.get(), wave);
+    if (result.size() <= wave) {
+      result.resize(wave + 1);
+    }
+    result.at(wave).push_back(node);
+  }
+  return result;
+}
+
+LoweredTOp LowerTOp(const ProgramContext& context, const LeveledTOp& t_op,
+                    const std::vector<TOp::LaidOutTensorCt>& input_tensors) {
+  LoweredTOp result{std::make_unique<ct_program::CtProgram>(
+      context, std::make_unique<RamDictionary<ChunkIr>>(), Dag<CtOp>())};
+  std::unordered_map<const Node<CtOp>*, TOp::Chunk> chunk_stand_ins;
+  auto stand_in_tensors = Estd::transform(
+      input_tensors, [&](const TOp::LaidOutTensorCt& tensor) {
+        return TOp::LaidOutTensorCt{Estd::transform(
+            tensor.Chunks(), [&](const TOp::LaidOutChunk& chunk) {
+              auto& stand_in = chunk_stand_ins[chunk.Chunk().get()];
+              if (!stand_in) {
+                // A copy of the chunk's CtOp, so that ct_program's peepholes
+                // (e.g., on ZeroC) fire just as they would on the chunk
+                stand_in = result.ct_program->AddNode(
+                    chunk.Chunk()->Value().CloneUniq(), {});
+                result.stand_ins.emplace(stand_in.get(), chunk.Chunk());
+              }
+              return TOp::LaidOutChunk(chunk.Layout(), chunk.Offset(),
+                                       stand_in);
+            })};
+      });
+  result.tensor = t_op.AmendCtProgram(*result.ct_program, stand_in_tensors);
+  return result;
+}
+
+// Replays `lowered` into `ct_program` as if the TOp had been lowered straight
+// into it: chunks are recorded and nodes are added in the order the TOp
+// created them, and ZeroCs are shared with the ones already in `ct_program`
+TOp::LaidOutTensorCt Stitch(ct_program::CtProgram& ct_program,
+                            const LoweredTOp& lowered) {
+  std::unordered_map<KeyType, KeyType> keys;
+  for (const auto& key : lowered.ct_program->RecordedChunkKeys()) {
+    keys.emplace(key,
+                 ct_program.RecordChunk(lowered.ct_program->GetChunkIr(key)));
+  }
+
+  // Node ids are handed out in creation order
+  auto nodes = lowered.ct_program->NodesInTopologicalOrder();
+  std::sort(nodes.begin(), nodes.end(), [](const auto& lhs, const auto& rhs) {
+    return lhs->NodeId() < rhs->NodeId();
+  });
+  auto new_nodes = lowered.stand_ins;
+  for (const auto& node : nodes) {
+    if (Estd::contains_key(new_nodes, node.get())) {
+      continue;
+    }
+    const auto& ct_op = node->Value();
+    TOp::Chunk new_node;
+    if (dynamic_cast<const ZeroC*>(&ct_op)) {
+      new_node = ct_program::FetchZeroC(ct_program, ct_op.GetLevelInfo());
+    } else {
+      new_node = ct_program.AddNode(
+          ct_program::WithChunkKeys(ct_op, keys),
+          Estd::transform(node->Parents(), [&new_nodes](const auto& parent) {
+            return new_nodes.at(parent.get());
+          }));
+    }
+    new_nodes.emplace(node.get(), new_node);
+  }
+
+  return TOp::LaidOutTensorCt{Estd::transform(
+      lowered.tensor->Chunks(), [&new_nodes](const TOp::LaidOutChunk& chunk) {
+        return TOp::LaidOutChunk(chunk.Layout(), chunk.Offset(),
+                                 new_nodes.at(chunk.Chunk().get()));
+      })};
+}
+
+}  // namespace
+
 BasicCtOpPass::BasicCtOpPass(const ProgramContext& context,
-                             std::unique_ptr<Dictionary<ChunkIr>>&& chunk_dict)
-    : context_(context), chunk_dict_(std::move(chunk_dict)) {}
+                             std::unique_ptr<Dictionary<ChunkIr>>&& chunk_dict,
+                             int thread_count)
+    : context_(context),
+      chunk_dict_(std::move(chunk_dict)),
+      thread_count_(thread_count) {
+  CHECK(thread_count_ > 0);
+}
 
 CtOpPassOutput BasicCtOpPass::DoPass(const CtOpPassInput& in_dag) {
   ct_program::CtProgram ct_program(context_, *chunk_dict_);
@@ -47,16 +160,28 @@ CtOpPassOutput BasicCtOpPass::DoPass(const CtOpPassInput& in_dag) {
       new_to_old_nodes;
   auto nodes = in_dag.NodesInTopologicalOrder();
   int count = 0;
-  for (const auto& node : nodes) {
-    LOG(INFO) << count++ << " / " << nodes.size();
-    WriteStream(LOG(INFO), node->Value());
-    auto parents = Estd::values_from_keys(old_to_new_nodes, node->Parents());
-    TOp::LaidOutTensorCt new_tensor =
-        node->Value().AmendCtProgram(ct_program, parents);
-    for (const auto& chunk : new_tensor.Chunks()) {
-      new_to_old_nodes.emplace(chunk.Chunk().get(), node.get());
+  for (const auto& wave : Waves(nodes)) {
+    // Looked up front since `old_to_new_nodes` only grows between waves
+    auto input_tensors = Estd::transform(wave, [&](const auto& node) {
+      return Estd::values_from_keys(old_to_new_nodes, node->Parents());
+    });
+    std::vector<LoweredTOp> lowered(wave.size());
+    ParallelFor(wave.size(), thread_count_, [&](int idx) {
+      lowered.at(idx) =
+          LowerTOp(context_, wave.at(idx)->Value(), input_tensors.at(idx));
+    });
+
+    for (int idx : Estd::indices(wave.size())) {
+      const auto& node = wave.at(idx);
+      LOG(INFO) << count++ << " / " << nodes.size();
+      WriteStream(LOG(INFO), node->Value());
+      TOp::LaidOutTensorCt new_tensor = Stitch(ct_program, lowered.at(idx));
+      lowered.at(idx) = {};
+      for (const auto& chunk : new_tensor.Chunks()) {
+        new_to_old_nodes.emplace(chunk.Chunk().get(), node.get());
+      }
+      old_to_new_nodes.emplace(node.get(), new_tensor);
     }
-    old_to_new_nodes.emplace(node.get(), new_tensor);
   }
 
   // Assign ancestor ids
@@ -68,9 +193,18 @@ CtOpPassOutput BasicCtOpPass::DoPass(const CtOpPassInput& in_dag) {
       // Some nodes end up having all their children killed and not cleaned
       // up... there should be a pass to clean them up, but for now I just
       // don't register their ancestors.
-      if (!node->Children().empty() &&
-          !(*node->Children().begin())->Ancestors().empty()) {
-        node->AddAncestor((*node->Children().begin())->Ancestors().at(0));
+      const auto& children = node->Children();
+      if (children.empty()) {
+        continue;
+      }
+      // Lowest id rather than lowest address, to stay deterministic
+      const auto& child = *std::min_element(
+          children.begin(), children.end(),
+          [](const auto& lhs, const auto& rhs) {
+            return lhs->NodeId() < rhs->NodeId();
+          });
+      if (!child->Ancestors().empty()) {
+        node->AddAncestor(child->Ancestors().at(0));
       }
     }
   }
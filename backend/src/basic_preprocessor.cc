@@ -67,4 +67,9 @@ PreprocessorOutput BasicPreprocessor::DoPass(const PreprocessorInput& code) {
   return preprocessed;
 }
 
+std::string BasicPreprocessor::PassSettings() const {
+  return std::to_string(default_log_scale_.value()) + " " +
+         std::to_string(max_usable_level_.value());
+}
+
 }  // namespace fhelipe
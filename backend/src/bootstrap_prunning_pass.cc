@@ -18,240 +18,229 @@
 
 #include "include/bootstrap_prunning_pass.h"
 
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <unordered_set>
+
+#include "include/extended_std.h"
 #include "include/t_bootstrap_c.h"
 #include "include/t_rescale_c.h"
+#include "include/utils.h"
 
 namespace fhelipe {
 
 namespace {
 
-// Assumes source dag does not change (or at least the mapped nodes and their
-// immediate neighbors)
-template <class T>
-class HypotheticalDag {
- public:
-  std::shared_ptr<Node<LeveledTOp>> Mapping(Node<T>& node) {
-    return map_.at(&node);
-  }
-
-  std::shared_ptr<Node<T>> NewNode(Node<T>& node) {
-    AddMapping(node, CloneUniqWithSameAncestors(node));
-    return Mapping(node);
-  }
-
-  std::shared_ptr<Node<T>> MappingCreateIfNeeded(Node<T>& node) {
-    if (Estd::contains_key(map_, &node)) {
-      return map_.at(&node);
-    }
-    return NewNode(node);
-  }
-
-  // Don't include the mapped node when Commit()ing
-  void RemoveMapping(const std::shared_ptr<Node<T>>& node) {
-    auto mapped_node = map_.at(node.get());
-    dont_commit_but_also_dont_garbage_collect_.push_back(mapped_node);
-    map_.erase(node.get());
-  }
-
-  bool Contains(const Node<T>& node) const { return Estd::contains_key(&node); }
+// Candidates evaluated together per thread before any of them is committed
+constexpr int kCandidatesPerThread = 4;
+
+// What removing a bootstrap would do to the levels after it
+struct PruneEvaluation {
+  int bootstrap;
+  bool enough_levels;
+  // Nodes whose levels change and their new levels
+  std::unordered_map<int, int> new_levels;
+  // Nodes whose levels or edges the evaluation depends on
+  std::vector<int> read;
+};
 
-  void AddMapping(Node<T>& node, const std::shared_ptr<Node<T>>& new_node) {
-    CHECK(!Estd::contains_key(map_, &node));
-    map_.emplace(&node, new_node);
-    for (const auto& parent : node.Parents()) {
-      if (Estd::contains_key(map_, parent.get())) {
-        // Need to check if parent.get() still contains child, because parent
-        // may appear twice in node's Parents()
-        if (map_.at(parent.get())->ContainsChild(node)) {
-          // Replace parent's node child with the newly created node
-          map_.at(parent.get())->RemoveChild(node);
-        }
-        AddParentChildEdge(map_.at(parent.get()), map_.at(&node));
-      } else {
-        // If parent is not mapped, set the parent to the non-mapped parent
-        // (but don't let the non-mapped parent know about map_.at(&node), cuz
-        // this node is only hypothetical
-        map_.at(&node)->AddParent(parent);
-      }
-    }
+// Levels and edges of a leveled dag on dense indices in topological order,
+// kept in sync with the dag as bootstraps are pruned
+class PruningState {
+ public:
+  explicit PruningState(const Dag<LeveledTOp>& dag);
 
-    // Same for children as for the parents
-    for (const auto& child : node.Children()) {
-      if (Estd::contains_key(map_, child.get())) {
-        AddParentChildEdge(map_.at(&node), map_.at(child.get()));
-        map_.at(child.get())->RemoveParent(node);
-      } else {
-        map_.at(&node)->AddChild(child);
-      }
-    }
-  }
+  // Only reads the state, so several can run concurrently
+  PruneEvaluation Evaluate(int bootstrap) const;
+  // Removes the bootstrap of an evaluation with enough levels and applies its
+  // new levels; returns the nodes whose levels or edges change
+  std::vector<int> Prune(const PruneEvaluation& evaluation);
 
-  void Commit() {
-    for (auto& [old_node, new_node] : map_) {
-      old_node->SetValue(new_node->Value().CloneUniq());
-    }
+  const std::vector<int>& Bootstraps() const { return bootstraps_; }
+  const TBootstrapC& GetTBootstrapC(int idx) const {
+    return dynamic_cast<const TBootstrapC&>(nodes_.at(idx)->Value().GetTOp());
   }
 
  private:
-  std::unordered_map<Node<T>*, std::shared_ptr<Node<T>>> map_;
-  std::vector<std::shared_ptr<Node<T>>>
-      dont_commit_but_also_dont_garbage_collect_;
+  std::vector<std::shared_ptr<Node<LeveledTOp>>> nodes_;
+  std::vector<std::vector<int>> parents_;
+  std::vector<std::vector<int>> children_;
+  std::vector<int> levels_;
+  std::vector<bool> is_bootstrap_;
+  std::vector<bool> is_rescale_;
+  std::vector<int> bootstraps_;
 };
 
-std::optional<LevelInfo> NodeLevelInfo(const Node<LeveledTOp>& node_t) {
-  const auto& node = node_t.Value();
-  CHECK(!dynamic_cast<const TInputC*>(&node.GetTOp()));
-  if (const auto* t_bootstrap_c =
-          dynamic_cast<const TBootstrapC*>(&node.GetTOp())) {
-    return node.GetLevelInfo();
+PruningState::PruningState(const Dag<LeveledTOp>& dag)
+    : nodes_(dag.NodesInTopologicalOrder()) {
+  std::unordered_map<const Node<LeveledTOp>*, int> dense_indices;
+  for (int idx : Estd::indices(nodes_.size())) {
+    dense_indices.emplace(nodes_.at(idx).get(), idx);
   }
-  if (const auto* t_rescale_c =
-          dynamic_cast<const TRescaleC*>(&node.GetTOp())) {
-    if (node_t.Parents().at(0)->Value().Level() <= Level(1)) {
-      // Level too low
-      return std::nullopt;
+  auto dense_index = [&dense_indices](const auto& node) {
+    return dense_indices.at(node.get());
+  };
+  for (int idx : Estd::indices(nodes_.size())) {
+    const auto& node = *nodes_.at(idx);
+    parents_.push_back(Estd::set_to_vector(
+        Estd::transform(Estd::vector_to_set(node.Parents()), dense_index)));
+    children_.push_back(
+        Estd::set_to_vector(Estd::transform(node.Children(), dense_index)));
+    levels_.push_back(node.Value().Level().value());
+    const auto& t_op = node.Value().GetTOp();
+    is_bootstrap_.push_back(dynamic_cast<const TBootstrapC*>(&t_op));
+    is_rescale_.push_back(dynamic_cast<const TRescaleC*>(&t_op));
+    if (is_bootstrap_.back()) {
+      bootstraps_.push_back(idx);
     }
-    return LevelInfo{node_t.Parents().at(0)->Value().Level() - Level(1),
-                     node.LogScale()};
   }
-  int min_level = Estd::min_element(Estd::transform(
-      node_t.Parents(),
-      [](const auto& parent) { return parent->Value().Level().value(); }));
-  return LevelInfo{min_level, node.LogScale()};
-}
-
-bool EnoughLevels(Node<LeveledTOp>& node) {
-  return NodeLevelInfo(node).has_value();
-}
-
-void UpdateLevelInfo(Node<LeveledTOp>& node) {
-  CHECK(NodeLevelInfo(node).has_value());
-  auto new_level_info = NodeLevelInfo(node).value();
-  node.SetValue(std::make_unique<LeveledTOp>(node.Value().GetTOp().CloneUniq(),
-                                             new_level_info));
 }
 
-bool IsMappedLevelEqual(HypotheticalDag<LeveledTOp>& hypothetical_dag,
-                        Node<LeveledTOp>& node) {
-  return node.Value().Level() ==
-         hypothetical_dag.Mapping(node)->Value().Level();
-}
-
-template <typename T>
-class DfsWalker {
- public:
-  explicit DfsWalker(const std::vector<std::shared_ptr<Node<T>>>& dfs_frontier,
-                     const std::function<bool(Node<T>&)>& should_add_children)
-      : dfs_frontier_(dfs_frontier),
-        should_add_children_(should_add_children) {}
-
-  std::shared_ptr<Node<T>> Begin() {
-    if (dfs_frontier_.empty()) {
-      return std::shared_ptr<Node<T>>{};
+PruneEvaluation PruningState::Evaluate(int bootstrap) const {
+  CHECK(is_bootstrap_.at(bootstrap));
+  CHECK(parents_.at(bootstrap).size() == 1);
+  int parent = parents_.at(bootstrap).at(0);
+  PruneEvaluation evaluation{bootstrap, true, {}, {bootstrap, parent}};
+  auto level = [&evaluation, this](int idx) {
+    auto it = evaluation.new_levels.find(idx);
+    return it == evaluation.new_levels.end() ? levels_.at(idx) : it->second;
+  };
+
+  // Smallest dense index first, so every node is leveled once, after all of
+  // its parents
+  std::priority_queue<int, std::vector<int>, std::greater<>> pending;
+  std::unordered_set<int> queued;
+  auto enqueue_children = [&](int idx) {
+    for (int child : children_.at(idx)) {
+      if (queued.insert(child).second) {
+        pending.push(child);
+      }
     }
-    return dfs_frontier_.back();
-  }
-
-  std::shared_ptr<Node<T>> Next();
-
- private:
-  std::vector<std::shared_ptr<Node<T>>> dfs_frontier_;
-  std::function<bool(Node<T>&)> should_add_children_;
-};
-
-template <typename T>
-std::shared_ptr<Node<T>> DfsWalker<T>::Next() {
-  CHECK(!dfs_frontier_.empty());
-
-  auto prev_node = dfs_frontier_.back();
-  dfs_frontier_.pop_back();
-
-  if (should_add_children_(*prev_node)) {
-    for (const auto& child : prev_node->Children()) {
-      dfs_frontier_.push_back(child);
+  };
+
+  // Assume bootstrap doesn't exist by giving it its parent's level
+  evaluation.new_levels.emplace(bootstrap, levels_.at(parent));
+  enqueue_children(bootstrap);
+  while (!pending.empty()) {
+    int idx = pending.top();
+    pending.pop();
+    evaluation.read.push_back(idx);
+    Estd::append(evaluation.read, parents_.at(idx));
+    if (is_bootstrap_.at(idx)) {
+      continue;
+    }
+    int new_level = 0;
+    if (is_rescale_.at(idx)) {
+      int parent_level = level(parents_.at(idx).at(0));
+      if (parent_level <= 1) {
+        // Level too low
+        evaluation.enough_levels = false;
+        return evaluation;
+      }
+      new_level = parent_level - 1;
+    } else {
+      new_level =
+          Estd::min_element(Estd::transform(parents_.at(idx), level));
+    }
+    if (new_level != levels_.at(idx)) {
+      evaluation.new_levels.emplace(idx, new_level);
+      enqueue_children(idx);
     }
   }
-
-  return dfs_frontier_.empty() ? std::shared_ptr<Node<T>>{}
-                               : dfs_frontier_.back();
+  return evaluation;
 }
 
-void PruneBootstrapNode(
-    const std::shared_ptr<Node<LeveledTOp>>& bootstrap_node) {
-  CHECK(dynamic_cast<const TBootstrapC*>(&bootstrap_node->Value().GetTOp()));
-
-  HypotheticalDag<LeveledTOp> dag_if_prunned;
-  // Assume bootstrap doesn't exist by assigning its parent's LevelInfo to it
-  dag_if_prunned.AddMapping(*bootstrap_node,
-                            CloneUniqWithSameAncestors(*bootstrap_node));
-  dag_if_prunned.Mapping(*bootstrap_node)
-      ->Value()
-      .SetLevelInfo(bootstrap_node->Parents().at(0)->Value().GetLevelInfo());
-
-  DfsWalker<LeveledTOp> dfs(
-      {bootstrap_node},
-      [&dag_if_prunned, &bootstrap_node](Node<LeveledTOp>& node) {
-        return &node == bootstrap_node.get() ||
-               !IsMappedLevelEqual(dag_if_prunned, node);
-      });
-
-  for (auto node = dfs.Begin(); node != nullptr; node = dfs.Next()) {
-    auto mapped_node = dag_if_prunned.MappingCreateIfNeeded(*node);
-    if (!EnoughLevels(*mapped_node)) {
-      // Cannot prune;
-      return;
+std::vector<int> PruningState::Prune(const PruneEvaluation& evaluation) {
+  CHECK(evaluation.enough_levels);
+  int bootstrap = evaluation.bootstrap;
+  int parent = parents_.at(bootstrap).at(0);
+  auto changed = Estd::set_to_vector(Estd::extract_keys(evaluation.new_levels));
+  changed.push_back(parent);
+  Estd::append(changed, children_.at(bootstrap));
+
+  for (const auto& [idx, level] : evaluation.new_levels) {
+    if (idx != bootstrap) {
+      levels_.at(idx) = level;
+      auto& t_op = nodes_.at(idx)->Value();
+      t_op.SetLevelInfo(LevelInfo{level, t_op.LogScale()});
     }
-    UpdateLevelInfo(*mapped_node);
   }
 
-  // Prune
-  dag_if_prunned.RemoveMapping(bootstrap_node);
-  RemoveNode(*bootstrap_node);
-  dag_if_prunned.Commit();
-}
-
-void PruneRedundantBootstraps(
-    const std::vector<std::shared_ptr<Node<LeveledTOp>>>& bootstrapped_nodes) {
-  // Prune shortcuts first
-  for (const auto& boot_node : bootstrapped_nodes) {
-    if (dynamic_cast<const TBootstrapC*>(&boot_node->Value().GetTOp())
-            ->IsShortcut()
-            .has_value() &&
-        dynamic_cast<const TBootstrapC*>(&boot_node->Value().GetTOp())
-            ->IsShortcut()
-            .value()) {
-      PruneBootstrapNode(boot_node);
+  RemoveNode(*nodes_.at(bootstrap));
+  auto& siblings = children_.at(parent);
+  siblings.erase(std::find(siblings.begin(), siblings.end(), bootstrap));
+  for (int child : children_.at(bootstrap)) {
+    if (!Estd::contains(siblings, child)) {
+      siblings.push_back(child);
     }
-  }
-  // Prune non-shortcuts second
-  for (const auto& boot_node : bootstrapped_nodes) {
-    if (dynamic_cast<const TBootstrapC*>(&boot_node->Value().GetTOp())
-            ->IsShortcut()
-            .has_value() &&
-        !dynamic_cast<const TBootstrapC*>(&boot_node->Value().GetTOp())
-             ->IsShortcut()
-             .value()) {
-      PruneBootstrapNode(boot_node);
+    auto& child_parents = parents_.at(child);
+    child_parents.erase(
+        std::find(child_parents.begin(), child_parents.end(), bootstrap));
+    if (!Estd::contains(child_parents, parent)) {
+      child_parents.push_back(parent);
     }
   }
+  parents_.at(bootstrap).clear();
+  children_.at(bootstrap).clear();
+  is_bootstrap_.at(bootstrap) = false;
+  return changed;
+}
 
-  // Prune everything else
-  for (const auto& boot_node : bootstrapped_nodes) {
-    if (!dynamic_cast<const TBootstrapC*>(&boot_node->Value().GetTOp())
-             ->IsShortcut()
-             .has_value()) {
-      PruneBootstrapNode(boot_node);
+// Prunes `candidates` in order as if one at a time
+void PruneInOrder(PruningState& state, const std::vector<int>& candidates,
+                  int thread_count) {
+  int batch_size = thread_count == 1 ? 1 : kCandidatesPerThread * thread_count;
+  for (int begin = 0; begin < static_cast<int>(candidates.size());
+       begin += batch_size) {
+    int end = std::min<int>(begin + batch_size, candidates.size());
+    std::vector<PruneEvaluation> evaluations(end - begin);
+    ParallelFor(end - begin, thread_count, [&](int idx) {
+      evaluations.at(idx) = state.Evaluate(candidates.at(begin + idx));
+    });
+    std::unordered_set<int> changed;
+    for (auto& evaluation : evaluations) {
+      if (Estd::any_of(evaluation.read,
+                       [&changed](int idx) { return changed.contains(idx); })) {
+        evaluation = state.Evaluate(evaluation.bootstrap);
+      }
+      if (evaluation.enough_levels) {
+        for (int idx : state.Prune(evaluation)) {
+          changed.insert(idx);
+        }
+      }
     }
   }
 }
 
+void PruneRedundantBootstraps(PruningState& state, int thread_count) {
+  // Prune shortcuts first, non-shortcuts second, and everything else last
+  for (std::optional<bool> is_shortcut :
+       {std::optional<bool>(true), std::optional<bool>(false),
+        std::optional<bool>()}) {
+    PruneInOrder(state,
+                 Estd::filter(state.Bootstraps(),
+                              [&state, is_shortcut](int idx) {
+                                return state.GetTBootstrapC(idx).IsShortcut() ==
+                                       is_shortcut;
+                              }),
+                 thread_count);
+  }
+}
+
 }  // namespace
 
+BootstrapPrunningPass::BootstrapPrunningPass(const ProgramContext& context,
+                                             int thread_count)
+    : context_(context), thread_count_(thread_count) {
+  CHECK(thread_count_ > 0);
+}
+
 LevelingOptimizerOutput BootstrapPrunningPass::DoPass(
     const LevelingOptimizerInput& in_dag) {
   auto out_dag = CloneFromAncestor(in_dag);
-  PruneRedundantBootstraps(
-      CollectNodesByTypeInTopologicalOrder<LeveledTOp, TBootstrapC>(out_dag));
+  PruningState state(out_dag);
+  PruneRedundantBootstraps(state, thread_count_);
 
   return out_dag;
 }
@@ -18,43 +18,118 @@
 
 #include "include/chunk_ir.h"
 
+#include <utility>
+
 #include "include/plaintext_chunk.h"
 
 namespace fhelipe {
 
+DirectChunkIr::DirectChunkIr(const std::vector<PtVal>& values)
+    : size_(values.size()), words_(WordCount(values.size()), 0) {
+  for (int idx = 0; idx < values.size(); ++idx) {
+    if (values[idx] != 0) {
+      CHECK(values[idx] == 1);
+      words_[idx / kWordBits] |= uint64_t{1} << (idx % kWordBits);
+    }
+  }
+}
+
+DirectChunkIr::DirectChunkIr(int size, std::vector<uint64_t>&& words)
+    : size_(size), words_(std::move(words)) {
+  CHECK(words_.size() == WordCount(size_));
+}
+
 PtChunk DirectChunkIr::Resolve(
     const Dictionary<Tensor<PtVal>>& frontend_tensors) const {
   (void)frontend_tensors;
-  return PtChunk(values_);
+  std::vector<PtVal> values(size_, 0);
+  for (int word_idx = 0; word_idx < words_.size(); ++word_idx) {
+    for (uint64_t word = words_[word_idx]; word; word &= word - 1) {
+      values[word_idx * kWordBits + __builtin_ctzll(word)] = 1;
+    }
+  }
+  return PtChunk(values);
+}
+
+IndirectChunkIr::IndirectChunkIr(const std::string& frontend_tensor_name,
+                                 const std::vector<std::optional<int>>& vec)
+    : frontend_tensor_name_(frontend_tensor_name), size_(vec.size()) {
+  int slot = 0;
+  while (slot < size_) {
+    if (!vec[slot].has_value()) {
+      ++slot;
+      continue;
+    }
+    IndexRun run{slot, 1, vec[slot].value(), 1};
+    if (slot + 1 < size_ && vec[slot + 1].has_value()) {
+      run.stride = vec[slot + 1].value() - run.flat;
+    }
+    while (slot + run.length < size_ &&
+           vec[slot + run.length] == run.flat + run.length * run.stride) {
+      ++run.length;
+    }
+    runs_.push_back(run);
+    slot += run.length;
+  }
+}
+
+IndirectChunkIr::IndirectChunkIr(const std::string& frontend_tensor_name,
+                                 int size, std::vector<IndexRun>&& runs)
+    : frontend_tensor_name_(frontend_tensor_name),
+      size_(size),
+      runs_(std::move(runs)) {
+  for (const auto& run : runs_) {
+    CHECK(run.slot >= 0 && run.length > 0 && run.slot + run.length <= size_);
+  }
+}
+
+std::vector<std::optional<int>> IndirectChunkIr::FlatIndices() const {
+  std::vector<std::optional<int>> result(size_);
+  for (const auto& run : runs_) {
+    for (int idx = 0; idx < run.length; ++idx) {
+      result[run.slot + idx] = run.flat + idx * run.stride;
+    }
+  }
+  return result;
 }
 
 PtChunk IndirectChunkIr::Resolve(
     const Dictionary<Tensor<PtVal>>& frontend_tensors) const {
-  auto frontend_tensor = frontend_tensors.At(frontend_tensor_name_);
-  std::vector<PtVal> result;
-  for (const auto& flat_idx : flat_indices_) {
-    if (flat_idx.has_value()) {
-      result.push_back(frontend_tensor[TensorIndex(frontend_tensor.GetShape(),
-                                                   flat_idx.value())]);
-    } else {
-      result.push_back(0);
+  const auto values = frontend_tensors.At(frontend_tensor_name_).Values();
+  std::vector<PtVal> result(size_, 0);
+  for (const auto& run : runs_) {
+    CHECK(run.flat >= 0 && run.flat < values.size());
+    CHECK(run.flat + (run.length - 1) * run.stride >= 0 &&
+          run.flat + (run.length - 1) * run.stride < values.size());
+    const PtVal* src = values.data() + run.flat;
+    PtVal* dest = result.data() + run.slot;
+    for (int idx = 0; idx < run.length; ++idx) {
+      dest[idx] = src[idx * run.stride];
     }
   }
   return PtChunk(result);
 }
 
+// Masks are written as the lengths of alternating runs of zeros and ones,
+// starting with a (possibly empty) run of zeros
 template <>
 void WriteStream<DirectChunkIr>(std::ostream& stream, const DirectChunkIr& x) {
-  stream << kMaskChunkIrKeyword << " ";
-  stream << x.Values().size() << " ";
-  std::vector<int> results;
-  for (int idx = 0; idx < x.Values().size(); ++idx) {
-    if (x.Values()[idx] != 0) {
-      CHECK(x.Values()[idx] == 1);
-      results.push_back(idx);
+  stream << kMaskRunsChunkIrKeyword << " ";
+  stream << x.Size() << " ";
+  std::vector<int> runs;
+  bool run_value = false;
+  int run_start = 0;
+  for (int idx = 0; idx < x.Size(); ++idx) {
+    if (x.IsOne(idx) != run_value) {
+      runs.push_back(idx - run_start);
+      run_value = !run_value;
+      run_start = idx;
     }
   }
-  WriteStream(stream, results);
+  if (run_start < x.Size()) {
+    runs.push_back(x.Size() - run_start);
+  }
+  WriteStream(stream, runs);
 }
 
 void DirectChunkIr::WriteStreamHelper(std::ostream& stream) const {
@@ -64,19 +139,54 @@ void DirectChunkIr::WriteStreamHelper(std::ostream& stream) const {
 template <>
 DirectChunkIr ReadStream<DirectChunkIr>(std::istream& stream) {
   auto chunk_size = ReadStream<int>(stream);
-  std::vector<PtVal> values(chunk_size);
+  std::vector<uint64_t> words(DirectChunkIr::WordCount(chunk_size), 0);
+  auto runs = ReadStream<std::vector<int>>(stream);
+  int idx = 0;
+  for (int run_idx = 0; run_idx < runs.size(); ++run_idx) {
+    if (run_idx % 2 == 1) {
+      for (int one = idx; one < idx + runs[run_idx]; ++one) {
+        words.at(one / DirectChunkIr::kWordBits) |=
+            uint64_t{1} << (one % DirectChunkIr::kWordBits);
+      }
+    }
+    idx += runs[run_idx];
+  }
+  CHECK(idx == chunk_size);
+  return {chunk_size, std::move(words)};
+}
+
+namespace {
+
+// Format of kMaskChunkIrKeyword: the chunk size and the indices of all ones
+DirectChunkIr ReadLegacyMask(std::istream& stream) {
+  auto chunk_size = ReadStream<int>(stream);
+  std::vector<uint64_t> words(DirectChunkIr::WordCount(chunk_size), 0);
   auto ones = ReadStream<std::vector<int>>(stream);
   for (auto one : ones) {
-    values.at(one) = 1;
+    CHECK(one < chunk_size);
+    words.at(one / DirectChunkIr::kWordBits) |=
+        uint64_t{1} << (one % DirectChunkIr::kWordBits);
   }
-  return DirectChunkIr(values);
+  return {chunk_size, std::move(words)};
 }
 
+}  // namespace
+
+// Written as runs, unless the explicit index list is shorter
 template <>
 void WriteStream<IndirectChunkIr>(std::ostream& stream,
                                   const IndirectChunkIr& x) {
-  stream << kIndirectChunkIrKeyword << " " << x.FrontendTensorName() << " ";
-  WriteStream(stream, x.FlatIndices());
+  if (4 * x.Runs().size() >= x.Size()) {
+    stream << kIndirectChunkIrKeyword << " " << x.FrontendTensorName() << " ";
+    WriteStream(stream, x.FlatIndices());
+    return;
+  }
+  stream << kIndirectRunsChunkIrKeyword << " " << x.FrontendTensorName() << " ";
+  stream << x.Size() << " " << x.Runs().size() << " ";
+  for (const auto& run : x.Runs()) {
+    stream << run.slot << " " << run.length << " " << run.flat << " "
+           << run.stride << " ";
+  }
 }
 
 void IndirectChunkIr::WriteStreamHelper(std::ostream& stream) const {
@@ -85,11 +195,149 @@ void IndirectChunkIr::WriteStreamHelper(std::ostream& stream) const {
 
 template <>
 IndirectChunkIr ReadStream<IndirectChunkIr>(std::istream& stream) {
+  auto frontend_tensor_name = ReadStream<std::string>(stream);
+  auto size = ReadStream<int>(stream);
+  auto run_count = ReadStream<int>(stream);
+  std::vector<IndexRun> runs;
+  runs.reserve(run_count);
+  while (runs.size() < run_count) {
+    IndexRun run{};
+    run.slot = ReadStream<int>(stream);
+    run.length = ReadStream<int>(stream);
+    run.flat = ReadStream<int>(stream);
+    run.stride = ReadStream<int>(stream);
+    runs.push_back(run);
+  }
+  return {frontend_tensor_name, size, std::move(runs)};
+}
+
+namespace {
+
+// Format of kIndirectChunkIrKeyword: the tensor name and the flat index of
+// every slot
+IndirectChunkIr ReadExplicitIndirection(std::istream& stream) {
   auto frontend_tensor_name = ReadStream<std::string>(stream);
   auto vec = ReadStream<std::vector<std::optional<int>>>(stream);
   return {frontend_tensor_name, vec};
 }
 
+}  // namespace
+
+ProductChunkIr::ProductChunkIr(std::vector<IndirectChunkIr>&& factors,
+                               PtVal scalar)
+    : factors_(std::move(factors)), scalar_(scalar) {
+  CHECK(!factors_.empty());
+  for (const auto& factor : factors_) {
+    CHECK(factor.Size() == factors_[0].Size());
+  }
+}
+
+PtChunk ProductChunkIr::Resolve(
+    const Dictionary<Tensor<PtVal>>& frontend_tensors) const {
+  std::vector<PtVal> result(factors_[0].Size(), scalar_);
+  for (const auto& factor : factors_) {
+    const auto values =
+        frontend_tensors.At(factor.FrontendTensorName()).Values();
+    std::vector<bool> covered(result.size(), false);
+    for (const auto& run : factor.Runs()) {
+      for (int idx = 0; idx < run.length; ++idx) {
+        result[run.slot + idx] *= values.at(run.flat + idx * run.stride);
+        covered[run.slot + idx] = true;
+      }
+    }
+    for (int slot = 0; slot < result.size(); ++slot) {
+      if (!covered[slot]) {
+        result[slot] = 0;
+      }
+    }
+  }
+  return PtChunk(result);
+}
+
+// Written as the scalar and the number of factors, followed by the factors
+template <>
+void WriteStream<ProductChunkIr>(std::ostream& stream,
+                                 const ProductChunkIr& x) {
+  stream << kProductChunkIrKeyword << " ";
+  WriteStream<PtVal>(stream, x.Scalar());
+  stream << " " << x.Factors().size() << " ";
+  for (const auto& factor : x.Factors()) {
+    WriteStream<IndirectChunkIr>(stream, factor);
+    stream << " ";
+  }
+}
+
+void ProductChunkIr::WriteStreamHelper(std::ostream& stream) const {
+  WriteStream<ProductChunkIr>(stream, *this);
+}
+
+template <>
+ProductChunkIr ReadStream<ProductChunkIr>(std::istream& stream) {
+  auto scalar = ReadStream<PtVal>(stream);
+  auto factor_count = ReadStream<int>(stream);
+  std::vector<IndirectChunkIr> factors;
+  factors.reserve(factor_count);
+  while (factors.size() < factor_count) {
+    factors.push_back(std::get<IndirectChunkIr>(ReadStream<ChunkIr>(stream)));
+  }
+  return {std::move(factors), scalar};
+}
+
+SumChunkIr::SumChunkIr(const std::vector<ChunkIr>& terms) {
+  CHECK(!terms.empty());
+  for (const auto& term : terms) {
+    terms_.push_back(std::make_shared<const ChunkIr>(term));
+  }
+}
+
+PtChunk SumChunkIr::Resolve(
+    const Dictionary<Tensor<PtVal>>& frontend_tensors) const {
+  auto result = fhelipe::Resolve(*terms_[0], frontend_tensors).Values();
+  for (int term_idx = 1; term_idx < terms_.size(); ++term_idx) {
+    const auto values =
+        fhelipe::Resolve(*terms_[term_idx], frontend_tensors).Values();
+    CHECK(values.size() == result.size());
+    for (int idx = 0; idx < result.size(); ++idx) {
+      result[idx] += values[idx];
+    }
+  }
+  return PtChunk(result);
+}
+
+bool operator==(const SumChunkIr& lhs, const SumChunkIr& rhs) {
+  if (lhs.terms_.size() != rhs.terms_.size()) {
+    return false;
+  }
+  for (int idx = 0; idx < lhs.terms_.size(); ++idx) {
+    if (!(*lhs.terms_[idx] == *rhs.terms_[idx])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void SumChunkIr::WriteStreamHelper(std::ostream& stream) const {
+  stream << kSumChunkIrKeyword << " " << terms_.size() << " ";
+  for (const auto& term : terms_) {
+    WriteStream<ChunkIr>(stream, *term);
+    stream << " ";
+  }
+}
+
+namespace {
+
+SumChunkIr ReadSum(std::istream& stream) {
+  auto term_count = ReadStream<int>(stream);
+  std::vector<ChunkIr> terms;
+  terms.reserve(term_count);
+  while (terms.size() < term_count) {
+    terms.push_back(ReadStream<ChunkIr>(stream));
+  }
+  return SumChunkIr(terms);
+}
+
+}  // namespace
+
 template <>
 void WriteStream<ChunkIr>(std::ostream& stream, const ChunkIr& chunk) {
   std::visit([&](const auto& x) { x.WriteStreamHelper(stream); }, chunk);
@@ -98,12 +346,24 @@ void WriteStream<ChunkIr>(std::ostream& stream, const ChunkIr& chunk) {
 template <>
 ChunkIr ReadStream<ChunkIr>(std::istream& stream) {
   auto tensor_type = ReadStream<std::string>(stream);
-  if (tensor_type == kIndirectChunkIrKeyword) {
+  if (tensor_type == kIndirectRunsChunkIrKeyword) {
     return ReadStream<IndirectChunkIr>(stream);
   }
-  if (tensor_type == kMaskChunkIrKeyword) {
+  if (tensor_type == kIndirectChunkIrKeyword) {
+    return ReadExplicitIndirection(stream);
+  }
+  if (tensor_type == kMaskRunsChunkIrKeyword) {
     return ReadStream<DirectChunkIr>(stream);
   }
+  if (tensor_type == kMaskChunkIrKeyword) {
+    return ReadLegacyMask(stream);
+  }
+  if (tensor_type == kProductChunkIrKeyword) {
+    return ReadStream<ProductChunkIr>(stream);
+  }
+  if (tensor_type == kSumChunkIrKeyword) {
+    return ReadSum(stream);
+  }
   LOG(FATAL) << "Invalid ChunkIr type " << tensor_type;
 }
 
@@ -114,3 +374,55 @@ PtChunk Resolve(const ChunkIr& chunk,
 }
 
 }  // namespace fhelipe
+
+namespace {
+
+std::size_t HashCombine(std::size_t seed, std::size_t value) {
+  return seed ^ (value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2));
+}
+
+}  // namespace
+
+namespace std {
+
+std::size_t hash<fhelipe::DirectChunkIr>::operator()(
+    const fhelipe::DirectChunkIr& chunk) const {
+  std::size_t result = hash<int>()(chunk.Size());
+  for (uint64_t word : chunk.Words()) {
+    result = HashCombine(result, hash<uint64_t>()(word));
+  }
+  return result;
+}
+
+std::size_t hash<fhelipe::IndirectChunkIr>::operator()(
+    const fhelipe::IndirectChunkIr& chunk) const {
+  std::size_t result = hash<std::string>()(chunk.FrontendTensorName());
+  result = HashCombine(result, hash<int>()(chunk.Size()));
+  for (const auto& run : chunk.Runs()) {
+    result = HashCombine(result, hash<int>()(run.slot));
+    result = HashCombine(result, hash<int>()(run.length));
+    result = HashCombine(result, hash<int>()(run.flat));
+    result = HashCombine(result, hash<int>()(run.stride));
+  }
+  return result;
+}
+
+std::size_t hash<fhelipe::ProductChunkIr>::operator()(
+    const fhelipe::ProductChunkIr& chunk) const {
+  std::size_t result = hash<fhelipe::PtVal>()(chunk.Scalar());
+  for (const auto& factor : chunk.Factors()) {
+    result = HashCombine(result, hash<fhelipe::IndirectChunkIr>()(factor));
+  }
+  return result;
+}
+
+std::size_t hash<fhelipe::SumChunkIr>::operator()(
+    const fhelipe::SumChunkIr& chunk) const {
+  std::size_t result = hash<std::size_t>()(chunk.Terms().size());
+  for (const auto& term : chunk.Terms()) {
+    result = HashCombine(result, hash<fhelipe::ChunkIr>()(*term));
+  }
+  return result;
+}
+
+}  // namespace std
@@ -54,6 +54,11 @@ Cleartext Cleartext::RescaleC(LogScale rescale_amount) const {
                     this->GetLevelInfo().LogScale() - rescale_amount}};
 }
 
+Cleartext Cleartext::DropLevelC(Level level) const {
+  CHECK(level <= this->GetLevelInfo().Level());
+  return {this->pt_chunk_, LevelInfo{level, this->GetLevelInfo().LogScale()}};
+}
+
 Cleartext Cleartext::MulCC(const Cleartext& rhs) const {
   return {
       Mul(pt_chunk_, rhs.pt_chunk_),
@@ -92,7 +97,8 @@ Cleartext Cleartext::AddCP(const ScaledPtChunk& pt_chunk) const {
 Cleartext Cleartext::AddCS(const ScaledPtVal& scalar) const {
   return {AddScalar(pt_chunk_, scalar.value()),
           LevelInfo{this->GetLevelInfo().Level(),
-                    this->GetLevelInfo().LogScale() + scalar.GetLogScale()}};
+                    LogScale(std::max(this->GetLevelInfo().LogScale().value(),
+                                      scalar.GetLogScale().value()))}};
 }
 
 Cleartext Cleartext::RotateC(int rotate_by) const {
@@ -0,0 +1,101 @@
+/** $lic$
+ * Copyright (C) 2023-2024 by Massachusetts Institute of Technology
+ *
+ * This file is part of the Fhelipe compiler.
+ *
+ * Fhelipe is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * Fhelipe is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>. 
+ */
+
+#include "include/compile_cache.h"
+
+#include <unistd.h>
+
+#include <system_error>
+#include <unordered_map>
+
+#include "include/constants.h"
+#include "include/dictionary_impl.h"
+#include "include/glog_flag_avoid_writes.h"
+#include "include/persisted_dictionary.h"
+
+namespace fhelipe {
+
+namespace {
+
+const std::string kCachedContext = "context";
+
+}  // namespace
+
+std::filesystem::path CompileCache::BeginEntry(const std::string& key) const {
+  auto scratch_path =
+      folder_path_ / (key + ".tmp" + std::to_string(getpid()));
+  EnsureDoesNotExist(scratch_path);
+  EnsureDirectoryExists(scratch_path);
+  return scratch_path;
+}
+
+void CompileCache::CommitEntry(
+    const std::string& key, const std::filesystem::path& scratch_path) const {
+  std::error_code error_code;
+  std::filesystem::rename(scratch_path, EntryPath(key), error_code);
+  if (error_code) {
+    // Somebody else committed the same entry first
+    CHECK(Exists(EntryPath(key))) << error_code;
+    EnsureDoesNotExist(scratch_path);
+  }
+}
+
+template <>
+std::optional<ct_program::CtProgram> CompileCache::Fetch(
+    const std::string& key, const std::filesystem::path& exe_folder) const {
+  if (!Exists(EntryPath(key))) {
+    return std::nullopt;
+  }
+  ct_program::CtProgram chunks(
+      ReadFile<ProgramContext>(EntryPath(key) / kCachedContext),
+      std::make_unique<PersistedDictionary<ChunkIr>>(exe_folder / kChIr),
+      Dag<CtOp>());
+  // The cached keys were minted by another process and may clash with keys
+  // minted by this one, so every chunk is recorded anew
+  std::unordered_map<KeyType, KeyType> chunk_keys;
+  auto cached_chunks = PersistedDictionary<ChunkIr>(EntryPath(key) / kChIr);
+  for (const auto& chunk_key : cached_chunks.Keys()) {
+    chunk_keys.emplace(chunk_key,
+                       chunks.RecordChunk(cached_chunks.At(chunk_key)));
+  }
+  auto dag = ReadFile<Dag<CtOp>>(EntryPath(key) / kCachedDag);
+  for (const auto& node : dag.NodesInTopologicalOrder()) {
+    node->SetValue(ct_program::WithChunkKeys(node->Value(), chunk_keys));
+  }
+  return chunks.WithDag(std::move(dag));
+}
+
+template <>
+void CompileCache::Store(const std::string& key,
+                         const ct_program::CtProgram& value) const {
+  // Nothing is written under --avoid_writes, not even the cache
+  if (AvoidWrites() || Exists(EntryPath(key))) {
+    return;
+  }
+  auto scratch_path = BeginEntry(key);
+  WriteFile(scratch_path / kCachedContext, value.GetProgramContext());
+  WriteFile(scratch_path / kCachedDag, value.GetDag());
+  auto cached_chunks = PersistedDictionary<ChunkIr>(scratch_path / kChIr);
+  const auto& chunk_dict = *value.ChunkDictionary();
+  for (const auto& chunk_key : chunk_dict.Keys()) {
+    cached_chunks.Record(chunk_key, value.GetChunkIr(chunk_key));
+  }
+  CommitEntry(key, scratch_path);
+}
+
+}  // namespace fhelipe
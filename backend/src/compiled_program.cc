@@ -31,13 +31,15 @@ CompiledProgram::CompiledProgram(
     std::pair<PassId, RescalingPassOutput>&& rescaling_pass_dag,
     std::vector<std::pair<PassId, LevelingPassOutput>>&&
         leveling_optimizer_dags,
-    std::vector<std::pair<PassId, CtOpOptimizerOutput>>&& ct_op_optimizer_dags)
+    std::vector<std::pair<PassId, CtOpOptimizerOutput>>&& ct_op_optimizer_dags,
+    std::vector<PassStats>&& pass_stats)
     : program_(program),
       input_dag_(std::move(input_dag)),
       layout_optimizer_dags_(std::move(layout_optimizer_dags)),
       rescaling_pass_dag_(std::move(rescaling_pass_dag)),
       leveling_optimizer_dags_(std::move(leveling_optimizer_dags)),
-      ct_op_optimizer_dags_(std::move(ct_op_optimizer_dags)) {
+      ct_op_optimizer_dags_(std::move(ct_op_optimizer_dags)),
+      pass_stats_(std::move(pass_stats)) {
   archives_.emplace_back(input_dag_.first,
                          DagToDebugInfoArchive(input_dag_.second));
   for (const auto& optimizer : layout_optimizer_dags_) {
@@ -120,6 +122,11 @@ void WriteStreamFriend(std::ostream& stream, const CompiledProgram& cp) {
   for (const auto& [pass_id, dag] : cp.ct_op_optimizer_dags_) {
     WriteFile(exe_folder / ToString(pass_id), dag);
   }
+
+  if (!cp.pass_stats_.empty()) {
+    auto stats_stream = OpenStream<std::ofstream>(exe_folder / kCompileStats);
+    WriteCompileStatsJson(stats_stream, cp.pass_stats_);
+  }
 }
 
 std::string PaddedIntString(int value) {
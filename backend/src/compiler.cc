@@ -33,7 +33,8 @@ Compiler::Compiler(OwningVector<Preprocessor>&& preprocessors,
                    std::unique_ptr<LevelingPass>&& leveling_pass,
                    OwningVector<LevelingOptimizer>&& leveling_optimizers,
                    std::unique_ptr<CtOpPass>&& ct_op_pass,
-                   OwningVector<CtOpOptimizer>&& ct_op_optimizers)
+                   OwningVector<CtOpOptimizer>&& ct_op_optimizers,
+                   std::optional<CompileCache>&& cache)
     : preprocessors_(std::move(preprocessors)),
       parser_(std::move(parser)),
       embrio_optimizers_(std::move(embrio_optimizers)),
@@ -43,7 +44,8 @@ Compiler::Compiler(OwningVector<Preprocessor>&& preprocessors,
       leveling_pass_(std::move(leveling_pass)),
       leveling_optimizers_(std::move(leveling_optimizers)),
       ct_op_pass_(std::move(ct_op_pass)),
-      ct_op_optimizers_(std::move(ct_op_optimizers)) {}
+      ct_op_optimizers_(std::move(ct_op_optimizers)),
+      cache_(std::move(cache)) {}
 
 CompiledProgram Compiler::Compile(const Program& program) {
   CompiledProgramBuilder builder(this, program);
@@ -52,21 +54,26 @@ CompiledProgram Compiler::Compile(const Program& program) {
 
   for (auto& preprocessor : preprocessors_) {
     code = preprocessor->DoPass(code);
+    builder.RecordPassStats(preprocessor->GetPassName());
   }
 
-  ParserOutput dag = parser_->DoPass(code);
+  CacheState cache_state{program.ExeFolder(), CompileCache::ProgramKey(code),
+                         true};
+
+  ParserOutput dag = RunPass(*parser_, code, cache_state);
   ParserOutput* dag_ptr =
       builder.RecordPass(parser_->GetPassName(), std::move(dag));
-
+  // Only the optimized DAG is kept, under the name of the parser
   for (auto& embrio_optimizer : embrio_optimizers_) {
-    *dag_ptr = embrio_optimizer->DoPass(*dag_ptr);
+    *dag_ptr = RunPass(*embrio_optimizer, *dag_ptr, cache_state);
+    builder.RecordPassStats(embrio_optimizer->GetPassName(), *dag_ptr);
   }
 
-  LayoutPassOutput laid_out_dag = layout_pass_->DoPass(*dag_ptr);
+  LayoutPassOutput laid_out_dag = RunPass(*layout_pass_, *dag_ptr, cache_state);
   LayoutPassOutput* laid_out_dag_ptr =
       builder.RecordPass(layout_pass_->GetPassName(), std::move(laid_out_dag));
   for (auto& layout_optimizer : layout_optimizers_) {
-    laid_out_dag = layout_optimizer->DoPass(*laid_out_dag_ptr);
+    laid_out_dag = RunPass(*layout_optimizer, *laid_out_dag_ptr, cache_state);
     laid_out_dag_ptr = builder.RecordPass(layout_optimizer->GetPassName(),
                                           std::move(laid_out_dag));
   }
@@ -75,25 +82,29 @@ CompiledProgram Compiler::Compile(const Program& program) {
   auto config_dict = ClearedPersistedDictionary<EncryptionConfig>(
       program.ExeFolder() / kEncCfg);
   AddEncryptionConfigs(config_dict, *laid_out_dag_ptr);
+  builder.StartPass();
 
-  RescalingPassOutput rescaled_dag = rescaling_pass_->DoPass(*laid_out_dag_ptr);
+  RescalingPassOutput rescaled_dag =
+      RunPass(*rescaling_pass_, *laid_out_dag_ptr, cache_state);
   RescalingPassOutput* rescaled_dag_ptr = builder.RecordPass(
       rescaling_pass_->GetPassName(), std::move(rescaled_dag));
 
-  LevelingPassOutput leveled_dag = leveling_pass_->DoPass(*rescaled_dag_ptr);
+  LevelingPassOutput leveled_dag =
+      RunPass(*leveling_pass_, *rescaled_dag_ptr, cache_state);
   LevelingPassOutput* leveled_dag_ptr =
       builder.RecordPass(leveling_pass_->GetPassName(), std::move(leveled_dag));
   for (auto& leveling_optimizer : leveling_optimizers_) {
-    leveled_dag = leveling_optimizer->DoPass(*leveled_dag_ptr);
+    leveled_dag = RunPass(*leveling_optimizer, *leveled_dag_ptr, cache_state);
     leveled_dag_ptr = builder.RecordPass(leveling_optimizer->GetPassName(),
                                          std::move(leveled_dag));
   }
 
-  CtOpPassOutput ct_op_dag = ct_op_pass_->DoPass(*leveled_dag_ptr);
+  CtOpPassOutput ct_op_dag =
+      RunPass(*ct_op_pass_, *leveled_dag_ptr, cache_state);
   CtOpPassOutput* ct_op_dag_ptr =
       builder.RecordPass(ct_op_pass_->GetPassName(), std::move(ct_op_dag));
   for (auto& ct_op_optimizer : ct_op_optimizers_) {
-    ct_op_dag = ct_op_optimizer->DoPass(*ct_op_dag_ptr);
+    ct_op_dag = RunPass(*ct_op_optimizer, *ct_op_dag_ptr, cache_state);
     ct_op_dag_ptr = builder.RecordPass(ct_op_optimizer->GetPassName(),
                                        std::move(ct_op_dag));
   }
@@ -106,7 +117,8 @@ Compiler CompilerBuilder::GetCompiler() {
           std::move(embrio_optimizers_), std::move(layout_pass_),
           std::move(layout_optimizers_), std::move(rescaling_pass_),
           std::move(leveling_pass_),     std::move(leveling_optimizers_),
-          std::move(ct_op_pass_),        std::move(ct_op_optimizers_)};
+          std::move(ct_op_pass_),        std::move(ct_op_optimizers_),
+          std::move(cache_)};
 }
 
 }  // namespace fhelipe
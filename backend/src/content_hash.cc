@@ -0,0 +1,50 @@
+/** $lic$
+ * Copyright (C) 2023-2024 by Massachusetts Institute of Technology
+ *
+ * This file is part of the Fhelipe compiler.
+ *
+ * Fhelipe is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * Fhelipe is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>. 
+ */
+
+#include "include/content_hash.h"
+
+#include <cstdint>
+#include <iomanip>
+#include <sstream>
+
+namespace fhelipe {
+
+namespace {
+
+// 64-bit FNV-1a
+uint64_t Fnv1a(const std::string& content, uint64_t offset_basis) {
+  uint64_t hash = offset_basis;
+  for (unsigned char c : content) {
+    hash ^= c;
+    hash *= 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+}  // namespace
+
+std::string ContentHash(const std::string& content) {
+  // Two independent 64-bit hashes to make accidental collisions negligible
+  std::stringstream ss;
+  ss << std::hex << std::setfill('0') << std::setw(16)
+     << Fnv1a(content, 0xcbf29ce484222325ULL) << std::setw(16)
+     << Fnv1a(content, 0x84222325cbf29ce4ULL);
+  return ss.str();
+}
+
+}  // namespace fhelipe
@@ -0,0 +1,228 @@
+/** $lic$
+ * Copyright (C) 2023-2024 by Massachusetts Institute of Technology
+ *
+ * This file is part of the Fhelipe compiler.
+ *
+ * Fhelipe is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * Fhelipe is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>. 
+ */
+
+#include "include/conv_fusion_pass.h"
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "include/array.h"
+#include "include/extended_std.h"
+#include "include/node.h"
+#include "include/t_add_cc.h"
+#include "include/t_conv_c.h"
+#include "include/t_insert_dim_c.h"
+#include "include/t_mul_cp.h"
+#include "include/t_op_utils.h"
+#include "include/t_replicate_dim_c.h"
+#include "include/t_resize_dim_c.h"
+#include "include/t_unpadded_shift_c.h"
+#include "include/tensor_index.h"
+
+namespace fhelipe {
+
+namespace {
+
+using TOpNode = std::shared_ptr<Node<TOp>>;
+
+// One term W * suffix(shift(base)) of a convolution's tap sum, e.g.,
+// weights[:, :, i, j] * image.shift(i).shift(j).replicate(0, k)
+struct ConvTap {
+  TOpNode base;
+  // Shift in the dimensions of base
+  std::vector<int> shift;
+  // Broadcasting TOps applied after the shifts
+  std::vector<TOpNode> suffix;
+  std::string pt_tensor_name;
+  LogScale pt_log_scale;
+};
+
+bool IsBroadcast(const TOp& t_op) {
+  return dynamic_cast<const TInsertDimC*>(&t_op) ||
+         dynamic_cast<const TResizeDimC*>(&t_op) ||
+         dynamic_cast<const TReplicateDimC*>(&t_op);
+}
+
+// Two unpadded shifts compose into one only if they move different dimensions
+bool ComposeShift(std::vector<int>& shift, const DiffTensorIndex& diff) {
+  for (int dim : Estd::indices(shift.size())) {
+    if (shift[dim] != 0 && diff[dim] != 0) {
+      return false;
+    }
+    shift[dim] += diff[dim];
+  }
+  return true;
+}
+
+std::optional<ConvTap> AsConvTap(const TOpNode& term) {
+  const auto* t_mul_cp = dynamic_cast<const TMulCP*>(&term->Value());
+  if (!t_mul_cp || term->Children().size() != 1) {
+    return std::nullopt;
+  }
+  ConvTap tap{nullptr, {}, {}, t_mul_cp->PtTensorName(),
+              t_mul_cp->PtTensorLogScale()};
+  auto node = term->Parents().at(0);
+  while (IsBroadcast(node->Value())) {
+    tap.suffix.insert(tap.suffix.begin(), node);
+    node = node->Parents().at(0);
+  }
+  tap.shift.resize(node->Value().OutputLayout().GetShape().DimensionCount());
+  while (const auto* t_unpadded_shift_c =
+             dynamic_cast<const TUnpaddedShiftC*>(&node->Value())) {
+    if (!ComposeShift(tap.shift, t_unpadded_shift_c->RotateBy())) {
+      return std::nullopt;
+    }
+    node = node->Parents().at(0);
+  }
+  tap.base = node;
+  return tap;
+}
+
+// The tap's shift moved past its broadcasts, which is exact as long as they
+// only touch dimensions that the shift leaves in place
+std::optional<DiffTensorIndex> OutputShift(const ConvTap& tap,
+                                           const Shape& output_shape) {
+  auto shift = tap.shift;
+  for (const auto& node : tap.suffix) {
+    const auto& t_op = node->Value();
+    if (const auto* t_insert_dim_c = dynamic_cast<const TInsertDimC*>(&t_op)) {
+      shift.insert(shift.begin() + t_insert_dim_c->DimensionToInsert(), 0);
+    } else if (const auto* t_resize_dim_c =
+                   dynamic_cast<const TResizeDimC*>(&t_op)) {
+      const auto& in_shape = t_resize_dim_c->InputLayout().GetShape();
+      const auto& out_shape = t_resize_dim_c->OutputLayout().GetShape();
+      for (int dim : Estd::indices(shift.size())) {
+        if (in_shape[dim] != out_shape[dim] && shift[dim] != 0) {
+          return std::nullopt;
+        }
+      }
+    } else if (const auto* t_replicate_dim_c =
+                   dynamic_cast<const TReplicateDimC*>(&t_op)) {
+      if (shift[t_replicate_dim_c->DimensionToReplicate()] != 0) {
+        return std::nullopt;
+      }
+    }
+  }
+  return DiffTensorIndex(output_shape, Array(shift));
+}
+
+bool SameSuffix(const ConvTap& lhs, const ConvTap& rhs) {
+  if (lhs.suffix.size() != rhs.suffix.size()) {
+    return false;
+  }
+  for (int idx : Estd::indices(lhs.suffix.size())) {
+    if (!(lhs.suffix[idx]->Value() == rhs.suffix[idx]->Value())) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool IsSumRoot(const Node<TOp>& node) {
+  if (!dynamic_cast<const TAddCC*>(&node.Value())) {
+    return false;
+  }
+  return node.Children().size() != 1 ||
+         !dynamic_cast<const TAddCC*>(&(*node.Children().begin())->Value());
+}
+
+// Terms of the TAddCC tree rooted at `root`; an inner TAddCC only feeds the
+// tree
+std::vector<TOpNode> SumTerms(const TOpNode& root) {
+  std::vector<TOpNode> terms;
+  std::vector<TOpNode> stack{root};
+  while (!stack.empty()) {
+    auto node = stack.back();
+    stack.pop_back();
+    for (const auto& parent : node->Parents()) {
+      if (dynamic_cast<const TAddCC*>(&parent->Value()) &&
+          parent->Children().size() == 1) {
+        stack.push_back(parent);
+      } else {
+        terms.push_back(parent);
+      }
+    }
+  }
+  return terms;
+}
+
+std::optional<std::vector<ConvTap>> AsConvTaps(const TOpNode& root) {
+  auto terms = SumTerms(root);
+  if (terms.size() < 2) {
+    return std::nullopt;
+  }
+  std::vector<ConvTap> taps;
+  for (const auto& term : terms) {
+    auto tap = AsConvTap(term);
+    if (!tap.has_value() || (!taps.empty() && (tap->base != taps[0].base ||
+                                               !SameSuffix(*tap, taps[0]) ||
+                                               tap->pt_log_scale !=
+                                                   taps[0].pt_log_scale))) {
+      return std::nullopt;
+    }
+    taps.push_back(tap.value());
+  }
+  return taps;
+}
+
+}  // namespace
+
+LayoutOptimizerOutput ConvFusionPass::DoPass(
+    const LayoutOptimizerInput& in_dag) {
+  Dag<TOp> out_dag = CloneFromAncestor(in_dag);
+
+  auto roots = Estd::filter(out_dag.NodesInTopologicalOrder(),
+                            [](const auto& node) { return IsSumRoot(*node); });
+  for (const auto& root : roots) {
+    auto taps = AsConvTaps(root);
+    if (!taps.has_value()) {
+      continue;
+    }
+    const auto& layout = root->Value().OutputLayout();
+    std::vector<DiffTensorIndex> shifts;
+    for (const auto& tap : taps.value()) {
+      auto shift = OutputShift(tap, layout.GetShape());
+      if (!shift.has_value()) {
+        break;
+      }
+      shifts.push_back(shift.value());
+    }
+    if (shifts.size() != taps->size()) {
+      continue;
+    }
+
+    auto node = taps->at(0).base;
+    for (const auto& broadcast : taps->at(0).suffix) {
+      node = out_dag.AddNode(broadcast->Value().CloneUniq(), {node},
+                             broadcast->Ancestors());
+    }
+    auto pt_tensor_names = Estd::transform(
+        taps.value(), [](const ConvTap& tap) { return tap.pt_tensor_name; });
+    auto conv = out_dag.AddNode(
+        std::make_unique<TConvC>(layout, shifts, pt_tensor_names,
+                                 taps->at(0).pt_log_scale),
+        {node}, root->Ancestors());
+    InheritChildren(*root, conv);
+    RemoveDeadTOps(root);
+  }
+  return out_dag;
+}
+
+}  // namespace fhelipe
@@ -0,0 +1,339 @@
+/** $lic$
+ * Copyright (C) 2023-2024 by Massachusetts Institute of Technology
+ *
+ * This file is part of the Fhelipe compiler.
+ *
+ * Fhelipe is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * Fhelipe is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>. 
+ */
+
+#include "include/cost_model_layout_pass.h"
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "include/chunk_size.h"
+#include "include/dag.h"
+#include "include/extended_std.h"
+#include "include/fill_gaps_layout_pass.h"
+#include "include/layout_utils.h"
+#include "include/t_layout_conversion_c.h"
+#include "include/t_op_embrio.h"
+#include "include/tensor_layout.h"
+#include "include/utils.h"
+
+namespace fhelipe {
+
+namespace {
+
+// Candidate layouts kept per node
+constexpr int kMaxCandidates = 8;
+// Orders of its dimensions tried per input, in lexicographic order
+constexpr int kMaxInputDimensionOrders = 24;
+// Passes of the local search over the whole dag
+constexpr int kMaxLocalSearchRounds = 8;
+
+bool IsChetRepack(const Node<TOpEmbrio>& node) {
+  return dynamic_cast<const TChetRepackCEmbrio*>(&node.Value()) != nullptr;
+}
+
+TensorLayout OutputLayout(const std::shared_ptr<Node<TOpEmbrio>>& node,
+                          const TensorLayout& input_layout) {
+  return FillGapsLayoutPass::StaticGetOutputLayout(node, input_layout);
+}
+
+// The first order is FillGapsLayoutPass's default layout
+std::vector<TensorLayout> LayoutsOfInput(const Shape& shape,
+                                         ChunkSize chunk_size) {
+  std::vector<TensorLayout> result;
+  auto dim_order = Estd::indices(shape.DimensionCount());
+  int order_count = 0;
+  do {
+    std::vector<TensorLayout::LayoutBit> bits;
+    for (int dim_idx : dim_order) {
+      for (int bit_idx : Estd::indices(ceil_log2(shape[dim_idx]))) {
+        bits.emplace_back(DimensionBit(dim_idx, bit_idx));
+      }
+    }
+    TensorLayout layout(shape, ChunkBits(bits, chunk_size));
+    if (!Estd::contains(result, layout)) {
+      result.push_back(layout);
+    }
+  } while (++order_count < kMaxInputDimensionOrders &&
+           std::next_permutation(dim_order.begin(), dim_order.end()));
+  return result;
+}
+
+// Candidate layouts of every non-repack node of a layout pass input, on dense
+// indices in topological order, and the candidate picked for each
+class LayoutSearch {
+ public:
+  LayoutSearch(const Dag<TOpEmbrio>& dag, ChunkSize chunk_size,
+               const LayoutCostModel& cost_model);
+
+  std::unordered_map<const Node<TOpEmbrio>*, TensorLayout> InputLayouts();
+
+ private:
+  struct Candidate {
+    int input_layout;
+    int output_layout;
+    // Cost of the node itself
+    double cost;
+    // Cost of the node and the cheapest way to produce its input, where a
+    // node with several consumers charges each an equal share
+    double upstream_cost;
+  };
+
+  int LayoutId(const TensorLayout& layout);
+  double ConversionCost(int from, int to);
+  void AddCandidates(int idx);
+  const Candidate& Picked(int idx) const {
+    return candidates_.at(idx).at(picks_.at(idx));
+  }
+  // Cost of a candidate and of the conversions on the node's edges, given the
+  // candidates picked for its neighbors
+  double LocalCost(int idx, const Candidate& candidate);
+  double TotalCost();
+  void PickByBacktracking();
+  void LocalSearch();
+
+  const LayoutCostModel& cost_model_;
+  ChunkSize chunk_size_;
+  std::vector<std::shared_ptr<Node<TOpEmbrio>>> nodes_;
+  std::vector<std::vector<int>> parents_;
+  std::vector<std::vector<int>> children_;
+  std::vector<std::vector<Candidate>> candidates_;
+  std::vector<int> picks_;
+  std::vector<TensorLayout> layouts_;
+  std::unordered_map<TensorLayout, int> layout_ids_;
+  std::unordered_map<int64_t, double> conversion_costs_;
+};
+
+LayoutSearch::LayoutSearch(const Dag<TOpEmbrio>& dag, ChunkSize chunk_size,
+                           const LayoutCostModel& cost_model)
+    : cost_model_(cost_model), chunk_size_(chunk_size) {
+  std::unordered_map<const Node<TOpEmbrio>*, int> dense_indices;
+  for (const auto& node : dag.NodesInTopologicalOrder()) {
+    if (!IsChetRepack(*node)) {
+      dense_indices.emplace(node.get(), nodes_.size());
+      nodes_.push_back(node);
+    }
+  }
+  auto dense_index = [&dense_indices](std::shared_ptr<Node<TOpEmbrio>> node) {
+    while (IsChetRepack(*node)) {
+      node = node->Parents().at(0);
+    }
+    return dense_indices.at(node.get());
+  };
+  children_.resize(nodes_.size());
+  for (int idx : Estd::indices(nodes_.size())) {
+    parents_.push_back(Estd::set_to_vector(Estd::vector_to_set(
+        Estd::transform(nodes_.at(idx)->Parents(), dense_index))));
+    for (int parent : parents_.back()) {
+      children_.at(parent).push_back(idx);
+    }
+  }
+  for (int idx : Estd::indices(nodes_.size())) {
+    AddCandidates(idx);
+  }
+}
+
+int LayoutSearch::LayoutId(const TensorLayout& layout) {
+  auto [it, inserted] = layout_ids_.emplace(layout, layouts_.size());
+  if (inserted) {
+    layouts_.push_back(layout);
+  }
+  return it->second;
+}
+
+double LayoutSearch::ConversionCost(int from, int to) {
+  if (from == to) {
+    return 0;
+  }
+  int64_t key = (static_cast<int64_t>(from) << 32) | to;
+  auto it = conversion_costs_.find(key);
+  if (it == conversion_costs_.end()) {
+    double cost = cost_model_.TOpCost(
+        TLayoutConversionC(layouts_.at(from), layouts_.at(to)));
+    it = conversion_costs_.emplace(key, cost).first;
+  }
+  return it->second;
+}
+
+void LayoutSearch::AddCandidates(int idx) {
+  const auto& node = nodes_.at(idx);
+  std::vector<int> input_layouts;
+  if (parents_.at(idx).empty()) {
+    for (const auto& layout :
+         LayoutsOfInput(node->Value().OutputShape(), chunk_size_)) {
+      input_layouts.push_back(LayoutId(layout));
+    }
+  }
+  for (int parent : parents_.at(idx)) {
+    for (const auto& candidate : candidates_.at(parent)) {
+      if (!Estd::contains(input_layouts, candidate.output_layout)) {
+        input_layouts.push_back(candidate.output_layout);
+      }
+    }
+  }
+
+  std::vector<Candidate> candidates;
+  for (int input_layout : input_layouts) {
+    const auto& layout = layouts_.at(input_layout);
+    auto t_op = node->Value().GetTOp(layout, OutputLayout(node, layout));
+    double cost = cost_model_.TOpCost(*t_op);
+    double upstream_cost = cost;
+    for (int parent : parents_.at(idx)) {
+      int share = children_.at(parent).size();
+      upstream_cost += Estd::min_element(Estd::transform(
+          candidates_.at(parent), [&](const Candidate& parent_candidate) {
+            return parent_candidate.upstream_cost / share +
+                   ConversionCost(parent_candidate.output_layout,
+                                  input_layout);
+          }));
+    }
+    candidates.push_back(
+        {input_layout, LayoutId(t_op->OutputLayout()), cost, upstream_cost});
+  }
+  std::stable_sort(candidates.begin(), candidates.end(),
+                   [](const auto& lhs, const auto& rhs) {
+                     return lhs.upstream_cost < rhs.upstream_cost;
+                   });
+  if (candidates.size() > kMaxCandidates) {
+    candidates.resize(kMaxCandidates);
+  }
+  candidates_.push_back(candidates);
+}
+
+double LayoutSearch::LocalCost(int idx, const Candidate& candidate) {
+  double result = candidate.cost;
+  for (int parent : parents_.at(idx)) {
+    result +=
+        ConversionCost(Picked(parent).output_layout, candidate.input_layout);
+  }
+  for (int child : children_.at(idx)) {
+    result +=
+        ConversionCost(candidate.output_layout, Picked(child).input_layout);
+  }
+  return result;
+}
+
+double LayoutSearch::TotalCost() {
+  double result = 0;
+  for (int idx : Estd::indices(nodes_.size())) {
+    result += Picked(idx).cost;
+    for (int parent : parents_.at(idx)) {
+      result += ConversionCost(Picked(parent).output_layout,
+                               Picked(idx).input_layout);
+    }
+  }
+  return result;
+}
+
+// Consumers are picked before their producers, so a producer picks the
+// candidate that is cheapest together with the conversions its consumers
+// need; with a single consumer, that is the candidate the consumer's
+// upstream cost assumed
+void LayoutSearch::PickByBacktracking() {
+  picks_.resize(nodes_.size());
+  for (int idx : Estd::reverse(Estd::indices(nodes_.size()))) {
+    picks_.at(idx) = Estd::argmin(Estd::transform(
+        candidates_.at(idx), [this, idx](const Candidate& candidate) {
+          double result = candidate.upstream_cost;
+          for (int child : children_.at(idx)) {
+            result += ConversionCost(candidate.output_layout,
+                                     Picked(child).input_layout);
+          }
+          return result;
+        }));
+  }
+}
+
+void LayoutSearch::LocalSearch() {
+  for (int round = 0; round < kMaxLocalSearchRounds; ++round) {
+    bool improved = false;
+    for (int idx : Estd::indices(nodes_.size())) {
+      double picked_cost = LocalCost(idx, Picked(idx));
+      for (int candidate_idx : Estd::indices(candidates_.at(idx).size())) {
+        double cost = LocalCost(idx, candidates_.at(idx).at(candidate_idx));
+        if (cost < picked_cost) {
+          picks_.at(idx) = candidate_idx;
+          picked_cost = cost;
+          improved = true;
+        }
+      }
+    }
+    if (!improved) {
+      return;
+    }
+  }
+}
+
+std::unordered_map<const Node<TOpEmbrio>*, TensorLayout>
+LayoutSearch::InputLayouts() {
+  PickByBacktracking();
+  double backtracked_cost = TotalCost();
+  LocalSearch();
+  LOG(INFO) << "Estimated layout cost: " << TotalCost() << " ("
+            << backtracked_cost << " before local search)";
+
+  std::unordered_map<const Node<TOpEmbrio>*, TensorLayout> result;
+  for (int idx : Estd::indices(nodes_.size())) {
+    result.emplace(nodes_.at(idx).get(),
+                   layouts_.at(Picked(idx).input_layout));
+  }
+  return result;
+}
+
+}  // namespace
+
+LayoutPassOutput CostModelLayoutPass::DoPass(const LayoutPassInput& in_dag) {
+  auto input_layouts =
+      LayoutSearch(in_dag, ChunkSize(context_.GetLogChunkSize()), *cost_model_)
+          .InputLayouts();
+
+  std::unordered_map<const Node<TOpEmbrio>*, std::shared_ptr<Node<TOp>>>
+      old_to_new_nodes;
+  // Consumers that want a node in the same layout share one conversion
+  typedef std::unordered_map<TensorLayout, std::shared_ptr<Node<TOp>>>
+      Conversions;
+  std::unordered_map<const Node<TOp>*, Conversions> conversions;
+  Dag<TOp> out_dag;
+  for (const auto& old_node : in_dag.NodesInTopologicalOrder()) {
+    auto parents = ExtractParents(old_to_new_nodes, *old_node);
+    if (IsChetRepack(*old_node)) {
+      old_to_new_nodes.emplace(old_node.get(), parents.at(0));
+      continue;
+    }
+    const auto& input_layout = input_layouts.at(old_node.get());
+    for (auto& parent : parents) {
+      auto& parent_conversions = conversions[parent.get()];
+      if (!Estd::contains_key(parent_conversions, input_layout)) {
+        parent_conversions.emplace(
+            input_layout, AddLayoutConversion(out_dag, parent, input_layout));
+      }
+      parent = parent_conversions.at(input_layout);
+    }
+    auto new_node = out_dag.AddNode(
+        old_node->Value().GetTOp(input_layout,
+                                 OutputLayout(old_node, input_layout)),
+        parents, {old_node->NodeId()});
+    old_to_new_nodes.emplace(old_node.get(), new_node);
+  }
+  return out_dag;
+}
+
+}  // namespace fhelipe
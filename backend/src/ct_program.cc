@@ -24,6 +24,8 @@
 #include <fstream>
 #include <limits>
 #include <memory>
+#include <sstream>
+#include <string>
 #include <vector>
 
 #include "include/add_cc.h"
@@ -32,13 +34,16 @@
 #include "include/bootstrap_c.h"
 #include "include/chunk_ir.h"
 #include "include/constants.h"
+#include "include/content_hash.h"
 #include "include/ct_op.h"
 #include "include/dag.h"
 #include "include/dag_io.h"
 #include "include/dictionary.h"
 #include "include/dictionary_impl.h"
+#include "include/drop_level_c.h"
 #include "include/extended_std.h"
 #include "include/filesystem_utils.h"
+#include "include/glog_flag_avoid_writes.h"
 #include "include/input_c.h"
 #include "include/io_spec.h"
 #include "include/io_utils.h"
@@ -279,6 +284,19 @@ void WriteSchedulableNode<RescaleC>(
   WriteStream<std::string>(stream, "\tct");
 }
 
+template <>
+void WriteSchedulableNode<DropLevelC>(
+    std::ostream& stream, const DropLevelC& node,
+    const std::vector<int>& level_to_craterlake_level_map,
+    const std::vector<int>& level_to_log_q_map) {
+  // The scheduler has no mod-switch; like OutputC, a fake MulCP stands in for
+  // the cheap limb drop
+  WriteStream<std::string>(stream, "MUL_SIMPLE\tMulCP\t");
+  WriteStream<int>(
+      stream, LevelToAxelSlots(node.GetLevel(), level_to_craterlake_level_map));
+  WriteStream<std::string>(stream, "\tct");
+}
+
 template <>
 void WriteSchedulableNode<OutputC>(
     std::ostream& stream, const OutputC& node,
@@ -357,6 +375,10 @@ void WriteSchedulableNode<CtOp>(
   } else if (const auto* output_c = dynamic_cast<const OutputC*>(&node)) {
     WriteSchedulableNode(stream, *output_c, level_to_craterlake_level_map,
                          level_to_log_q_map);
+  } else if (const auto* drop_level_c =
+                 dynamic_cast<const DropLevelC*>(&node)) {
+    WriteSchedulableNode(stream, *drop_level_c, level_to_craterlake_level_map,
+                         level_to_log_q_map);
   } else if (const auto* schedulable_mul_ksh =
                  dynamic_cast<const SchedulableMulKsh*>(&node)) {
     WriteSchedulableNode(stream, *schedulable_mul_ksh,
@@ -458,15 +480,64 @@ CtProgram::CtProgram(const ProgramContext& ct_param,
       ct_op_dag_(std::move(dag)),
       chunk_dict_(std::move(chunk_dict)) {}
 
+KeyType CtProgram::RecordChunk(const ChunkIr& chunk) {
+  std::stringstream stream;
+  WriteStream<ChunkIr>(stream, chunk);
+  auto digest = ContentHash(stream.str());
+  auto it = chunk_keys_by_digest_.find(digest);
+  // The read-back only guards against digest collisions, so it is skipped
+  // when the dictionary did not write the chunk
+  if (it != chunk_keys_by_digest_.end() &&
+      (AvoidWrites() || chunk_dict_->At(it->second) == chunk)) {
+    return it->second;
+  }
+  auto key = chunk_dict_->Record(chunk);
+  chunk_keys_by_digest_.emplace(digest, key);
+  recorded_chunk_keys_.push_back(key);
+  return key;
+}
+
+ChunkIr CtProgram::GetChunkIr(const KeyType& key) const {
+  return chunk_dict_->At(key);
+}
+
+CtProgram CtProgram::WithDag(Dag<CtOp>&& dag) const {
+  CtProgram result(ct_param_, chunk_dict_->CloneUniq(), std::move(dag));
+  result.chunk_keys_by_digest_ = chunk_keys_by_digest_;
+  result.recorded_chunk_keys_ = recorded_chunk_keys_;
+  return result;
+}
+
+std::unique_ptr<CtOp> WithChunkKeys(
+    const CtOp& ct_op, const std::unordered_map<KeyType, KeyType>& keys) {
+  if (const auto* mul_cp = dynamic_cast<const MulCP*>(&ct_op)) {
+    return std::make_unique<MulCP>(mul_cp->GetLevelInfo(),
+                                   keys.at(mul_cp->GetHandle()),
+                                   mul_cp->GetPtLogScale());
+  }
+  if (const auto* add_cp = dynamic_cast<const AddCP*>(&ct_op)) {
+    return std::make_unique<AddCP>(add_cp->GetLevelInfo(),
+                                   keys.at(add_cp->GetHandle()),
+                                   add_cp->GetPtLogScale());
+  }
+  return ct_op.CloneUniq();
+}
+
 std::shared_ptr<Node<CtOp>> CreateBootstrapC(
     CtProgram& ct_program, const LevelInfo& level_info,
     const std::shared_ptr<Node<CtOp>>& parent) {
+  if (dynamic_cast<const ZeroC*>(&parent->Value())) {
+    return FetchZeroC(parent, level_info);
+  }
   return ct_program.AddNode(std::make_unique<BootstrapC>(level_info), {parent});
 }
 
 std::shared_ptr<Node<CtOp>> CreateRescaleC(
     CtProgram& ct_program, const LevelInfo& level_info,
     const std::shared_ptr<Node<CtOp>>& parent) {
+  if (dynamic_cast<const ZeroC*>(&parent->Value())) {
+    return FetchZeroC(parent, level_info);
+  }
   return ct_program.AddNode(std::make_unique<RescaleC>(level_info), {parent});
 }
 
@@ -476,9 +547,10 @@ std::shared_ptr<Node<CtOp>> CreateInputC(CtProgram& ct_program,
   return ct_program.AddNode(std::make_unique<InputC>(level_info, io_spec), {});
 }
 
-std::shared_ptr<Node<CtOp>> FetchZeroC(const std::shared_ptr<Node<CtOp>>& node,
-                                       const LevelInfo& level_info) {
-  auto sentinel = node->Sentinel();
+namespace {
+
+std::shared_ptr<Node<CtOp>> FetchZeroCUnder(
+    const std::shared_ptr<Node<CtOp>>& sentinel, const LevelInfo& level_info) {
   auto candidates =
       Estd::filter(sentinel->Children(), [&level_info](const auto& ptr) {
         const auto* zero_c = dynamic_cast<const ZeroC*>(&ptr->Value());
@@ -495,6 +567,18 @@ std::shared_ptr<Node<CtOp>> FetchZeroC(const std::shared_ptr<Node<CtOp>>& node,
   return zero_c;
 }
 
+}  // namespace
+
+std::shared_ptr<Node<CtOp>> FetchZeroC(const std::shared_ptr<Node<CtOp>>& node,
+                                       const LevelInfo& level_info) {
+  return FetchZeroCUnder(node->Sentinel(), level_info);
+}
+
+std::shared_ptr<Node<CtOp>> FetchZeroC(CtProgram& ct_program,
+                                       const LevelInfo& level_info) {
+  return FetchZeroCUnder(ct_program.GetDag().Sentinel(), level_info);
+}
+
 std::vector<int> BestPossibleLevelToCraterLakeLevelMap(
     const Level& max_levels, const LogScale& bits_per_level) {
   std::vector<int> result{0};
@@ -20,155 +20,60 @@
 
 #include <include/scaled_t_op.h>
 
+#include <algorithm>
+#include <bit>
+#include <functional>
+#include <numeric>
+#include <optional>
+#include <queue>
+#include <unordered_set>
+
 #include "include/extended_std.h"
 #include "include/t_output_c.h"
 #include "include/t_rescale_c.h"
 
 namespace fhelipe {
 
-DagDepthInfo::DagDepthInfo(const Dag<ScaledTOp>& dag)
-    : dag_(&dag),
-      depth_map_(ConstructDepthMap(*dag_)),
-      dag_depth_(ConstructDagDepth(depth_map_)),
-      frontier_map_(ConstructFrontierMap(depth_map_, dag_depth_)),
-      edges_intersecting_frontier_(ConstructEdgesIntersectingFrontier(
-          *dag_, frontier_map_, depth_map_, dag_depth_)) {}
-
-int DagDepthInfo::ConstructDagDepth(const DepthMap& depth_map) {
-  int max_depth = 0;
-  for (const auto& [node, depth] : depth_map) {
-    if (max_depth < depth) {
-      max_depth = depth;
-    }
-  }
-  return max_depth;
-}
-
-std::shared_ptr<Node<ScaledTOp>> NodeWithHighestDepth(
-    const DepthMap& depth_map,
-    const std::vector<std::shared_ptr<Node<ScaledTOp>>>& nodes) {
-  auto best = nodes[0];
-  for (const auto& node : nodes) {
-    if (depth_map.at(node.get()) > depth_map.at(best.get())) {
-      best = node;
-    }
-  }
-  return best;
-}
-
-bool IsAfterFrontier(const Node<ScaledTOp>* node,
-                     const std::set<const Node<ScaledTOp>*>& frontier,
-                     const DepthMap& depth_map) {
-  // Special case: If current node is on frontier, then it is _before_ the
-  // frontier
-  if (frontier.find(node) != frontier.end()) {
-    return false;
-  }
-  // DFS up
-  for (auto curr_node = node; depth_map.at(curr_node) == depth_map.at(node);
-       curr_node =
-           NodeWithHighestDepth(depth_map, curr_node->Parents()).get()) {
-    if (frontier.find(curr_node) != frontier.end()) {
-      return true;
-    }
-  }
-  return false;
-}
-
-EdgesIntersectingFrontierMap DagDepthInfo::ConstructEdgesIntersectingFrontier(
-    const Dag<ScaledTOp>& dag, const FrontierMap& frontier_map,
-    const DepthMap& depth_map, int dag_depth) {
-  EdgesIntersectingFrontierMap edges_intersecting_frontier(dag_depth + 1);
-  std::set<std::shared_ptr<Node<ScaledTOp>>> visited;
-  for (const auto& parent_t : dag.NodesInTopologicalOrder()) {
-    visited.insert(parent_t);
-    int parent_depth = depth_map.at(parent_t.get());
-    for (const auto& child_t : parent_t->Children()) {
-      int child_depth = depth_map.at(child_t.get());
-      if (child_depth - parent_depth > 1 ||
-          (child_depth - parent_depth == 1 &&
-           !dynamic_cast<const TRescaleC*>(&child_t->Value().GetTOp()))) {
-        for (int depth = parent_depth; depth < child_depth - 1; ++depth) {
-          edges_intersecting_frontier.at(depth + 1).insert(
-              DirectedEdge<ScaledTOp>(parent_t, child_t));
-        }
-        if (IsAfterFrontier(child_t.get(), frontier_map.at(child_depth),
-                            depth_map)) {
-          edges_intersecting_frontier.at(child_depth)
-              .insert(DirectedEdge<ScaledTOp>(parent_t, child_t));
-        }
-      }
-    }
-  }
-
-  return edges_intersecting_frontier;
-}
-
-std::set<const Node<ScaledTOp>*> Sc(const DagDepthInfo& dag, int i, int j) {
-  auto edges = Estd::set_to_vector(Estd::set_difference(
-      dag.EdgesIntersectingFrontier(i), dag.EdgesIntersectingFrontier(j)));
-  return Estd::vector_to_set(Estd::transform(
-      edges, [](const auto& edge) { return edge.Parent().get(); }));
-}
-
-int ScCount(const DagDepthInfo& dag, int i, int j) {
-  return Sc(dag, i, j).size();
-}
-
-DepthMap DagDepthInfo::ConstructDepthMap(const Dag<ScaledTOp>& dag) {
-  DepthMap depth_map;
-  for (const auto& node : dag.NodesInTopologicalOrder()) {
-    int depth = 0;
-    if (!node->Parents().empty()) {
-      depth =
-          Estd::max_element(Estd::values_from_keys(depth_map, node->Parents()));
-      if (dynamic_cast<const TRescaleC*>(&node->Value().GetTOp())) {
-        ++depth;
-      }
-    }
-    depth_map.emplace(node.get(), depth);
-  }
+namespace {
 
-  return depth_map;
-}
+using NodeSet = std::unordered_set<const Node<ScaledTOp>*>;
 
 std::vector<const Node<ScaledTOp>*> FindSinkNodes(
-    const std::vector<const Node<ScaledTOp>*>& nodes) {
-  return Estd::filter(nodes, [&nodes](const auto* node) {
-    return Estd::all_of(node->Children(), [&nodes](const auto& child) {
+    const std::vector<const Node<ScaledTOp>*>& nodes, const NodeSet& members) {
+  return Estd::filter(nodes, [&members](const auto* node) {
+    return Estd::all_of(node->Children(), [&members](const auto& child) {
       return dynamic_cast<const TOutputC*>(&child->Value().GetTOp()) ||
-             !Estd::contains(nodes, child.get());
+             !members.contains(child.get());
     });
   });
 }
 
 std::vector<const Node<ScaledTOp>*> FindSourceNodes(
-    const std::vector<const Node<ScaledTOp>*>& nodes) {
-  return Estd::filter(nodes, [&nodes](const auto* node) {
-    return Estd::all_of(node->Parents(), [&nodes](const auto& child) {
-      return !Estd::contains(nodes, child.get());
+    const std::vector<const Node<ScaledTOp>*>& nodes, const NodeSet& members) {
+  return Estd::filter(nodes, [&members](const auto* node) {
+    return Estd::all_of(node->Parents(), [&members](const auto& parent) {
+      return !members.contains(parent.get());
     });
   });
 }
 
-bool AllParentsVisited(
-    const std::vector<const Node<ScaledTOp>*>& nodes_to_be_considered,
-    const VisitedNodes<ScaledTOp>& visited, const Node<ScaledTOp>& node) {
-  return Estd::all_of(
-      node.Parents(), [&nodes_to_be_considered, &visited](const auto& parent) {
-        return !Estd::contains(nodes_to_be_considered, parent.get()) ||
-               visited.IsVisited(*parent);
-      });
+bool AllParentsVisited(const NodeSet& members,
+                       const VisitedNodes<ScaledTOp>& visited,
+                       const Node<ScaledTOp>& node) {
+  return Estd::all_of(node.Parents(), [&members, &visited](const auto& parent) {
+    return !members.contains(parent.get()) || visited.IsVisited(*parent);
+  });
 }
 
 std::vector<const Node<ScaledTOp>*> TopoSort(
     const std::vector<const Node<ScaledTOp>*>& nodes) {
+  NodeSet members(nodes.begin(), nodes.end());
   std::vector<const Node<ScaledTOp>*> result;
   std::queue<const Node<ScaledTOp>*> frontier;
   VisitedNodes<ScaledTOp> visited;
-  for (const auto* sink : FindSourceNodes(nodes)) {
-    frontier.push(sink);
-    visited.Set(*sink);
+  for (const auto* source : FindSourceNodes(nodes, members)) {
+    frontier.push(source);
+    visited.Set(*source);
   }
 
   // Topo sort
@@ -178,8 +83,8 @@ std::vector<const Node<ScaledTOp>*> TopoSort(
     result.push_back(vertex);
 
     for (const auto& child : vertex->Children()) {
-      if (AllParentsVisited(nodes, visited, *child) &&
-          !visited.IsVisited(*child) && Estd::contains(nodes, child.get())) {
+      if (members.contains(child.get()) && !visited.IsVisited(*child) &&
+          AllParentsVisited(members, visited, *child)) {
         frontier.push(child.get());
         visited.Set(*child);
       }
@@ -189,89 +94,88 @@ std::vector<const Node<ScaledTOp>*> TopoSort(
   return result;
 }
 
-std::vector<const Node<ScaledTOp>*> ReverseTopoSort(
-    const std::vector<const Node<ScaledTOp>*>& nodes) {
-  return Estd::reverse(TopoSort(nodes));
-}
-
 bool NoChildARescale(const Node<ScaledTOp>* node) {
   return Estd::all_of(node->Children(), [](const auto& child) {
     return !dynamic_cast<const TRescaleC*>(&child->Value().GetTOp());
   });
 }
 
+// The last node in topological order that everything before it feeds into
 std::optional<const Node<ScaledTOp>*> FindChokepoint(
     std::vector<const Node<ScaledTOp>*> nodes) {
-  nodes = ReverseTopoSort(nodes);
-  auto dependencies = Estd::vector_to_set(Estd::transform(
-      FindSinkNodes(nodes),
-      [&nodes](const auto* x) -> int { return Estd::find_index(nodes, x); }));
+  nodes = Estd::reverse(TopoSort(nodes));
+  NodeSet members(nodes.begin(), nodes.end());
+  std::unordered_map<const Node<ScaledTOp>*, int> positions;
+  for (int idx : Estd::indices(nodes.size())) {
+    positions.emplace(nodes.at(idx), idx);
+  }
+  // Latest position that the nodes seen so far depend on
+  int latest_dependency = 0;
+  for (const auto* sink : FindSinkNodes(nodes, members)) {
+    latest_dependency = std::max(latest_dependency, positions.at(sink));
+  }
 
   for (int idx : Estd::indices(nodes.size() - 1)) {
-    if (Estd::max_element(dependencies) <= idx &&
-        NoChildARescale(nodes.at(idx))) {
+    if (latest_dependency <= idx && NoChildARescale(nodes.at(idx))) {
       return nodes.at(idx);
     }
-    auto parents_at_depth = Estd::filter(
-        nodes.at(idx)->Parents(),
-        [&nodes](const auto& x) { return Estd::contains(nodes, x.get()); });
-
-    std::vector<int> parents_at_depth_indices =
-        Estd::transform(parents_at_depth, [&nodes](const auto& node) -> int {
-          const Node<ScaledTOp>* dummy = node.get();
-          return Estd::find_index(nodes, dummy);
-        });
-
-    dependencies = Estd::set_union(
-        dependencies, Estd::vector_to_set(parents_at_depth_indices));
+    for (const auto& parent : nodes.at(idx)->Parents()) {
+      auto it = positions.find(parent.get());
+      if (it != positions.end()) {
+        latest_dependency = std::max(latest_dependency, it->second);
+      }
+    }
   }
-  auto srcs = FindSourceNodes(nodes);
+  auto srcs = FindSourceNodes(nodes, members);
   if (srcs.size() == 1) {
     return srcs.at(0);
   }
   return std::nullopt;
 }
 
+const Node<ScaledTOp>* FindRoot(
+    std::unordered_map<const Node<ScaledTOp>*, const Node<ScaledTOp>*>& roots,
+    const Node<ScaledTOp>* node) {
+  while (roots.at(node) != node) {
+    roots.at(node) = roots.at(roots.at(node));
+    node = roots.at(node);
+  }
+  return node;
+}
+
+// Components come in an order that depends on the hashing of pointers, which
+// the chokepoint search is sensitive to; the insertions into `components`
+// below follow the order in which the connected components used to be grown
+// so that the order stays the same.
 std::vector<std::vector<const Node<ScaledTOp>*>> DivideIntoConnectedComponents(
     const std::vector<const Node<ScaledTOp>*>& nodes) {
-  std::vector<std::vector<const Node<ScaledTOp>*>> result;
-  std::unordered_map<const Node<ScaledTOp>*, int> components;
-  for (const auto& node : TopoSort(nodes)) {
-    auto ancestors = std::set<const Node<ScaledTOp>*>{node};
-    int elem_count;
-    do {
-      elem_count = ancestors.size();
-      auto new_ancestors = ancestors;
-      for (const auto* node : ancestors) {
-        auto curr_parents =
-            Estd::filter(node->Parents(), [&nodes](const auto& parent) {
-              return Estd::contains(nodes, parent.get());
-            });
-        new_ancestors = Estd::set_union(
-            new_ancestors,
-            Estd::vector_to_set(Estd::transform(
-                curr_parents, [](const auto& node) -> const Node<ScaledTOp>* {
-                  return node.get();
-                })));
-        auto curr_children =
-            Estd::filter(node->Children(), [&nodes](const auto& child) {
-              return Estd::contains(nodes, child.get());
-            });
-        new_ancestors = Estd::set_union(
-            new_ancestors,
-            Estd::transform(curr_children,
-                            [](const auto& node) -> const Node<ScaledTOp>* {
-                              return node.get();
-                            }));
+  std::unordered_map<const Node<ScaledTOp>*, const Node<ScaledTOp>*> roots;
+  for (const auto* node : nodes) {
+    roots.emplace(node, node);
+  }
+  for (const auto* node : nodes) {
+    for (const auto& parent : node->Parents()) {
+      if (roots.contains(parent.get())) {
+        roots.at(FindRoot(roots, parent.get())) = FindRoot(roots, node);
       }
-      ancestors = new_ancestors;
-    } while (elem_count != ancestors.size());
+    }
+  }
+  std::unordered_map<const Node<ScaledTOp>*, std::set<const Node<ScaledTOp>*>>
+      members;
+  for (const auto* node : nodes) {
+    members[FindRoot(roots, node)].insert(node);
+  }
 
+  std::unordered_map<const Node<ScaledTOp>*, int> components;
+  for (const auto* node : TopoSort(nodes)) {
+    const auto& component = members.at(FindRoot(roots, node));
+    if (components.contains(node)) {
+      continue;
+    }
     int component_label = Estd::min_element(Estd::transform(
-        ancestors, [](const auto& node) { return node->NodeId(); }));
-
-    for (const auto& ancestor : ancestors) {
-      components[ancestor] = component_label;
+        component, [](const auto* member) { return member->NodeId(); }));
+    for (const auto* member : component) {
+      components[member] = component_label;
     }
   }
 
@@ -279,6 +183,7 @@ std::vector<std::vector<const Node<ScaledTOp>*>> DivideIntoConnectedComponents(
   for (const auto& [node, component_id] : components) {
     reverse_map[component_id].push_back(node);
   }
+  std::vector<std::vector<const Node<ScaledTOp>*>> result;
   for (const auto& [id, component_nodes] : reverse_map) {
     result.push_back(component_nodes);
   }
@@ -287,45 +192,180 @@ std::vector<std::vector<const Node<ScaledTOp>*>> DivideIntoConnectedComponents(
 
 std::set<const Node<ScaledTOp>*> FindChokepointsPerConnectedComponent(
     const std::vector<const Node<ScaledTOp>*>& nodes) {
-  auto components = DivideIntoConnectedComponents(nodes);
   std::set<const Node<ScaledTOp>*> result;
-  for (const auto& component : components) {
+  for (const auto& component : DivideIntoConnectedComponents(nodes)) {
     auto chokepoint = FindChokepoint(component);
     if (chokepoint.has_value()) {
-      result = Estd::set_union(result, std::set{chokepoint.value()});
+      result.insert(chokepoint.value());
     } else {
-      result = Estd::set_union(
-          result,
-          Estd::vector_to_set(Estd::filter(component, [](const auto* node) {
-            return dynamic_cast<const TRescaleC*>(&node->Value().GetTOp());
-          })));
+      for (const auto* node : component) {
+        if (dynamic_cast<const TRescaleC*>(&node->Value().GetTOp())) {
+          result.insert(node);
+        }
+      }
+    }
+  }
+  return result;
+}
+
+DepthMap ConstructDepthMap(
+    const std::vector<std::shared_ptr<Node<ScaledTOp>>>& nodes) {
+  DepthMap depth_map;
+  for (const auto& node : nodes) {
+    int depth = 0;
+    if (!node->Parents().empty()) {
+      depth =
+          Estd::max_element(Estd::values_from_keys(depth_map, node->Parents()));
+      if (dynamic_cast<const TRescaleC*>(&node->Value().GetTOp())) {
+        ++depth;
+      }
+    }
+    depth_map.emplace(node.get(), depth);
+  }
+  return depth_map;
+}
+
+}  // namespace
+
+std::vector<int> DenseBitset::Difference(const DenseBitset& other) const {
+  CHECK(words_.size() == other.words_.size());
+  std::vector<int> result;
+  for (int word_idx : Estd::indices(words_.size())) {
+    for (uint64_t word = words_.at(word_idx) & ~other.words_.at(word_idx);
+         word != 0; word &= word - 1) {
+      result.push_back(word_idx * kWordBits + std::countr_zero(word));
     }
   }
   return result;
 }
 
-FrontierMap DagDepthInfo::ConstructFrontierMap(const DepthMap& depth_map,
-                                               int dag_depth) {
-  FrontierMap frontier_map(dag_depth + 1);
+DagDepthInfo::DagDepthInfo(const Dag<ScaledTOp>& dag) {
+  auto nodes = dag.NodesInTopologicalOrder();
+  nodes_ = Estd::transform(nodes, [](const auto& node) -> const auto* {
+    return node.get();
+  });
+  std::sort(nodes_.begin(), nodes_.end(),
+            std::less<const Node<ScaledTOp>*>());
+  for (int idx : Estd::indices(nodes_.size())) {
+    dense_indices_.emplace(nodes_.at(idx), idx);
+  }
+
+  depth_map_ = ConstructDepthMap(nodes);
+  depths_ = Estd::transform(
+      nodes_, [this](const auto* node) { return depth_map_.at(node); });
+  for (int depth : depths_) {
+    dag_depth_ = std::max(dag_depth_, depth);
+  }
+  ConstructFrontiers();
+  ConstructAfterOwnFrontier(nodes);
+  ConstructCrossingEdges(nodes);
+}
 
-  // Construct depth_to_nodes
-  std::vector<std::vector<const Node<ScaledTOp>*>> depth_to_nodes(dag_depth +
+void DagDepthInfo::ConstructFrontiers() {
+  // Walks depth_map_ rather than nodes_ to visit the nodes in the order that
+  // the frontiers have always been computed in
+  std::vector<std::vector<const Node<ScaledTOp>*>> depth_to_nodes(dag_depth_ +
                                                                   1);
-  for (const auto& [node, depth] : depth_map) {
+  for (const auto& [node, depth] : depth_map_) {
     depth_to_nodes.at(depth).push_back(node);
   }
 
-  for (int curr_depth : Estd::indices(dag_depth + 1)) {
-    const auto& curr_nodes = depth_to_nodes.at(curr_depth);
-    frontier_map.at(curr_depth) =
-        FindChokepointsPerConnectedComponent(curr_nodes);
+  for (const auto& curr_nodes : depth_to_nodes) {
+    frontiers_.push_back(FindChokepointsPerConnectedComponent(curr_nodes));
+    DenseBitset bits(nodes_.size());
+    int ciphertext_count = 0;
+    for (const auto* node : frontiers_.back()) {
+      bits.Set(DenseIndex(node));
+      ciphertext_count += node->Value().GetTOp().OutputLayout().TotalChunks();
+    }
+    frontier_bits_.push_back(bits);
+    frontier_ciphertext_counts_.push_back(ciphertext_count);
+  }
+}
+
+// A node comes after its frontier if it is not on it and following the
+// deepest parent up from it reaches the frontier before leaving its depth
+void DagDepthInfo::ConstructAfterOwnFrontier(
+    const std::vector<std::shared_ptr<Node<ScaledTOp>>>& nodes) {
+  after_own_frontier_ = DenseBitset(nodes_.size());
+  // Whether following the deepest parent up reaches the frontier at the
+  // node's depth, starting with the node itself
+  DenseBitset reaches_frontier(nodes_.size());
+  for (const auto& node : nodes) {
+    int idx = DenseIndex(node.get());
+    int depth = depths_.at(idx);
+    bool on_frontier = frontier_bits_.at(depth).Test(idx);
+    std::optional<int> deepest_parent;
+    for (const auto& parent : node->Parents()) {
+      int parent_idx = DenseIndex(parent.get());
+      if (!deepest_parent.has_value() ||
+          depths_.at(parent_idx) > depths_.at(*deepest_parent)) {
+        deepest_parent = parent_idx;
+      }
+    }
+    bool parent_reaches_frontier = deepest_parent.has_value() &&
+                                   depths_.at(*deepest_parent) == depth &&
+                                   reaches_frontier.Test(*deepest_parent);
+    if (on_frontier || parent_reaches_frontier) {
+      reaches_frontier.Set(idx);
+    }
+    if (!on_frontier && parent_reaches_frontier) {
+      after_own_frontier_.Set(idx);
+    }
+  }
+}
+
+// Every crossing edge crosses a contiguous range of frontiers, so the edges
+// crossing one frontier follow from the ones crossing the frontier before by
+// adding the ranges that start and dropping the ranges that end there
+void DagDepthInfo::ConstructCrossingEdges(
+    const std::vector<std::shared_ptr<Node<ScaledTOp>>>& nodes) {
+  std::vector<std::vector<int>> edges_starting_at(dag_depth_ + 1);
+  std::vector<std::vector<int>> edges_ending_at(dag_depth_ + 1);
+  for (const auto& parent : nodes) {
+    int parent_idx = DenseIndex(parent.get());
+    int parent_depth = depths_.at(parent_idx);
+    for (const auto& child : parent->Children()) {
+      int child_depth = NodeDepth(child.get());
+      if (child_depth - parent_depth < 1 ||
+          (child_depth - parent_depth == 1 &&
+           dynamic_cast<const TRescaleC*>(&child->Value().GetTOp()))) {
+        continue;
+      }
+      int first_depth = parent_depth + 1;
+      int last_depth =
+          IsAfterOwnFrontier(child.get()) ? child_depth : child_depth - 1;
+      if (first_depth > last_depth) {
+        continue;
+      }
+      edges_starting_at.at(first_depth).push_back(edge_parents_.size());
+      edges_ending_at.at(last_depth).push_back(edge_parents_.size());
+      edge_parents_.push_back(parent_idx);
+    }
+  }
+
+  DenseBitset crossing(edge_parents_.size());
+  for (int depth : Estd::indices(dag_depth_ + 1)) {
+    for (int edge : edges_starting_at.at(depth)) {
+      crossing.Set(edge);
+    }
+    crossing_edges_.push_back(crossing);
+    for (int edge : edges_ending_at.at(depth)) {
+      crossing.Reset(edge);
+    }
   }
-  return frontier_map;
 }
 
-bool EdgeIntersectsFrontier(const DagDepthInfo& dag, int frontier,
-                            const DirectedEdge<ScaledTOp>& edge) {
-  return Estd::contains(dag.EdgesIntersectingFrontier(frontier), edge);
+std::set<const Node<ScaledTOp>*> DagDepthInfo::Sc(int i, int j) const {
+  DenseBitset parents(nodes_.size());
+  for (int edge : crossing_edges_.at(i).Difference(crossing_edges_.at(j))) {
+    parents.Set(edge_parents_.at(edge));
+  }
+  std::set<const Node<ScaledTOp>*> result;
+  for (int idx : parents.Difference(DenseBitset(nodes_.size()))) {
+    result.insert(result.end(), nodes_.at(idx));
+  }
+  return result;
 }
 
 }  // namespace fhelipe
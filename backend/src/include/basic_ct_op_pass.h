@@ -42,22 +42,30 @@ class CtProgram;
 class CtOp;
 class TOp;
 
+// Lowers each LeveledTOp through AmendCtProgram. TOps whose parents are all
+// lowered are lowered together on up to `thread_count` threads, each into a
+// private CtProgram, and then stitched into the result in topological order;
+// the result does not depend on `thread_count`.
 class BasicCtOpPass : public CtOpPass {
  public:
   BasicCtOpPass(const ProgramContext& context,
-                std::unique_ptr<Dictionary<ChunkIr>>&& chunk_dict);
+                std::unique_ptr<Dictionary<ChunkIr>>&& chunk_dict,
+                int thread_count = 1);
   CtOpPassOutput DoPass(const CtOpPassInput& in_dag) final;
   const PassName& GetPassName() const final {
     static PassName pass_name("basic_ct_op_pass");
     return pass_name;
   }
+  std::string PassSettings() const final { return ToString(context_); }
   std::unique_ptr<CtOpPass> CloneUniq() const final {
-    return std::make_unique<BasicCtOpPass>(context_, chunk_dict_->CloneUniq());
+    return std::make_unique<BasicCtOpPass>(context_, chunk_dict_->CloneUniq(),
+                                           thread_count_);
   }
 
  private:
   ProgramContext context_;
   std::unique_ptr<Dictionary<ChunkIr>> chunk_dict_;
+  int thread_count_;
 };
 
 }  // namespace fhelipe
@@ -40,6 +40,7 @@ class BasicPreprocessor : public Preprocessor {
     static auto pass_name = PassName("basic_preprocessor");
     return pass_name;
   }
+  std::string PassSettings() const final;
   std::unique_ptr<Preprocessor> CloneUniq() const final {
     return std::make_unique<BasicPreprocessor>(*this);
   }
@@ -38,22 +38,30 @@ class TOpEmbrio;
 class ScaledTOp;
 class LeveledTOp;
 
+// Removes every bootstrap that the levels after it do not need, shortcut
+// bootstraps first. Each removal re-levels only the nodes downstream of the
+// bootstrap whose levels change. Batches of candidates are evaluated on up to
+// `thread_count` threads and committed in order, re-evaluating a candidate
+// whose evaluation read a node that an earlier commit in its batch changed;
+// the result does not depend on `thread_count`.
 class BootstrapPrunningPass : public LevelingOptimizer {
  public:
-  explicit BootstrapPrunningPass(const ProgramContext& context)
-      : context_(context) {}
+  explicit BootstrapPrunningPass(const ProgramContext& context,
+                                 int thread_count = 1);
   LevelingOptimizerOutput DoPass(const LevelingOptimizerInput& in_dag) final;
 
   const PassName& GetPassName() const final {
     static PassName pass_name("bootstrap_prunning_pass");
     return pass_name;
   }
+  std::string PassSettings() const final { return ToString(context_); }
   std::unique_ptr<LevelingOptimizer> CloneUniq() const final {
-    return std::make_unique<BootstrapPrunningPass>(context_);
+    return std::make_unique<BootstrapPrunningPass>(context_, thread_count_);
   }
 
  private:
   ProgramContext context_;
+  int thread_count_;
 };
 
 }  // namespace fhelipe
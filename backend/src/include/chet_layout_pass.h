@@ -36,6 +36,10 @@ class ChetLayoutPass : public GenericLayoutPass {
     static PassName pass_name = PassName("chet_layout_pass");
     return pass_name;
   }
+  std::string PassSettings() const final {
+    return GenericLayoutPass::PassSettings() + " " +
+           std::to_string(RowMajorHack());
+  }
   std::unique_ptr<LayoutPass> CloneUniq() const final {
     return std::make_unique<ChetLayoutPass>(*this);
   }
@@ -21,6 +21,7 @@
 
 #include <glog/logging.h>
 
+#include <cstdint>
 #include <istream>
 #include <memory>
 #include <optional>
@@ -40,25 +41,48 @@ namespace fhelipe {
 
 class ZeroChunkIr {
  public:
-  ZeroChunkIr(ChunkSize chunk_size) : chunk_size_(chunk_size) {}
+  ZeroChunkIr(class ChunkSize chunk_size) : chunk_size_(chunk_size) {}
   void WriteStreamHelper(std::ostream& stream) const { LOG(FATAL); }
   PtChunk Resolve(const Dictionary<Tensor<PtVal>>& frontend_tensors) const {
     return PtChunk(std::vector<PtVal>(chunk_size_.value(), 0));
   }
+  class ChunkSize ChunkSize() const { return chunk_size_; }
+
+  friend bool operator==(const ZeroChunkIr& lhs, const ZeroChunkIr& rhs) {
+    return lhs.chunk_size_.value() == rhs.chunk_size_.value();
+  }
 
  private:
-  ChunkSize chunk_size_;
+  class ChunkSize chunk_size_;
 };
 
+// 0/1 mask stored as a bitset; only expanded to PtVal in Resolve
 class DirectChunkIr {
  public:
-  explicit DirectChunkIr(const std::vector<PtVal>& values) : values_(values) {}
+  static constexpr int kWordBits = 64;
+
+  // All values must be either 0 or 1
+  explicit DirectChunkIr(const std::vector<PtVal>& values);
+  DirectChunkIr(int size, std::vector<uint64_t>&& words);
+
   PtChunk Resolve(const Dictionary<Tensor<PtVal>>& frontend_tensors) const;
   void WriteStreamHelper(std::ostream& stream) const;
-  const std::vector<PtVal>& Values() const { return values_; }
+
+  int Size() const { return size_; }
+  bool IsOne(int idx) const {
+    return (words_.at(idx / kWordBits) >> (idx % kWordBits)) & 1;
+  }
+  const std::vector<uint64_t>& Words() const { return words_; }
+
+  static int WordCount(int size) { return (size + kWordBits - 1) / kWordBits; }
+
+  friend bool operator==(const DirectChunkIr& lhs, const DirectChunkIr& rhs) {
+    return lhs.size_ == rhs.size_ && lhs.words_ == rhs.words_;
+  }
 
  private:
-  std::vector<PtVal> values_;
+  int size_;
+  std::vector<uint64_t> words_;
 };
 
 template <>
@@ -67,23 +91,46 @@ void WriteStream<DirectChunkIr>(std::ostream& stream, const DirectChunkIr& x);
 template <>
 DirectChunkIr ReadStream<DirectChunkIr>(std::istream& stream);
 
+// `length` consecutive slots starting at `slot` that hold the frontend tensor
+// elements with flat indices `flat`, `flat + stride`, `flat + 2 * stride`, ...
+struct IndexRun {
+  int slot;
+  int length;
+  int flat;
+  int stride;
+
+  friend bool operator==(const IndexRun& lhs, const IndexRun& rhs) = default;
+};
+
+// Frontend tensor elements gathered into a chunk. The slot -> flat index map of
+// a bit-permutation layout is piecewise affine, so it is stored as IndexRuns;
+// slots outside of all runs are zero.
 class IndirectChunkIr {
  public:
   IndirectChunkIr(const std::string& frontend_tensor_name,
-                  const std::vector<std::optional<int>>& vec)
-      : frontend_tensor_name_(frontend_tensor_name), flat_indices_(vec){};
+                  const std::vector<std::optional<int>>& vec);
+  IndirectChunkIr(const std::string& frontend_tensor_name, int size,
+                  std::vector<IndexRun>&& runs);
   PtChunk Resolve(const Dictionary<Tensor<PtVal>>& frontend_tensors) const;
   void WriteStreamHelper(std::ostream& stream) const;
-  const std::vector<std::optional<int>>& FlatIndices() const {
-    return flat_indices_;
-  }
+  // Expanded slot -> flat index map
+  std::vector<std::optional<int>> FlatIndices() const;
   const std::string& FrontendTensorName() const {
     return frontend_tensor_name_;
   }
+  int Size() const { return size_; }
+  const std::vector<IndexRun>& Runs() const { return runs_; }
+
+  friend bool operator==(const IndirectChunkIr& lhs,
+                         const IndirectChunkIr& rhs) {
+    return lhs.frontend_tensor_name_ == rhs.frontend_tensor_name_ &&
+           lhs.size_ == rhs.size_ && lhs.runs_ == rhs.runs_;
+  }
 
  private:
   std::string frontend_tensor_name_;
-  std::vector<std::optional<int>> flat_indices_;
+  int size_;
+  std::vector<IndexRun> runs_;
 };
 
 template <>
@@ -93,12 +140,58 @@ void WriteStream<IndirectChunkIr>(std::ostream& stream,
 template <>
 IndirectChunkIr ReadStream<IndirectChunkIr>(std::istream& stream);
 
+// Elementwise product of frontend tensor gathers and a scalar. Lets a chain of
+// plaintext multiplies be folded into a single plaintext that is only
+// materialized when it gets encoded.
+class ProductChunkIr {
+ public:
+  ProductChunkIr(std::vector<IndirectChunkIr>&& factors, PtVal scalar);
+  PtChunk Resolve(const Dictionary<Tensor<PtVal>>& frontend_tensors) const;
+  void WriteStreamHelper(std::ostream& stream) const;
+  const std::vector<IndirectChunkIr>& Factors() const { return factors_; }
+  PtVal Scalar() const { return scalar_; }
+
+  friend bool operator==(const ProductChunkIr& lhs, const ProductChunkIr& rhs) {
+    return lhs.factors_ == rhs.factors_ && lhs.scalar_ == rhs.scalar_;
+  }
+
+ private:
+  std::vector<IndirectChunkIr> factors_;
+  PtVal scalar_;
+};
+
+template <>
+void WriteStream<ProductChunkIr>(std::ostream& stream, const ProductChunkIr& x);
+
+template <>
+ProductChunkIr ReadStream<ProductChunkIr>(std::istream& stream);
+
+class SumChunkIr;
+
 // nsamar: Using std::variant here because we want value semantics.
 // Specifically, IndirectChunkIr and DirectChunkIr are different types;
 // nonetheles, we want to keep them together in a container; so the only
 // alternative to std::variant is inheritence. But inheritence has pointer
 // semantics, which we don't want.
-using ChunkIr = std::variant<IndirectChunkIr, DirectChunkIr, ZeroChunkIr>;
+using ChunkIr = std::variant<IndirectChunkIr, DirectChunkIr, ZeroChunkIr,
+                             ProductChunkIr, SumChunkIr>;
+
+// Elementwise sum of other chunks; terms are held through shared_ptr because
+// ChunkIr is recursive through this type
+class SumChunkIr {
+ public:
+  explicit SumChunkIr(const std::vector<ChunkIr>& terms);
+  PtChunk Resolve(const Dictionary<Tensor<PtVal>>& frontend_tensors) const;
+  void WriteStreamHelper(std::ostream& stream) const;
+  const std::vector<std::shared_ptr<const ChunkIr>>& Terms() const {
+    return terms_;
+  }
+
+  friend bool operator==(const SumChunkIr& lhs, const SumChunkIr& rhs);
+
+ private:
+  std::vector<std::shared_ptr<const ChunkIr>> terms_;
+};
 
 template <>
 void WriteStream<ChunkIr>(std::ostream& stream, const ChunkIr& chunk);
@@ -111,4 +204,37 @@ PtChunk Resolve(const ChunkIr& chunk,
 
 }  // namespace fhelipe
 
+namespace std {
+
+// Content hashes, so that std::hash<fhelipe::ChunkIr> is defined as well
+
+template <>
+struct hash<fhelipe::ZeroChunkIr> {
+  std::size_t operator()(const fhelipe::ZeroChunkIr& chunk) const {
+    return hash<int>()(chunk.ChunkSize().value());
+  }
+};
+
+template <>
+struct hash<fhelipe::DirectChunkIr> {
+  std::size_t operator()(const fhelipe::DirectChunkIr& chunk) const;
+};
+
+template <>
+struct hash<fhelipe::IndirectChunkIr> {
+  std::size_t operator()(const fhelipe::IndirectChunkIr& chunk) const;
+};
+
+template <>
+struct hash<fhelipe::ProductChunkIr> {
+  std::size_t operator()(const fhelipe::ProductChunkIr& chunk) const;
+};
+
+template <>
+struct hash<fhelipe::SumChunkIr> {
+  std::size_t operator()(const fhelipe::SumChunkIr& chunk) const;
+};
+
+}  // namespace std
+
 #endif  // FHELIPE_CHUNK_IR_H_
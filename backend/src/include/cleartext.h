@@ -50,6 +50,7 @@ class Cleartext {
 
   Cleartext RotateC(int rotate_by) const;
   Cleartext RescaleC(LogScale rescale_amount) const;
+  Cleartext DropLevelC(Level level) const;
   Cleartext BootstrapC(Level usable_levels) const;
   ChunkSize GetChunkSize() const { return pt_chunk_.size(); }
 
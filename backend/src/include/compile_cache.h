@@ -0,0 +1,107 @@
+/** $lic$
+ * Copyright (C) 2023-2024 by Massachusetts Institute of Technology
+ *
+ * This file is part of the Fhelipe compiler.
+ *
+ * Fhelipe is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * Fhelipe is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>. 
+ */
+
+#ifndef FHELIPE_COMPILE_CACHE_H_
+#define FHELIPE_COMPILE_CACHE_H_
+
+#include <filesystem>
+#include <optional>
+#include <string>
+
+#include "content_hash.h"
+#include "ct_program.h"
+#include "dag_io.h"
+#include "filesystem_utils.h"
+#include "pass.h"
+#include "pass_utils.h"
+
+namespace fhelipe {
+
+// On-disk cache of pass outputs. Each entry is keyed by a hash chain over the
+// preprocessed program text and the name and settings of every pass that
+// produced it, so a change in one pass only invalidates that pass and the
+// ones after it.
+class CompileCache {
+ public:
+  explicit CompileCache(const std::filesystem::path& folder_path)
+      : folder_path_(folder_path) {}
+
+  static std::string ProgramKey(const std::string& preprocessed_code) {
+    return ContentHash(preprocessed_code);
+  }
+
+  template <class InputT, class OutputT>
+  static std::string OutputKey(const std::string& input_key,
+                               const Pass<InputT, OutputT>& pass) {
+    return ContentHash(input_key + '\n' + pass.GetPassName().String() + '\n' +
+                       pass.PassSettings());
+  }
+
+  // Cached CtPrograms have their chunks restored into exe_folder / kChIr
+  template <class T>
+  std::optional<T> Fetch(const std::string& key,
+                         const std::filesystem::path& exe_folder) const;
+  template <class T>
+  void Store(const std::string& key, const T& value) const;
+
+ private:
+  std::filesystem::path folder_path_;
+
+  std::filesystem::path EntryPath(const std::string& key) const {
+    return folder_path_ / key;
+  }
+  // Entries are written to a scratch folder and then renamed into place, so
+  // that interrupted or concurrent compiles never leave partial entries
+  std::filesystem::path BeginEntry(const std::string& key) const;
+  void CommitEntry(const std::string& key,
+                   const std::filesystem::path& scratch_path) const;
+};
+
+inline const std::string kCachedDag = "dag";
+
+template <class T>
+std::optional<T> CompileCache::Fetch(
+    const std::string& key, const std::filesystem::path& exe_folder) const {
+  (void)exe_folder;
+  if (!Exists(EntryPath(key))) {
+    return std::nullopt;
+  }
+  return ReadFile<T>(EntryPath(key) / kCachedDag);
+}
+
+template <class T>
+void CompileCache::Store(const std::string& key, const T& value) const {
+  if (Exists(EntryPath(key))) {
+    return;
+  }
+  auto scratch_path = BeginEntry(key);
+  WriteFile(scratch_path / kCachedDag, value);
+  CommitEntry(key, scratch_path);
+}
+
+template <>
+std::optional<ct_program::CtProgram> CompileCache::Fetch(
+    const std::string& key, const std::filesystem::path& exe_folder) const;
+
+template <>
+void CompileCache::Store(const std::string& key,
+                         const ct_program::CtProgram& value) const;
+
+}  // namespace fhelipe
+
+#endif  // FHELIPE_COMPILE_CACHE_H_
@@ -25,6 +25,7 @@
 #include "include/debug_info_archive.h"
 #include "io_utils.h"
 #include "latticpp/ckks/ciphertext.h"
+#include "pass_stats.h"
 #include "pass_utils.h"
 #include "program.h"
 
@@ -62,7 +63,8 @@ class CompiledProgram {
                   std::vector<std::pair<PassId, LevelingPassOutput>>&&
                       leveling_optimizer_dags,
                   std::vector<std::pair<PassId, CtOpOptimizerOutput>>&&
-                      ct_op_optimizer_dags);
+                      ct_op_optimizer_dags,
+                  std::vector<PassStats>&& pass_stats = {});
   std::string FrontendCode() const { return program_.Code(); }
 
   const PassName& LastPassName() const {
@@ -89,6 +91,9 @@ class CompiledProgram {
     return leveling_optimizer_dags_.back().first.GetPassName();
   }
 
+  // Empty for programs read back from disk
+  const std::vector<PassStats>& GetPassStats() const { return pass_stats_; }
+
  private:
   Program program_;
   std::pair<PassId, ParserOutput> input_dag_;
@@ -99,6 +104,7 @@ class CompiledProgram {
   std::vector<std::pair<PassId, CtOpOptimizerOutput>> ct_op_optimizer_dags_;
 
   std::vector<std::pair<PassId, DebugInfoArchive>> archives_;
+  std::vector<PassStats> pass_stats_;
 
   std::vector<DebugInfoArchive> GetDebugInfoArchivesBetween(
       const PassName& source_pass, const PassName& destination_pass) const;
@@ -181,14 +187,36 @@ class CompiledProgramBuilder {
                                   const Program& program)
       : compiler_(compiler), program_(program) {}
 
+  // Resets the profiler, so that work done outside of passes is not
+  // attributed to the next recorded pass
+  void StartPass() { profiler_.Restart(); }
+
+  // Records the output of a pass together with the time and memory used since
+  // the previous StartPass() or RecordPass()
   template <typename OutputT>
   OutputT* RecordPass(const PassName& pass_ptr, OutputT&& output);
 
+  // Like RecordPass(), but only keeps the statistics, for passes whose output
+  // is overwritten by a later pass (preprocessors and embrio optimizers).
+  // Statistics are indexed by the order the passes ran in, so they can run
+  // ahead of the PassIds of the kept DAGs.
+  void RecordPassStats(const PassName& pass_name) {
+    pass_stats_.emplace_back(pass_stats_.size(), pass_name, profiler_);
+    profiler_.Restart();
+  }
+  template <typename OutputT>
+  void RecordPassStats(const PassName& pass_name, const OutputT& output) {
+    pass_stats_.emplace_back(pass_stats_.size(), pass_name, profiler_, output);
+    profiler_.Restart();
+  }
+
   CompiledProgram GetCompiledProgram();
 
  private:
   const Compiler* compiler_;
   int pass_count_ = 0;
+  PassProfiler profiler_;
+  std::vector<PassStats> pass_stats_;
 
   Program program_;
   std::optional<std::pair<PassId, ParserOutput>> input_dag_ = std::nullopt;
@@ -208,6 +236,7 @@ inline ParserOutput* CompiledProgramBuilder::RecordPass<ParserOutput>(
     const PassName& pass_name, ParserOutput&& output) {
   input_dag_ =
       std::make_pair(PassId(pass_count_++, pass_name), std::move(output));
+  RecordPassStats(input_dag_->first.GetPassName(), input_dag_->second);
   return &input_dag_.value().second;
 }
 
@@ -217,6 +246,8 @@ CompiledProgramBuilder::RecordPass<LayoutOptimizerOutput>(
     const PassName& pass_name, LayoutOptimizerOutput&& output) {
   layout_optimizer_dags_.emplace_back(
       std::make_pair(PassId(pass_count_++, pass_name), std::move(output)));
+  RecordPassStats(layout_optimizer_dags_.back().first.GetPassName(),
+                  layout_optimizer_dags_.back().second);
   return &layout_optimizer_dags_.back().second;
 }
 
@@ -226,6 +257,8 @@ CompiledProgramBuilder::RecordPass<RescalingPassOutput>(
     const PassName& pass_name, RescalingPassOutput&& output) {
   rescaling_pass_dag_ =
       std::make_pair(PassId(pass_count_++, pass_name), std::move(output));
+  RecordPassStats(rescaling_pass_dag_->first.GetPassName(),
+                  rescaling_pass_dag_->second);
   return &rescaling_pass_dag_.value().second;
 }
 
@@ -235,6 +268,8 @@ CompiledProgramBuilder::RecordPass<LevelingOptimizerOutput>(
     const PassName& pass_name, LevelingOptimizerOutput&& output) {
   leveling_optimizer_dags_.emplace_back(
       std::make_pair(PassId(pass_count_++, pass_name), std::move(output)));
+  RecordPassStats(leveling_optimizer_dags_.back().first.GetPassName(),
+                  leveling_optimizer_dags_.back().second);
   return &leveling_optimizer_dags_.back().second;
 }
 
@@ -244,6 +279,8 @@ CompiledProgramBuilder::RecordPass<CtOpOptimizerOutput>(
     const PassName& pass_name, CtOpOptimizerOutput&& output) {
   ct_op_optimizer_dags_.emplace_back(
       std::make_pair(PassId(pass_count_++, pass_name), std::move(output)));
+  RecordPassStats(ct_op_optimizer_dags_.back().first.GetPassName(),
+                  ct_op_optimizer_dags_.back().second);
   return &ct_op_optimizer_dags_.back().second;
 }
 
@@ -253,7 +290,8 @@ inline CompiledProgram CompiledProgramBuilder::GetCompiledProgram() {
           std::move(layout_optimizer_dags_),
           std::move(rescaling_pass_dag_.value()),
           std::move(leveling_optimizer_dags_),
-          std::move(ct_op_optimizer_dags_)};
+          std::move(ct_op_optimizer_dags_),
+          std::move(pass_stats_)};
 }
 
 template <>
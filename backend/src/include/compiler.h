@@ -20,10 +20,13 @@
 #define FHELIPE_COMPILER_H_
 
 #include <memory>
+#include <optional>
+#include <string>
 #include <vector>
 
 #include "gtest/gtest.h"
 
+#include "compile_cache.h"
 #include "compiled_program.h"
 #include "leveled_t_op.h"
 #include "pass.h"
@@ -45,11 +48,24 @@ class Compiler {
            std::unique_ptr<LevelingPass>&& leveling_pass,
            OwningVector<LevelingOptimizer>&& leveling_optimizers,
            std::unique_ptr<CtOpPass>&& ct_op_pass,
-           OwningVector<CtOpOptimizer>&& ct_op_optimizers);
+           OwningVector<CtOpOptimizer>&& ct_op_optimizers,
+           std::optional<CompileCache>&& cache = std::nullopt);
 
   CompiledProgram Compile(const Program& program);
 
  private:
+  struct CacheState {
+    std::filesystem::path exe_folder;
+    std::string key;
+    // Cleared on the first miss: later passes are then rerun even if cached,
+    // so that their ancestor node ids match the freshly computed inputs
+    bool all_hits;
+  };
+
+  template <class InputT, class OutputT>
+  OutputT RunPass(Pass<InputT, OutputT>& pass, const InputT& input,
+                  CacheState& cache_state) const;
+
   OwningVector<Preprocessor> preprocessors_;
   std::unique_ptr<Parser> parser_;
   OwningVector<EmbrioOptimizer> embrio_optimizers_;
@@ -60,13 +76,37 @@ class Compiler {
   OwningVector<LevelingOptimizer> leveling_optimizers_;
   std::unique_ptr<CtOpPass> ct_op_pass_;
   OwningVector<CtOpOptimizer> ct_op_optimizers_;
+  std::optional<CompileCache> cache_;
 };
 
+template <class InputT, class OutputT>
+OutputT Compiler::RunPass(Pass<InputT, OutputT>& pass, const InputT& input,
+                          CacheState& cache_state) const {
+  cache_state.key = CompileCache::OutputKey(cache_state.key, pass);
+  if (!cache_) {
+    return pass.DoPass(input);
+  }
+  if (cache_state.all_hits) {
+    auto cached =
+        cache_->Fetch<OutputT>(cache_state.key, cache_state.exe_folder);
+    if (cached) {
+      LOG(INFO) << "Compile cache hit for " << pass.GetPassName().String();
+      return std::move(cached.value());
+    }
+    cache_state.all_hits = false;
+  }
+  auto output = pass.DoPass(input);
+  cache_->Store(cache_state.key, output);
+  return output;
+}
+
 class CompilerBuilder {
  public:
   template <typename PassT>
   void AddPass(const PassT& pass) = delete;
 
+  void SetCompileCache(const CompileCache& cache) { cache_ = cache; }
+
   Compiler GetCompiler();
 
  private:
@@ -80,6 +120,7 @@ class CompilerBuilder {
   OwningVector<LevelingOptimizer> leveling_optimizers_;
   std::unique_ptr<CtOpPass> ct_op_pass_;
   OwningVector<CtOpOptimizer> ct_op_optimizers_;
+  std::optional<CompileCache> cache_;
 };
 
 template <>
@@ -44,7 +44,11 @@ static const std::string kOutUnencClear = "out_unenc_clear";
 
 static const std::string kZeroCtName = "ZEROS";
 static const std::string kMaskChunkIrKeyword = "MASK";
+static const std::string kMaskRunsChunkIrKeyword = "MASK_RUNS";
 static const std::string kIndirectChunkIrKeyword = "INDIRECTION";
+static const std::string kIndirectRunsChunkIrKeyword = "INDIRECTION_RUNS";
+static const std::string kProductChunkIrKeyword = "PRODUCT";
+static const std::string kSumChunkIrKeyword = "SUM";
 
 static const std::string kDslBootstrapC = "BootstrapC";
 static const std::string kDslChetRepackC = "ChetRepackC";
@@ -71,6 +75,7 @@ static const std::string kDslCyclicShiftC = "RotateC";
 static const int kPrintDoublePrecision = 60;
 
 static const std::string kCompiledProgram = "CompiledProgram";
+static const std::string kCompileStats = "compile_stats.json";
 
 static const LogChunkSize kDefaultLogChunkSize = 15;
 static const int kDefaultLogScale = 50;
@@ -0,0 +1,31 @@
+/** $lic$
+ * Copyright (C) 2023-2024 by Massachusetts Institute of Technology
+ *
+ * This file is part of the Fhelipe compiler.
+ *
+ * Fhelipe is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * Fhelipe is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>. 
+ */
+
+#ifndef FHELIPE_CONTENT_HASH_H_
+#define FHELIPE_CONTENT_HASH_H_
+
+#include <string>
+
+namespace fhelipe {
+
+// Hex digest of `content`, stable across runs and platforms
+std::string ContentHash(const std::string& content);
+
+}  // namespace fhelipe
+
+#endif  // FHELIPE_CONTENT_HASH_H_
@@ -38,6 +38,9 @@ class ConversionDecomposerPass : public LayoutOptimizer {
     static PassName pass_name("conversion_decomposer_pass");
     return pass_name;
   }
+  std::string PassSettings() const final {
+    return std::to_string(max_tentacles_per_conversion_);
+  }
 
   std::unique_ptr<LayoutOptimizer> CloneUniq() const final {
     return std::make_unique<ConversionDecomposerPass>(
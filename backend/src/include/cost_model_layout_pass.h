@@ -0,0 +1,66 @@
+/** $lic$
+ * Copyright (C) 2023-2024 by Massachusetts Institute of Technology
+ *
+ * This file is part of the Fhelipe compiler.
+ *
+ * Fhelipe is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * Fhelipe is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>. 
+ */
+
+#ifndef FHELIPE_COST_MODEL_LAYOUT_PASS_H_
+#define FHELIPE_COST_MODEL_LAYOUT_PASS_H_
+
+#include <memory>
+#include <string>
+
+#include "layout_cost_model.h"
+#include "pass_utils.h"
+#include "program_context.h"
+
+namespace fhelipe {
+
+// Assigns layouts that minimize the total cost of a LayoutCostModel, layout
+// conversions included, instead of matching layouts greedily node by node.
+// Inputs try every order of their dimensions and every other node the layouts
+// its parents' candidates produce, keeping the cheapest few. A dynamic program
+// in topological order picks candidates, which is exact wherever every node
+// has a single consumer; a node with several consumers charges each a share
+// of its cost, and a bounded local search then re-picks one node at a time
+// while that lowers the total. Output layouts follow FillGapsLayoutPass, and
+// chet repacks are ignored as in FillGapsLayoutPass.
+class CostModelLayoutPass : public LayoutPass {
+ public:
+  CostModelLayoutPass(const ProgramContext& context,
+                      std::unique_ptr<LayoutCostModel>&& cost_model)
+      : context_(context), cost_model_(std::move(cost_model)) {}
+  LayoutPassOutput DoPass(const LayoutPassInput& in_dag) final;
+
+  const PassName& GetPassName() const final {
+    static PassName pass_name("cost_model_layout_pass");
+    return pass_name;
+  }
+  std::string PassSettings() const final {
+    return ToString(context_) + " " + cost_model_->Name();
+  }
+  std::unique_ptr<LayoutPass> CloneUniq() const final {
+    return std::make_unique<CostModelLayoutPass>(context_,
+                                                 cost_model_->CloneUniq());
+  }
+
+ private:
+  ProgramContext context_;
+  std::unique_ptr<LayoutCostModel> cost_model_;
+};
+
+}  // namespace fhelipe
+
+#endif  // FHELIPE_COST_MODEL_LAYOUT_PASS_H_
@@ -35,6 +35,7 @@ class InputC;
 class RescaleC;
 class OutputC;
 class BootstrapC;
+class DropLevelC;
 
 class CtOpVisitor {
  public:
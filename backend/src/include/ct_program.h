@@ -76,10 +76,23 @@ class CtProgram {
   std::shared_ptr<Node<CtOp>> AddNode(
       int node_id, std::unique_ptr<CtOp>&& new_node,
       const std::vector<std::shared_ptr<Node<CtOp>>>& parents);
+  std::shared_ptr<Node<CtOp>> AddNode(
+      std::unique_ptr<CtOp>&& new_node,
+      const std::vector<std::shared_ptr<Node<CtOp>>>& parents,
+      const std::vector<int>& ancestors);
+  // Returns the key of an identical, previously recorded chunk if there is one
   KeyType RecordChunk(const ChunkIr& chunk);
-  ChunkIr GetChunkIr(const KeyType& key) const { return chunk_dict_->At(key); }
+  // Not readable under --avoid_writes if the dictionary is persisted
+  ChunkIr GetChunkIr(const KeyType& key) const;
+  // Keys of the distinct chunks recorded through RecordChunk, in the order
+  // they were first recorded
+  const std::vector<KeyType>& RecordedChunkKeys() const {
+    return recorded_chunk_keys_;
+  }
 
   Dictionary<ChunkIr>* ChunkDictionary() const { return chunk_dict_.get(); }
+  // A program with this program's context and chunks, and `dag`
+  CtProgram WithDag(Dag<CtOp>&& dag) const;
 
   std::vector<std::shared_ptr<Node<CtOp>>> NodesInTopologicalOrder() const;
   const ProgramContext& GetProgramContext() const { return ct_param_; }
@@ -92,6 +105,10 @@ class CtProgram {
   Dag<CtOp> ct_op_dag_;
   std::set<IoSpec> io_specs_;
   std::unique_ptr<Dictionary<ChunkIr>> chunk_dict_;
+  // ContentHash of the serialized chunk -> key of a chunk recorded through
+  // RecordChunk
+  std::unordered_map<std::string, KeyType> chunk_keys_by_digest_;
+  std::vector<KeyType> recorded_chunk_keys_;
 
   void RegisterNewIoNode(const IoC* ioc);
   void RegisterAddedNode(const CtOp& new_node);
@@ -103,12 +120,18 @@ inline void CtProgram::RegisterNewIoNode(const IoC* ioc) {
   io_specs_.insert(ioc->GetIoSpec());
 }
 
+// `ct_op` with its plaintext handle, if it has one, renamed through `keys`
+std::unique_ptr<CtOp> WithChunkKeys(
+    const CtOp& ct_op, const std::unordered_map<KeyType, KeyType>& keys);
+
 std::shared_ptr<Node<CtOp>> CreateInputC(CtProgram& ct_program,
                                          const LevelInfo& level_info,
                                          const IoSpec& io_spec);
 
 std::shared_ptr<Node<CtOp>> FetchZeroC(const std::shared_ptr<Node<CtOp>>& node,
                                        const LevelInfo& level_info);
+std::shared_ptr<Node<CtOp>> FetchZeroC(CtProgram& ct_program,
+                                       const LevelInfo& level_info);
 
 std::shared_ptr<Node<CtOp>> CreateOutputC(
     CtProgram& ct_program, const LevelInfo& level_info, const IoSpec& io_spec,
@@ -168,8 +191,12 @@ inline std::shared_ptr<Node<CtOp>> CtProgram::AddNode(
   return ct_op_dag_.AddNode(std::move(new_node), parents);
 }
 
-inline KeyType CtProgram::RecordChunk(const ChunkIr& chunk) {
-  return chunk_dict_->Record(chunk);
+inline std::shared_ptr<Node<CtOp>> CtProgram::AddNode(
+    std::unique_ptr<CtOp>&& new_node,
+    const std::vector<std::shared_ptr<Node<CtOp>>>& parents,
+    const std::vector<int>& ancestors) {
+  RegisterAddedNode(*new_node);
+  return ct_op_dag_.AddNode(std::move(new_node), parents, ancestors);
 }
 
 void WriteSchedulableDataflowGraph(
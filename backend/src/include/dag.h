@@ -22,7 +22,9 @@
 #include <glog/logging.h>
 
 #include <algorithm>
+#include <cstdint>
 #include <memory>
+#include <optional>
 #include <queue>
 #include <set>
 #include <sstream>
@@ -89,8 +91,15 @@ class Dag {
   std::shared_ptr<Node<T>> sentinel_;
 
   mutable std::unordered_map<int, std::shared_ptr<Node<T>>> node_id_map_;
+  mutable std::optional<uint64_t> node_id_map_epoch_;
+
+  // Valid as long as no Node<T> edge was mutated since it was computed, see
+  // Node<T>::TopologyEpoch()
+  mutable std::vector<std::shared_ptr<Node<T>>> topological_order_;
+  mutable std::optional<uint64_t> topological_order_epoch_;
 
   void RebuildNodeIdMap() const;
+  std::vector<std::shared_ptr<Node<T>>> ComputeTopologicalOrder() const;
 };
 
 template <class T>
@@ -136,6 +145,7 @@ void Dag<T>::RebuildNodeIdMap() const {
   for (const auto& node : NodesInTopologicalOrder()) {
     node_id_map_.emplace(node->NodeId(), node);
   }
+  node_id_map_epoch_ = Node<T>::TopologyEpoch();
 }
 
 template <class T>
@@ -143,7 +153,10 @@ std::shared_ptr<Node<T>> Dag<T>::GetNodeById(int node_id) const {
   if (Estd::contains_key(node_id_map_, node_id)) {
     return node_id_map_.at(node_id);
   }
-  RebuildNodeIdMap();
+  // A rebuild can only help if nodes were added since the last one
+  if (node_id_map_epoch_ != Node<T>::TopologyEpoch()) {
+    RebuildNodeIdMap();
+  }
   return node_id_map_.at(node_id);
 }
 
@@ -197,13 +210,6 @@ std::shared_ptr<Node<T>> Dag<T>::AddNode(
   return AddNode(node_id, std::move(new_node), parents, {});
 }
 
-template <class T>
-bool AllParentsVisited(const VisitedNodes<T>& visited, const Node<T>& node) {
-  return Estd::all_of(node.Parents(), [&visited](const auto& parent) {
-    return visited.IsVisited(*parent);
-  });
-}
-
 template <class T>
 std::vector<std::shared_ptr<Node<T>>> Dag<T>::NodesInReverseTopologicalOrder()
     const {
@@ -229,12 +235,40 @@ std::vector<std::shared_ptr<Node<T>>> Dag<T>::NodesInAncestorIdOrder() const {
 
 template <class T>
 std::vector<std::shared_ptr<Node<T>>> Dag<T>::NodesInTopologicalOrder() const {
+  if (topological_order_epoch_ != Node<T>::TopologyEpoch()) {
+    topological_order_ = ComputeTopologicalOrder();
+    topological_order_epoch_ = Node<T>::TopologyEpoch();
+  }
+  return topological_order_;
+}
+
+template <class T>
+std::vector<std::shared_ptr<Node<T>>> Dag<T>::ComputeTopologicalOrder() const {
+  // Give every node reachable from the sentinel a dense index, so that the
+  // sort itself only does O(1) lookups per edge
+  std::unordered_map<const Node<T>*, int> dense_idx{{sentinel_.get(), 0}};
+  std::vector<const Node<T>*> reachable{sentinel_.get()};
+  for (int idx = 0; idx < reachable.size(); ++idx) {
+    for (const auto& child : reachable.at(idx)->Children()) {
+      if (dense_idx.emplace(child.get(), reachable.size()).second) {
+        reachable.push_back(child.get());
+      }
+    }
+  }
+
+  // Number of distinct non-sentinel parents that were not yet enqueued
+  std::vector<int> unqueued_parents(reachable.size(), 0);
+  for (int idx = 1; idx < reachable.size(); ++idx) {
+    for (const auto& child : reachable.at(idx)->Children()) {
+      ++unqueued_parents.at(dense_idx.at(child.get()));
+    }
+  }
+
   std::vector<std::shared_ptr<Node<T>>> nodes;
+  std::vector<bool> visited(reachable.size(), false);
   std::queue<std::shared_ptr<Node<T>>> frontier;
   frontier.push(sentinel_);
-
-  VisitedNodes<T> visited;
-  visited.Set(*sentinel_);
+  visited.at(0) = true;
 
   // Topo sort
   while (!frontier.empty()) {
@@ -244,10 +278,21 @@ std::vector<std::shared_ptr<Node<T>>> Dag<T>::NodesInTopologicalOrder() const {
       nodes.push_back(vertex);
     }
 
-    for (auto child : vertex->Children()) {
-      if (AllParentsVisited(visited, *child) && !visited.IsVisited(*child)) {
+    // Children are held in pointer order; visiting them in id order keeps the
+    // result independent of where the nodes happen to be allocated
+    auto children = Estd::set_to_vector(vertex->Children());
+    std::sort(children.begin(), children.end(),
+              [](const auto& lhs, const auto& rhs) {
+                return lhs->NodeId() < rhs->NodeId();
+              });
+    for (const auto& child : children) {
+      int child_idx = dense_idx.at(child.get());
+      if (unqueued_parents.at(child_idx) == 0 && !visited.at(child_idx)) {
         frontier.push(child);
-        visited.Set(*child);
+        visited.at(child_idx) = true;
+        for (const auto& grandchild : child->Children()) {
+          --unqueued_parents.at(dense_idx.at(grandchild.get()));
+        }
       }
     }
   }
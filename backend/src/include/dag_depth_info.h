@@ -19,93 +19,112 @@
 #ifndef FHELIPE_DAG_DEPTH_INFO_H_
 #define FHELIPE_DAG_DEPTH_INFO_H_
 
+#include <cstdint>
 #include <memory>
+#include <set>
+#include <unordered_map>
+#include <vector>
 
 #include "dag.h"
 #include "scaled_t_op.h"
 
 namespace fhelipe {
 
-template <class T>
-class DirectedEdge {
+// Set of the integers [0, size)
+class DenseBitset {
  public:
-  DirectedEdge(const std::shared_ptr<Node<T>>& parent,
-               const std::shared_ptr<Node<T>>& child)
-      : parent_(parent), child_(child) {}
+  explicit DenseBitset(int size = 0)
+      : words_((size + kWordBits - 1) / kWordBits) {}
 
-  const std::shared_ptr<const Node<T>>& Parent() const { return parent_; }
-  const std::shared_ptr<const Node<T>>& Child() const { return child_; }
+  void Set(int idx) { words_.at(idx / kWordBits) |= Bit(idx); }
+  void Reset(int idx) { words_.at(idx / kWordBits) &= ~Bit(idx); }
+  bool Test(int idx) const {
+    return (words_.at(idx / kWordBits) & Bit(idx)) != 0;
+  }
+  // Elements of *this that are not in `other`, in increasing order
+  std::vector<int> Difference(const DenseBitset& other) const;
 
  private:
-  std::shared_ptr<const Node<T>> parent_;
-  std::shared_ptr<const Node<T>> child_;
-};
-
-template <class T>
-bool operator<(const DirectedEdge<T>& lhs, const DirectedEdge<T>& rhs) {
-  // Lexicographic
-  return lhs.Parent() < rhs.Parent() ||
-         (lhs.Parent() == rhs.Parent() && lhs.Child() < rhs.Child());
-}
+  static constexpr int kWordBits = 64;
+  static uint64_t Bit(int idx) { return uint64_t{1} << (idx % kWordBits); }
 
-template <class T>
-bool operator==(const DirectedEdge<T>& lhs, const DirectedEdge<T>& rhs) {
-  return lhs.Parent() == rhs.Parent() && lhs.Child() == rhs.Child();
-}
+  std::vector<uint64_t> words_;
+};
 
 typedef std::unordered_map<const Node<ScaledTOp>*, int> DepthMap;
-typedef std::vector<std::set<const Node<ScaledTOp>*>> FrontierMap;
-typedef std::vector<std::set<DirectedEdge<ScaledTOp>>>
-    EdgesIntersectingFrontierMap;
 
+// Depths are counted in TRescaleCs. The frontier at a depth is the set of
+// chokepoints of the nodes at that depth, and an edge crosses the frontiers
+// strictly between its ends, plus the one at its child's depth if the child
+// comes after that frontier.
 class DagDepthInfo {
  public:
   explicit DagDepthInfo(const Dag<ScaledTOp>& dag);
   int NodeDepth(const Node<ScaledTOp>* node) const {
-    return depth_map_.at(node);
+    return depths_.at(DenseIndex(node));
   }
   int DagDepth() const { return dag_depth_; }
   // TODO(nsamar): Implement MinCutAtDepth()
-  std::set<const Node<ScaledTOp>*> Frontier(int depth) const {
-    return frontier_map_.at(depth);
+  const std::set<const Node<ScaledTOp>*>& Frontier(int depth) const {
+    return frontiers_.at(depth);
+  }
+  bool OnFrontier(int depth, const Node<ScaledTOp>& node) const {
+    return frontier_bits_.at(depth).Test(DenseIndex(&node));
   }
-  std::set<DirectedEdge<ScaledTOp>> EdgesIntersectingFrontier(int depth) const {
-    return edges_intersecting_frontier_.at(depth);
+  int FrontierSize(int depth) const { return frontiers_.at(depth).size(); }
+  int FrontierCiphertextCount(int depth) const {
+    return frontier_ciphertext_counts_.at(depth);
   }
-  int FrontierSize(int depth) const { return frontier_map_.at(depth).size(); }
+  // Whether `node` comes after the frontier at its own depth
+  bool IsAfterOwnFrontier(const Node<ScaledTOp>* node) const {
+    return after_own_frontier_.Test(DenseIndex(node));
+  }
+  // Parents of the edges that cross frontier `i` but not frontier `j`
+  std::set<const Node<ScaledTOp>*> Sc(int i, int j) const;
   const DepthMap& GetDepthMap() const { return depth_map_; }
 
  private:
-  static FrontierMap ConstructFrontierMap(const DepthMap& depth_map,
-                                          int dag_depth);
-  static DepthMap ConstructDepthMap(const Dag<ScaledTOp>& dag);
-  static int ConstructDagDepth(const DepthMap& depth_map);
-  static EdgesIntersectingFrontierMap ConstructEdgesIntersectingFrontier(
-      const Dag<ScaledTOp>& dag, const FrontierMap& frontier_map,
-      const DepthMap& depth_map, int dag_depth);
-
-  const Dag<ScaledTOp>* dag_;
+  int DenseIndex(const Node<ScaledTOp>* node) const {
+    return dense_indices_.at(node);
+  }
+
+  void ConstructFrontiers();
+  void ConstructAfterOwnFrontier(
+      const std::vector<std::shared_ptr<Node<ScaledTOp>>>& nodes);
+  void ConstructCrossingEdges(
+      const std::vector<std::shared_ptr<Node<ScaledTOp>>>& nodes);
+
+  // Dense index -> node. Dense indices follow node addresses, so walking a
+  // bitset visits nodes in the order of a std::set<const Node<ScaledTOp>*>.
+  std::vector<const Node<ScaledTOp>*> nodes_;
+  std::unordered_map<const Node<ScaledTOp>*, int> dense_indices_;
   DepthMap depth_map_;
-  int dag_depth_;
-  FrontierMap frontier_map_;
-  EdgesIntersectingFrontierMap edges_intersecting_frontier_;
+  std::vector<int> depths_;
+  int dag_depth_ = 0;
+  std::vector<std::set<const Node<ScaledTOp>*>> frontiers_;
+  std::vector<DenseBitset> frontier_bits_;
+  std::vector<int> frontier_ciphertext_counts_;
+  DenseBitset after_own_frontier_;
+  // Edge -> dense index of its parent, for the edges that cross any frontier
+  std::vector<int> edge_parents_;
+  // Depth -> edges that cross the frontier at that depth
+  std::vector<DenseBitset> crossing_edges_;
 };
 
 // TODO(nsamar): Make better name
-std::set<const Node<ScaledTOp>*> Sc(const DagDepthInfo& dag, int i, int j);
-int ScCount(const DagDepthInfo& dag, int i, int j);
+inline std::set<const Node<ScaledTOp>*> Sc(const DagDepthInfo& dag, int i,
+                                           int j) {
+  return dag.Sc(i, j);
+}
+inline int ScCount(const DagDepthInfo& dag, int i, int j) {
+  return Sc(dag, i, j).size();
+}
 
-bool EdgeIntersectsFrontier(const DagDepthInfo& dag, int frontier,
-                            const DirectedEdge<ScaledTOp>& edge);
 inline bool NodeOnFrontier(const DagDepthInfo& dag, int frontier,
                            const Node<ScaledTOp>& node) {
-  return Estd::contains(dag.Frontier(frontier), &node);
+  return dag.OnFrontier(frontier, node);
 }
 
-bool IsAfterFrontier(const Node<ScaledTOp>* node,
-                     const std::set<const Node<ScaledTOp>*>& frontier,
-                     const DepthMap& depth_map);
-
 }  // namespace fhelipe
 
 #endif  // FHELIPE_DAG_DEPTH_INFO_H_
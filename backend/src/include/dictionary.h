@@ -81,7 +81,11 @@ ReadStream(std::istream& stream) {
 template <class ValueType>
 KeyType Dictionary<ValueType>::Record(const ValueType& value) {
   static std::atomic<int> curr_idx = 0;
-  auto key = "__" + std::to_string(++curr_idx);
+  // Skip keys minted by other processes, e.g., restored from a compile cache
+  KeyType key;
+  do {
+    key = "__" + std::to_string(++curr_idx);
+  } while (Contains(key));
   Record(key, value);
   return key;
 }
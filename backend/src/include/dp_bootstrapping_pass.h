@@ -19,6 +19,7 @@
 #ifndef FHELIPE_DP_BOOTSTRAPPING_PASS_H_
 #define FHELIPE_DP_BOOTSTRAPPING_PASS_H_
 
+#include <string>
 #include <unordered_map>
 #include <vector>
 
@@ -47,22 +48,31 @@ class TOpEmbrio;
 class ScaledTOp;
 class LeveledTOp;
 
+// Picks the frontiers to bootstrap at with a dynamic program over the depths
+// of the dag. Once `max_states` candidate transitions have been evaluated
+// (never if 0), every remaining depth only evaluates the few most promising
+// ones.
 class DpBootstrappingPass : public LevelingPass {
  public:
-  explicit DpBootstrappingPass(const ProgramContext& context)
-      : context_(context) {}
+  explicit DpBootstrappingPass(const ProgramContext& context,
+                               int max_states = 0)
+      : context_(context), max_states_(max_states) {}
   LevelingPassOutput DoPass(const LevelingPassInput& in_dag) final;
 
   const PassName& GetPassName() const final {
     static PassName pass_name("dp_bootstrapping_pass");
     return pass_name;
   }
+  std::string PassSettings() const final {
+    return ToString(context_) + " " + std::to_string(max_states_);
+  }
   std::unique_ptr<LevelingPass> CloneUniq() const final {
-    return std::make_unique<DpBootstrappingPass>(context_);
+    return std::make_unique<DpBootstrappingPass>(context_, max_states_);
   }
 
  private:
   ProgramContext context_;
+  int max_states_;
 };
 
 }  // namespace fhelipe
@@ -0,0 +1,77 @@
+/** $lic$
+ * Copyright (C) 2023-2024 by Massachusetts Institute of Technology
+ *
+ * This file is part of the Fhelipe compiler.
+ *
+ * Fhelipe is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * Fhelipe is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>. 
+ */
+
+#ifndef FHELIPE_DROP_LEVEL_C_H_
+#define FHELIPE_DROP_LEVEL_C_H_
+
+#include "ct_op.h"
+#include "ct_op_visitor.h"
+#include "level_info.h"
+
+namespace fhelipe {
+
+class DropLevelC;
+
+template <>
+void WriteStream<DropLevelC>(std::ostream& stream, const DropLevelC& node);
+
+// Mod-switches its input down to GetLevel() without changing the scale
+class DropLevelC final : public CtOp {
+ public:
+  explicit DropLevelC(const LevelInfo& level_info);
+
+  std::unique_ptr<CtOp> CloneUniq() const final {
+    return std::make_unique<DropLevelC>(GetLevelInfo());
+  }
+  const std::string& TypeName() const final { return StaticTypeName(); }
+  void WriteStreamHelper(std::ostream& stream) const final {
+    WriteStream<DropLevelC>(stream, *this);
+  }
+  static const std::string& StaticTypeName() {
+    static const std::string type_name_ = "DropLevelC";
+    return type_name_;
+  }
+
+ private:
+  static CtOpDerivedRegistrar<DropLevelC> reg_;
+};
+
+inline DropLevelC::DropLevelC(const LevelInfo& level_info)
+    : CtOp(level_info) {}
+
+inline CtOpDerivedRegistrar<DropLevelC> DropLevelC::reg_{
+    DropLevelC::StaticTypeName()};
+
+template <>
+inline void WriteStream<DropLevelC>(std::ostream& stream,
+                                    const DropLevelC& node) {
+  WriteStream<std::string>(stream, DropLevelC::StaticTypeName());
+  stream << " ";
+  WriteStream<LevelInfo>(stream, node.GetLevelInfo());
+}
+
+template <>
+inline DropLevelC ReadStreamWithoutTypeNamePrefix<DropLevelC>(
+    std::istream& stream) {
+  auto level_info = ReadStream<LevelInfo>(stream);
+  return DropLevelC{level_info};
+}
+
+}  // namespace fhelipe
+
+#endif  // FHELIPE_DROP_LEVEL_C_H_
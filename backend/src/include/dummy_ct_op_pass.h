@@ -39,6 +39,7 @@ class DummyCtOpPass : public CtOpPass {
     static PassName pass_name("dummy_ct_op_pass");
     return pass_name;
   }
+  std::string PassSettings() const final { return ToString(context_); }
 
   std::unique_ptr<CtOpPass> CloneUniq() const final {
     return std::make_unique<DummyCtOpPass>(context_, chunk_dict_->CloneUniq());
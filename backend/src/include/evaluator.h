@@ -19,15 +19,19 @@
 #ifndef FHELIPE_EVALUATOR_H_
 #define FHELIPE_EVALUATOR_H_
 
+#include <algorithm>
 #include <iostream>
+#include <optional>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "add_cc.h"
 #include "add_cp.h"
 #include "add_cs.h"
 #include "bootstrap_c.h"
+#include "drop_level_c.h"
 #include "ct_op_visitor.h"
 #include "ct_program.h"
 #include "include/extended_std.h"
@@ -92,7 +96,11 @@ class Evaluator : public CtOpVisitor {
                    const std::vector<const CtOp*>& parents);
   CtType VisitImpl(const BootstrapC& node,
                    const std::vector<const CtOp*>& parents);
+  CtType VisitImpl(const DropLevelC& node,
+                   const std::vector<const CtOp*>& parents);
   CtType VisitImpl(const ZeroC& node, const std::vector<const CtOp*>& parents);
+  std::optional<CtType> FoldZero(const CtOp& node,
+                                 const std::vector<const CtOp*>& parents);
   void UpdateParentReferenceCounts(const Node<CtOp>& node);
   void InitializeReferenceCounts();
 
@@ -104,9 +112,50 @@ class Evaluator : public CtOpVisitor {
   const ct_program::CtProgram& ct_program_;
   std::unordered_map<const CtOp*, CtType> node_map_;
   std::unordered_map<const CtOp*, int> reference_count_;
+  // Nodes whose value is known to be an encryption of zero
+  std::unordered_set<const CtOp*> zero_nodes_;
   std::unique_ptr<Dictionary<CtType>> outputs_;
 };
 
+// Treats zero as a constant: operations that map zero to zero produce a
+// (cached) zero ciphertext without touching their inputs, and AddCC with a
+// zero operand forwards the other operand.
+template <class CtType>
+std::optional<CtType> Evaluator<CtType>::FoldZero(
+    const CtOp& node, const std::vector<const CtOp*>& parents) {
+  auto is_zero = [this](const CtOp* parent) {
+    return zero_nodes_.contains(parent);
+  };
+  if (dynamic_cast<const ZeroC*>(&node)) {
+    zero_nodes_.insert(&node);
+    return std::nullopt;
+  }
+  if (dynamic_cast<const AddCC*>(&node)) {
+    if (!is_zero(parents.at(0)) && !is_zero(parents.at(1))) {
+      return std::nullopt;
+    }
+    if (is_zero(parents.at(0)) && is_zero(parents.at(1))) {
+      zero_nodes_.insert(&node);
+    }
+    return node_map_.at(is_zero(parents.at(0)) ? parents.at(1)
+                                               : parents.at(0));
+  }
+  if (!dynamic_cast<const MulCC*>(&node) &&
+      !dynamic_cast<const MulCP*>(&node) &&
+      !dynamic_cast<const MulCS*>(&node) &&
+      !dynamic_cast<const RotateC*>(&node) &&
+      !dynamic_cast<const RescaleC*>(&node) &&
+      !dynamic_cast<const DropLevelC*>(&node) &&
+      !dynamic_cast<const BootstrapC*>(&node)) {
+    return std::nullopt;
+  }
+  if (!std::any_of(parents.begin(), parents.end(), is_zero)) {
+    return std::nullopt;
+  }
+  zero_nodes_.insert(&node);
+  return CtType::ZeroC(ct_program_.GetProgramContext(), node.GetLevelInfo());
+}
+
 template <class CtType>
 CtType Evaluator<CtType>::VisitImpl(const Node<CtOp>& node_t) {
   auto parents = Estd::transform(
@@ -114,6 +163,9 @@ CtType Evaluator<CtType>::VisitImpl(const Node<CtOp>& node_t) {
       [](const auto& ptr) -> const CtOp* { return &ptr->Value(); });
 
   const CtOp& node = node_t.Value();
+  if (auto folded = FoldZero(node, parents)) {
+    return *folded;
+  }
   if (const auto* ptr = dynamic_cast<const InputC*>(&node)) {
     return VisitImpl(*ptr, parents);
   }
@@ -147,6 +199,9 @@ CtType Evaluator<CtType>::VisitImpl(const Node<CtOp>& node_t) {
   if (const auto* ptr = dynamic_cast<const RescaleC*>(&node)) {
     return VisitImpl(*ptr, parents);
   }
+  if (const auto* ptr = dynamic_cast<const DropLevelC*>(&node)) {
+    return VisitImpl(*ptr, parents);
+  }
   if (const auto* ptr = dynamic_cast<const ZeroC*>(&node)) {
     return VisitImpl(*ptr, parents);
   }
@@ -243,6 +298,12 @@ CtType Evaluator<CtType>::VisitImpl(const RescaleC& node,
       .RescaleC(ct_program_.GetProgramContext().LogScale());
 }
 
+template <class CtType>
+CtType Evaluator<CtType>::VisitImpl(const DropLevelC& node,
+                                    const std::vector<const CtOp*>& parents) {
+  return node_map_.at(parents.at(0)).DropLevelC(node.GetLevel());
+}
+
 template <class CtType>
 CtType Evaluator<CtType>::VisitImpl(const OutputC& node,
                                     const std::vector<const CtOp*>& parents) {
@@ -33,6 +33,7 @@ class FheBoosterPass : public CtOpOptimizer {
          static PassName pass_name("fhe_booster_pass");
          return pass_name;
      }
+     std::string PassSettings() const final { return ToString(usable_levels_); }
 
      std::unique_ptr<CtOpOptimizer> CloneUniq() const final {
          return std::make_unique<FheBoosterPass>(usable_levels_);
@@ -45,6 +45,9 @@ class GenericLayoutPass : public LayoutPass {
                                      ChunkSize chunk_size) const = 0;
 
   const ProgramContext& Context() const { return context_; }
+  std::string PassSettings() const override {
+    return ToString(context_) + " " + std::to_string(ignore_chet_repack_);
+  }
 
  private:
   ProgramContext context_;
@@ -58,6 +58,7 @@ class LattigoCt {
 
   LattigoCt RotateC(int rotate_by) const;
   LattigoCt RescaleC(LogScale rescale_amount) const;
+  LattigoCt DropLevelC(Level level) const;
   ChunkSize GetChunkSize() const {
     // TODO(nsamar): Actually implement
     return 1;
@@ -0,0 +1,82 @@
+/** $lic$
+ * Copyright (C) 2023-2024 by Massachusetts Institute of Technology
+ *
+ * This file is part of the Fhelipe compiler.
+ *
+ * Fhelipe is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * Fhelipe is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>. 
+ */
+
+#ifndef FHELIPE_LAYOUT_COST_MODEL_H_
+#define FHELIPE_LAYOUT_COST_MODEL_H_
+
+#include <memory>
+#include <string>
+
+#include "dag.h"
+#include "t_op.h"
+
+namespace fhelipe {
+
+// Estimates how long a TOp runs with the layouts it was built with, so that
+// layout passes can compare layout choices before anything is lowered
+class LayoutCostModel {
+ public:
+  virtual ~LayoutCostModel() = default;
+  virtual double TOpCost(const TOp& t_op) const = 0;
+  virtual const std::string& Name() const = 0;
+  virtual std::unique_ptr<LayoutCostModel> CloneUniq() const = 0;
+};
+
+// Counts key switches (rotations and ciphertext multiplies) per chunk and
+// charges every other per-chunk operation `other_op_cost` key switches. At the
+// levels of a typical program, perf_estimator puts a key switch at roughly 64
+// additions or plaintext multiplies.
+class KeySwitchCostModel final : public LayoutCostModel {
+ public:
+  explicit KeySwitchCostModel(double other_op_cost = 1.0 / 64)
+      : other_op_cost_(other_op_cost) {}
+  double TOpCost(const TOp& t_op) const final;
+  const std::string& Name() const final {
+    static const std::string name = "key_switch";
+    return name;
+  }
+  std::unique_ptr<LayoutCostModel> CloneUniq() const final {
+    return std::make_unique<KeySwitchCostModel>(*this);
+  }
+
+ private:
+  double other_op_cost_;
+};
+
+// Only counts layout conversion tentacles, the estimate LayoutHoistingPass
+// minimizes
+class TentacleCostModel final : public LayoutCostModel {
+ public:
+  double TOpCost(const TOp& t_op) const final;
+  const std::string& Name() const final {
+    static const std::string name = "tentacles";
+    return name;
+  }
+  std::unique_ptr<LayoutCostModel> CloneUniq() const final {
+    return std::make_unique<TentacleCostModel>(*this);
+  }
+};
+
+std::unique_ptr<LayoutCostModel> LayoutCostModelFromName(
+    const std::string& name);
+
+double EstimatedCost(const Dag<TOp>& dag, const LayoutCostModel& cost_model);
+
+}  // namespace fhelipe
+
+#endif  // FHELIPE_LAYOUT_COST_MODEL_H_
@@ -47,6 +47,7 @@ class LazyBootstrappingPass : public LevelingPass {
     static PassName pass_name("lazy_bootstrapping_pass");
     return pass_name;
   }
+  std::string PassSettings() const final { return ToString(context_); }
   std::unique_ptr<LevelingPass> CloneUniq() const final {
     return std::make_unique<LazyBootstrappingPass>(context_);
   }
@@ -0,0 +1,97 @@
+/** $lic$
+ * Copyright (C) 2023-2024 by Massachusetts Institute of Technology
+ *
+ * This file is part of the Fhelipe compiler.
+ *
+ * Fhelipe is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * Fhelipe is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>. 
+ */
+
+#ifndef FHELIPE_LEVEL_PATH_COUNTS_H_
+#define FHELIPE_LEVEL_PATH_COUNTS_H_
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "ct_op.h"
+#include "dag.h"
+#include "level.h"
+
+namespace fhelipe {
+
+// Counts, for every node of a CtOp dag, the paths through it that go from a
+// RescaleC to the parent of a RescaleC over exactly the usable levels and
+// avoid bootstrapped nodes. Those are the paths that run out of levels unless
+// something on them is bootstrapped. Counts saturate instead of overflowing.
+//
+// Bootstrapping a node only changes the counts downstream and upstream of it,
+// so Bootstrap() updates the counts from the node outwards and stops wherever
+// they no longer change.
+class LevelPathCounts {
+ public:
+  typedef __int128 PathCount;
+
+  LevelPathCounts(const Dag<CtOp>& dag, const Level& usable_levels);
+
+  PathCount Count(const Node<CtOp>& node) const {
+    return path_counts_.at(DenseIndex(node));
+  }
+  // Largest count of a node that is not bootstrapped (0 if there is none)
+  PathCount MaxCount() const;
+  // Node with the largest count, the first one in topological order on ties
+  const std::shared_ptr<Node<CtOp>>& MaxNode() const;
+  void Bootstrap(const Node<CtOp>& node);
+
+ private:
+  int DenseIndex(const Node<CtOp>& node) const {
+    return dense_indices_.at(&node);
+  }
+  PathCount& Backward(int idx, int level) {
+    return backward_.at(idx * level_count_ + level);
+  }
+  PathCount& Forward(int idx, int level) {
+    return forward_.at(idx * level_count_ + level);
+  }
+
+  // Recompute the counts of one node from its neighbors' and return whether
+  // they changed
+  bool UpdateBackward(int idx);
+  bool UpdateForward(int idx);
+  void UpdatePathCount(int idx);
+  // Whether `lhs` goes before `rhs` in MaxNode(). Bootstrapped nodes go last.
+  bool MorePaths(int lhs, int rhs) const;
+  void UpdateMaxTree(int idx);
+
+  int level_count_;
+  // Dense index -> node, in topological order
+  std::vector<std::shared_ptr<Node<CtOp>>> nodes_;
+  std::unordered_map<const Node<CtOp>*, int> dense_indices_;
+  std::vector<std::vector<int>> parents_;
+  std::vector<std::vector<int>> children_;
+  std::vector<bool> is_rescale_;
+  std::vector<bool> has_rescale_child_;
+  std::vector<bool> bootstrapped_;
+  // Paths from a RescaleC to the node, by the levels they use
+  std::vector<PathCount> backward_;
+  // Paths from the node to the parent of a RescaleC, by the levels they use
+  std::vector<PathCount> forward_;
+  std::vector<PathCount> path_counts_;
+  // Tournament tree over the dense indices: leaf `idx` is at
+  // max_tree_[nodes_.size() + idx], every other entry holds the node that goes
+  // first of its two children's, and max_tree_[1] is MaxNode()
+  std::vector<int> max_tree_;
+};
+
+}  // namespace fhelipe
+
+#endif  // FHELIPE_LEVEL_PATH_COUNTS_H_
@@ -19,6 +19,8 @@
 #ifndef FHELIPE_NODE_H_
 #define FHELIPE_NODE_H_
 
+#include <atomic>
+#include <cstdint>
 #include <iostream>
 #include <memory>
 #include <set>
@@ -57,7 +59,10 @@ class Node {
   void SetValue(std::unique_ptr<T>&& new_value);
 
   int NodeId() const;
-  void RemoveAllParents() { parents_ = {}; }
+  void RemoveAllParents() {
+    parents_ = {};
+    TouchTopology();
+  }
 
   bool HoldsNothing() const { return !bool(value_); }
   bool IsSentinel() const { return HoldsNothing(); }
@@ -76,6 +81,10 @@ class Node {
   bool IsParent(const Node<T>& candidate) const;
   bool IsDoubleParent(const Node<T>& candidate) const;
 
+  // Bumped by every edge mutation of any Node<T>; Dag<T> uses it to tell
+  // whether its cached topological order is still valid
+  static uint64_t TopologyEpoch() { return topology_epoch_.load(); }
+
  private:
   int node_id_;
   std::unique_ptr<T> value_;
@@ -83,7 +92,11 @@ class Node {
   std::set<std::shared_ptr<Node<T>>> children_;
   std::vector<int> ancestor_node_ids_;
 
-  static int max_used_node_ids_;
+  // Atomic so that separate threads can build separate Dag<T>s at once
+  static std::atomic<int> max_used_node_ids_;
+  static std::atomic<uint64_t> topology_epoch_;
+
+  static void TouchTopology() { ++topology_epoch_; }
 };
 
 template <typename T>
@@ -134,7 +147,10 @@ void SwapParentAndChild(std::shared_ptr<Node<T>> parent,
 }
 
 template <class T>
-int Node<T>::max_used_node_ids_ = 0;
+std::atomic<int> Node<T>::max_used_node_ids_ = 0;
+
+template <class T>
+std::atomic<uint64_t> Node<T>::topology_epoch_ = 0;
 
 template <class T>
 void AddParentChildEdge(const std::shared_ptr<Node<T>>& parent,
@@ -219,6 +235,7 @@ void Node<T>::RemoveChild(const Node<T>& node) {
   for (const auto& child : children) {
     if (child.get() == &node) {
       children_.erase(child);
+      TouchTopology();
       return;
     }
   }
@@ -237,6 +254,7 @@ void Node<T>::RemoveParent(const Node<T>& node) {
     parents_.at(idx) = parents_.at(idx + 1);
   }
   parents_.pop_back();
+  TouchTopology();
   if (IsParent(node)) {
     // Remove node again in case of aliasing
     RemoveParent(node);
@@ -312,11 +330,13 @@ std::shared_ptr<Node<T>> CreateChild(
 template <class T>
 void Node<T>::AddParent(const std::shared_ptr<Node<T>>& parent) {
   parents_.push_back(parent);
+  TouchTopology();
 }
 
 template <class T>
 void Node<T>::AddChild(const std::shared_ptr<Node<T>>& child) {
   children_.insert(child);
+  TouchTopology();
 }
 
 template <class T>
@@ -353,7 +373,10 @@ Node<T>::Node(int node_id, std::unique_ptr<T>&& value,
       parents_{},
       children_{},
       ancestor_node_ids_{ancestors} {
-  max_used_node_ids_ = std::max(max_used_node_ids_, node_id_);
+  int max_used = max_used_node_ids_.load();
+  while (max_used < node_id_ &&
+         !max_used_node_ids_.compare_exchange_weak(max_used, node_id_)) {
+  }
 }
 
 template <typename T>
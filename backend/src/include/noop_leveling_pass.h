@@ -35,6 +35,7 @@ class NoopLevelingPass : public LevelingPass {
     static PassName pass_name("noop_leveling_pass");
     return pass_name;
   }
+  std::string PassSettings() const final { return ToString(context_); }
 
   std::unique_ptr<LevelingPass> CloneUniq() const final {
     return std::make_unique<NoopLevelingPass>(context_);
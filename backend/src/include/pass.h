@@ -57,6 +57,9 @@ class Pass {
 
   virtual OutputT DoPass(const InputT& old_dag) = 0;
   virtual const PassName& GetPassName() const = 0;
+  // Everything besides the input that affects the output of the pass. Passes
+  // with the same name and settings must produce the same output.
+  virtual std::string PassSettings() const { return ""; }
   virtual std::unique_ptr<Pass<InputT, OutputT>> CloneUniq() const = 0;
   virtual ~Pass() = default;
 };
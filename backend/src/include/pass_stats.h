@@ -0,0 +1,104 @@
+/** $lic$
+ * Copyright (C) 2023-2024 by Massachusetts Institute of Technology
+ *
+ * This file is part of the Fhelipe compiler.
+ *
+ * Fhelipe is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * Fhelipe is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>. 
+ */
+
+#ifndef FHELIPE_PASS_STATS_H_
+#define FHELIPE_PASS_STATS_H_
+
+#include <chrono>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "ct_program.h"
+#include "dag.h"
+#include "pass.h"
+
+namespace fhelipe {
+
+// High-water mark of the resident set size of this process, in KiB
+long PeakRssKb();
+
+// Measures wall time and peak RSS growth since the last Restart()
+class PassProfiler {
+ public:
+  PassProfiler() { Restart(); }
+  void Restart();
+
+  double ElapsedSeconds() const;
+  long PeakRssDeltaKb() const;
+
+ private:
+  std::chrono::steady_clock::time_point start_time_;
+  long start_peak_rss_kb_;
+};
+
+class PassStats {
+ public:
+  // For passes whose output is not a DAG
+  PassStats(int pass_idx, const PassName& pass_name,
+            const PassProfiler& profiler)
+      : pass_idx_(pass_idx),
+        pass_name_(pass_name),
+        wall_time_s_(profiler.ElapsedSeconds()),
+        peak_rss_delta_kb_(profiler.PeakRssDeltaKb()) {}
+  template <typename T>
+  PassStats(int pass_idx, const PassName& pass_name,
+            const PassProfiler& profiler, const Dag<T>& dag);
+  PassStats(int pass_idx, const PassName& pass_name,
+            const PassProfiler& profiler,
+            const ct_program::CtProgram& ct_program);
+
+  int PassIndex() const { return pass_idx_; }
+  const PassName& GetPassName() const { return pass_name_; }
+  double WallTimeSeconds() const { return wall_time_s_; }
+  long PeakRssDeltaKb() const { return peak_rss_delta_kb_; }
+  int NodeCount() const { return node_cnt_; }
+  int EdgeCount() const { return edge_cnt_; }
+  // Only populated for passes that output a CtProgram
+  const std::map<std::string, int>& CtOpCounts() const { return ct_op_cnts_; }
+  int KeySwitchCount() const { return key_switch_cnt_; }
+
+ private:
+  int pass_idx_;
+  PassName pass_name_;
+  double wall_time_s_;
+  long peak_rss_delta_kb_;
+  int node_cnt_ = 0;
+  int edge_cnt_ = 0;
+  std::map<std::string, int> ct_op_cnts_;
+  int key_switch_cnt_ = 0;
+};
+
+template <typename T>
+PassStats::PassStats(int pass_idx, const PassName& pass_name,
+                     const PassProfiler& profiler, const Dag<T>& dag)
+    : PassStats(pass_idx, pass_name, profiler) {
+  for (const auto& node : dag.NodesInTopologicalOrder()) {
+    ++node_cnt_;
+    edge_cnt_ += node->Children().size();
+  }
+}
+
+// Writes one JSON object per pass, in pass order
+void WriteCompileStatsJson(std::ostream& stream,
+                           const std::vector<PassStats>& pass_stats);
+
+}  // namespace fhelipe
+
+#endif  // FHELIPE_PASS_STATS_H_
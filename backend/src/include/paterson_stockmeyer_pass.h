@@ -0,0 +1,54 @@
+/** $lic$
+ * Copyright (C) 2023-2024 by Massachusetts Institute of Technology
+ *
+ * This file is part of the Fhelipe compiler.
+ *
+ * Fhelipe is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * Fhelipe is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>. 
+ */
+
+#ifndef FHELIPE_PATERSON_STOCKMEYER_PASS_H_
+#define FHELIPE_PATERSON_STOCKMEYER_PASS_H_
+
+#include "pass.h"
+#include "pass_utils.h"
+
+namespace fhelipe {
+
+// Re-lowers the polynomials that the frontend builds from powers of x (a sum
+// of scalar multiples of TMulCC products of x) with the Paterson-Stockmeyer
+// method: baby-step powers x^1, ..., x^(k-1) and giant-step powers x^(k 2^j)
+// are each computed once by a minimal-depth power tree, and the polynomial is
+// split recursively as q(x) x^(k 2^j) + r(x). The baby step k is picked to
+// minimize first the multiplicative depth and then the number of TMulCCs, and a
+// polynomial is only replaced if that lowers either without raising the other.
+class PatersonStockmeyerPass : public LayoutOptimizer {
+ public:
+  PatersonStockmeyerPass() {}
+
+  LayoutOptimizerOutput DoPass(const LayoutOptimizerInput& in_dag) final;
+
+  const PassName& GetPassName() const final {
+    static PassName pass_name("paterson_stockmeyer_pass");
+    return pass_name;
+  }
+
+  std::unique_ptr<LayoutOptimizer> CloneUniq() const final {
+    return std::make_unique<PatersonStockmeyerPass>();
+  }
+
+ private:
+};
+
+}  // namespace fhelipe
+
+#endif  // FHELIPE_PATERSON_STOCKMEYER_PASS_H_
@@ -32,10 +32,17 @@ class ProgramContext {
   ProgramContext(LogChunkSize log_chunk_size, LogScale log_scale,
                  Level usable_levels,
                  BootstrappingPrecision bootstrapping_precision)
+      : ProgramContext(log_chunk_size, log_scale, usable_levels,
+                       bootstrapping_precision, log_scale) {}
+  ProgramContext(LogChunkSize log_chunk_size, LogScale log_scale,
+                 Level usable_levels,
+                 BootstrappingPrecision bootstrapping_precision,
+                 LogScale mask_log_scale)
       : log_chunk_size_(log_chunk_size),
         log_scale_(log_scale),
         usable_levels_(usable_levels),
-        bootstrapping_precision_(bootstrapping_precision) {}
+        bootstrapping_precision_(bootstrapping_precision),
+        mask_log_scale_(mask_log_scale) {}
 
   BootstrappingPrecision GetBootstrappingPrecision() const {
     return bootstrapping_precision_;
@@ -44,6 +51,9 @@ class ProgramContext {
   LogChunkSize GetLogChunkSize() const { return log_chunk_size_; }
   LogScale LogScale() const { return log_scale_; }
   Level UsableLevels() const { return usable_levels_; }
+  // Scale at which backend-generated 0/1 masks are encoded; since masks are
+  // exact, this can be much smaller than LogScale()
+  class LogScale MaskLogScale() const { return mask_log_scale_; }
 
   latticpp::LattigoParam GetLattigoParam() const {
     return {GetLogN().value(), log_scale_.value(), usable_levels_.value(),
@@ -57,6 +67,7 @@ class ProgramContext {
   class LogScale log_scale_;
   Level usable_levels_;
   BootstrappingPrecision bootstrapping_precision_;
+  class LogScale mask_log_scale_;
 };
 
 template <>
@@ -65,7 +76,9 @@ inline ProgramContext ReadStream<ProgramContext>(std::istream& stream) {
   auto log_scale = ReadStream<int>(stream);
   auto usable_levels = ReadStream<Level>(stream);
   auto bootstrapping_precision = ReadStream<BootstrappingPrecision>(stream);
-  return {log_chunk_size, log_scale, usable_levels, bootstrapping_precision};
+  auto mask_log_scale = ReadStream<int>(stream);
+  return {log_chunk_size, log_scale, usable_levels, bootstrapping_precision,
+          mask_log_scale};
 }
 
 template <>
@@ -79,6 +92,8 @@ inline void WriteStream<ProgramContext>(std::ostream& stream,
   stream << " ";
   WriteStream<BootstrappingPrecision>(
       stream, program_context.GetBootstrappingPrecision());
+  stream << " ";
+  WriteStream<class LogScale>(stream, program_context.MaskLogScale());
 }
 
 inline ProgramContext MakeProgramContext(const latticpp::LattigoParam& param) {
@@ -0,0 +1,48 @@
+/** $lic$
+ * Copyright (C) 2023-2024 by Massachusetts Institute of Technology
+ *
+ * This file is part of the Fhelipe compiler.
+ *
+ * Fhelipe is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * Fhelipe is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>. 
+ */
+
+#ifndef FHELIPE_ROTATION_FACTORING_PASS_H_
+#define FHELIPE_ROTATION_FACTORING_PASS_H_
+
+#include "pass.h"
+#include "pass_utils.h"
+
+namespace fhelipe {
+
+// Algebraic rewrites on the CtOp DAG:
+//   AddCC(RotateC(a, k), RotateC(b, k)) -> RotateC(AddCC(a, b), k)
+//   AddCC(MulCP(a, p), MulCP(a, q)) -> MulCP(a, p + q)
+// The operands of the AddCC must not have other children.
+class RotationFactoringPass : public CtOpOptimizer {
+ public:
+  RotationFactoringPass() = default;
+  CtOpOptimizerOutput DoPass(const CtOpOptimizerInput& in_dag) final;
+
+  const PassName& GetPassName() const final {
+    static PassName pass_name("rotation_factoring_pass");
+    return pass_name;
+  }
+
+  std::unique_ptr<CtOpOptimizer> CloneUniq() const final {
+    return std::make_unique<RotationFactoringPass>();
+  }
+};
+
+}  // namespace fhelipe
+
+#endif  // FHELIPE_ROTATION_FACTORING_PASS_H_
@@ -0,0 +1,47 @@
+/** $lic$
+ * Copyright (C) 2023-2024 by Massachusetts Institute of Technology
+ *
+ * This file is part of the Fhelipe compiler.
+ *
+ * Fhelipe is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * Fhelipe is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>. 
+ */
+
+#ifndef FHELIPE_ROTATION_SINKING_PASS_H_
+#define FHELIPE_ROTATION_SINKING_PASS_H_
+
+#include "pass.h"
+#include "pass_utils.h"
+
+namespace fhelipe {
+
+// Moves each RotateC below the RescaleC that consumes it, so that the
+// key-switch happens one level lower. Rotations commute with rescaling, and
+// LevelMinimizationPass takes care of lowering the remaining ops.
+class RotationSinkingPass : public CtOpOptimizer {
+ public:
+  RotationSinkingPass() = default;
+  CtOpOptimizerOutput DoPass(const CtOpOptimizerInput& in_dag) final;
+
+  const PassName& GetPassName() const final {
+    static PassName pass_name("rotation_sinking_pass");
+    return pass_name;
+  }
+
+  std::unique_ptr<CtOpOptimizer> CloneUniq() const final {
+    return std::make_unique<RotationSinkingPass>();
+  }
+};
+
+}  // namespace fhelipe
+
+#endif  // FHELIPE_ROTATION_SINKING_PASS_H_
@@ -55,6 +55,7 @@ class TAddCC final : public TOp {
   }
   LogScale AddedLogScale() const final { return 0; }
   int BackendMaskDepth() const final { return 0; }
+  bool IsCommutative() const final { return true; }
 
   const TensorLayout& OutputLayout() const final { return layout_; }
 
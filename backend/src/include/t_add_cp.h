@@ -61,6 +61,7 @@ class TAddCP final : public TOp {
 
   LogScale AddedLogScale() const final { LOG(FATAL); }
   int BackendMaskDepth() const final { LOG(FATAL); }
+  std::size_t Hash() const final;
 
   const std::string& TypeName() const final { return StaticTypeName(); }
 
@@ -62,6 +62,7 @@ class TChetRepackC final : public TOp {
     }
     return 1;
   }
+  std::size_t Hash() const final;
 
   const TensorLayout& InputLayout() const { return input_layout_; }
   const TensorLayout& OutputLayout() const final { return output_layout_; }
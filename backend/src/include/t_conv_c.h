@@ -0,0 +1,127 @@
+/** $lic$
+ * Copyright (C) 2023-2024 by Massachusetts Institute of Technology
+ *
+ * This file is part of the Fhelipe compiler.
+ *
+ * Fhelipe is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * Fhelipe is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>. 
+ */
+
+#ifndef FHELIPE_T_CONV_C_H_
+#define FHELIPE_T_CONV_C_H_
+
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "chunk_ir.h"
+#include "laid_out_tensor.h"
+#include "t_op.h"
+#include "tensor_index.h"
+#include "tensor_layout.h"
+#include "translation_mask_generator.h"
+
+namespace fhelipe {
+class CtOp;
+
+namespace ct_program {
+class CtProgram;
+}  // namespace ct_program
+
+class TConvC;
+
+template <>
+void WriteStream<TConvC>(std::ostream& stream, const TConvC& node);
+
+// The tap sum of a convolution: sum over taps t of W_t * shift_t(in), where
+// shift_t is an unpadded shift (as in TUnpaddedShiftC) and W_t is a frontend
+// tensor of the input's shape. Each tap's translation masks are folded into
+// its weights, which are gathered directly into the rotated slots, so a tap
+// costs a single plaintext multiply. Rotations of an input chunk are shared by
+// all taps that need them.
+class TConvC final : public TOp {
+ public:
+  TConvC(const TensorLayout& layout, const std::vector<DiffTensorIndex>& shifts,
+         const std::vector<std::string>& pt_tensor_names,
+         LogScale pt_log_scale);
+  LaidOutTensorCt AmendCtProgram(
+      ct_program::CtProgram& ct_program,
+      const std::vector<LaidOutTensorCt>& input_tensors) const final;
+  const TensorLayout& OutputLayout() const final { return layout_; }
+  std::unique_ptr<TOp> CloneUniq() const final {
+    return std::make_unique<TConvC>(*this);
+  }
+  const std::vector<DiffTensorIndex>& Shifts() const { return shifts_; }
+  const std::vector<std::string>& PtTensorNames() const {
+    return pt_tensor_names_;
+  }
+  LogScale PtLogScale() const { return pt_log_scale_; }
+
+  LogScale AddedLogScale() const final { return pt_log_scale_; }
+  int BackendMaskDepth() const final { return 0; }
+  // Number of ciphertext rotations AmendCtProgram emits for this layout
+  int RotationCount() const;
+
+  const std::string& TypeName() const final { return StaticTypeName(); }
+
+  void WriteStreamHelper(std::ostream& stream) const final {
+    WriteStream<TConvC>(stream, *this);
+  }
+
+  static const std::string& StaticTypeName() {
+    static const std::string type_name_ = "TConvC";
+    return type_name_;
+  }
+  void SetLayouts(const TensorLayout& input_layout,
+                  const TensorLayout& output_layout) final;
+
+ private:
+  TensorLayout layout_;
+  std::vector<DiffTensorIndex> shifts_;
+  std::vector<std::string> pt_tensor_names_;
+  LogScale pt_log_scale_;
+
+  static TOpDerivedRegistrar<TConvC> reg_;
+  bool EqualTo(const TOp& other) const final;
+  std::vector<TranslationMask> TapMasks(int tap) const;
+  IndirectChunkIr MaskedWeights(int tap, const DirectChunkIr& mask,
+                                int dest_chunk, int rotate_by) const;
+};
+
+inline TOpDerivedRegistrar<TConvC> TConvC::reg_{TConvC::StaticTypeName()};
+
+template <>
+inline void WriteStream<TConvC>(std::ostream& stream, const TConvC& node) {
+  WriteStream<std::string>(stream, TConvC::StaticTypeName());
+  stream << " ";
+  WriteStream<TensorLayout>(stream, node.OutputLayout());
+  stream << " ";
+  WriteStream<std::vector<DiffTensorIndex>>(stream, node.Shifts());
+  stream << " ";
+  WriteStream<std::vector<std::string>>(stream, node.PtTensorNames());
+  stream << " ";
+  WriteStream<LogScale>(stream, node.PtLogScale());
+}
+
+template <>
+inline TConvC ReadStreamWithoutTypeNamePrefix<TConvC>(std::istream& stream) {
+  auto layout = ReadStream<TensorLayout>(stream);
+  auto shifts = ReadStream<std::vector<DiffTensorIndex>>(stream);
+  auto pt_tensor_names = ReadStream<std::vector<std::string>>(stream);
+  auto pt_log_scale = ReadStream<LogScale>(stream);
+  return {layout, shifts, pt_tensor_names, pt_log_scale};
+}
+
+}  // namespace fhelipe
+
+#endif  // FHELIPE_T_CONV_C_H_
@@ -28,6 +28,7 @@
 #include "t_op.h"
 #include "tensor_index.h"
 #include "tensor_layout.h"
+#include "translation_mask_utils.h"
 
 namespace fhelipe {
 namespace ct_program {
@@ -63,7 +64,11 @@ class TCyclicShiftC final : public TOp {
   }
 
   LogScale AddedLogScale() const final { return 0; }
-  int BackendMaskDepth() const final { return 1; }
+  int BackendMaskDepth() const final;
+  bool InputPaddingIsZero() const { return mask_depth_.InputPaddingIsZero(); }
+  void SetInputPaddingIsZero(bool input_padding_is_zero) {
+    mask_depth_.SetInputPaddingIsZero(input_padding_is_zero);
+  }
   const DiffTensorIndex& GetDiffTensorIndex() const { return rotate_by_; }
   void SetLayouts(const TensorLayout& input_layout,
                   const TensorLayout& output_layout) final;
@@ -76,9 +81,11 @@ class TCyclicShiftC final : public TOp {
  private:
   TensorLayout layout_;
   DiffTensorIndex rotate_by_;
+  TranslationMaskDepthCache mask_depth_;
 
   static TOpDerivedRegistrar<TCyclicShiftC> reg_;
   bool EqualTo(const TOp& other) const final;
+  std::vector<TranslationMask> TranslationMasks() const;
 };
 
 inline TOpDerivedRegistrar<TCyclicShiftC> TCyclicShiftC::reg_{
@@ -92,6 +99,8 @@ inline void WriteStream<TCyclicShiftC>(std::ostream& stream,
   WriteStream<TensorLayout>(stream, node.OutputLayout());
   stream << " ";
   WriteStream<DiffTensorIndex>(stream, node.GetDiffTensorIndex());
+  stream << " ";
+  WriteStream<bool>(stream, node.InputPaddingIsZero());
 }
 
 template <>
@@ -99,7 +108,10 @@ inline TCyclicShiftC ReadStreamWithoutTypeNamePrefix<TCyclicShiftC>(
     std::istream& stream) {
   auto tensor_layout = ReadStream<TensorLayout>(stream);
   auto diff_tensor_index = ReadStream<DiffTensorIndex>(stream);
-  return {tensor_layout, diff_tensor_index};
+  auto input_padding_is_zero = ReadStream<bool>(stream);
+  TCyclicShiftC result(tensor_layout, diff_tensor_index);
+  result.SetInputPaddingIsZero(input_padding_is_zero);
+  return result;
 }
 inline TCyclicShiftC::TCyclicShiftC(const TensorLayout& layout,
                                     const DiffTensorIndex& rotate_by)
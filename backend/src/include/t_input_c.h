@@ -63,6 +63,7 @@ class TInputC final : public TOp {
   LogScale AddedLogScale() const final { return 0; }
 
   int BackendMaskDepth() const final { return 0; }
+  std::size_t Hash() const final;
 
   const std::string& TypeName() const { return StaticTypeName(); }
 
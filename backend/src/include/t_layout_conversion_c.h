@@ -27,6 +27,7 @@
 #include "laid_out_tensor.h"
 #include "t_op.h"
 #include "tensor_layout.h"
+#include "translation_mask_utils.h"
 
 namespace fhelipe {
 
@@ -55,7 +56,11 @@ class TLayoutConversionC final : public TOp {
   virtual std::unique_ptr<TOp> CloneUniq() const final {
     return std::make_unique<TLayoutConversionC>(*this);
   }
-  int BackendMaskDepth() const final { return 1; }
+  int BackendMaskDepth() const final;
+  bool InputPaddingIsZero() const { return mask_depth_.InputPaddingIsZero(); }
+  void SetInputPaddingIsZero(bool input_padding_is_zero) {
+    mask_depth_.SetInputPaddingIsZero(input_padding_is_zero);
+  }
   LogScale AddedLogScale() const final { return 0; }
   void SetLayouts(const TensorLayout& input_layout,
                   const TensorLayout& output_layout) final;
@@ -73,9 +78,11 @@ class TLayoutConversionC final : public TOp {
  private:
   TensorLayout input_layout_;
   TensorLayout output_layout_;
+  TranslationMaskDepthCache mask_depth_;
 
   static TOpDerivedRegistrar<TLayoutConversionC> reg_;
   bool EqualTo(const TOp& other) const final;
+  std::vector<TranslationMask> TranslationMasks() const;
 };
 
 inline TLayoutConversionC::TLayoutConversionC(const TensorLayout& input_layout,
@@ -93,6 +100,8 @@ inline void WriteStream<TLayoutConversionC>(std::ostream& stream,
   WriteStream<TensorLayout>(stream, node.InputLayout());
   stream << " ";
   WriteStream<TensorLayout>(stream, node.OutputLayout());
+  stream << " ";
+  WriteStream<bool>(stream, node.InputPaddingIsZero());
 }
 
 template <>
@@ -100,7 +109,10 @@ inline TLayoutConversionC ReadStreamWithoutTypeNamePrefix<TLayoutConversionC>(
     std::istream& stream) {
   auto input_layout = ReadStream<TensorLayout>(stream);
   auto output_layout = ReadStream<TensorLayout>(stream);
-  return {input_layout, output_layout};
+  auto input_padding_is_zero = ReadStream<bool>(stream);
+  TLayoutConversionC result(input_layout, output_layout);
+  result.SetInputPaddingIsZero(input_padding_is_zero);
+  return result;
 }
 
 }  // namespace fhelipe
@@ -0,0 +1,136 @@
+/** $lic$
+ * Copyright (C) 2023-2024 by Massachusetts Institute of Technology
+ *
+ * This file is part of the Fhelipe compiler.
+ *
+ * Fhelipe is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * Fhelipe is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>. 
+ */
+
+#ifndef FHELIPE_T_MAT_VEC_C_H_
+#define FHELIPE_T_MAT_VEC_C_H_
+
+#include <map>
+#include <memory>
+#include <ostream>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "laid_out_tensor.h"
+#include "shape.h"
+#include "t_op.h"
+#include "tensor_layout.h"
+
+namespace fhelipe {
+class CtOp;
+
+namespace ct_program {
+class CtProgram;
+}  // namespace ct_program
+
+class TMatVecC;
+
+template <>
+void WriteStream<TMatVecC>(std::ostream& stream, const TMatVecC& node);
+
+// Matrix-vector product y = W x, where x has an arbitrary shape V, y has
+// shape [N, 1, ..., 1] and W is a frontend tensor of shape [N] + V.
+//
+// Uses the diagonal (Halevi-Shoup) method generalized to arbitrary layouts: an
+// output slot t of chunk d gets W[i(t), j(u)] * x[j(u)] for every input slot u
+// of chunk c, which is a plaintext multiply of x_c rotated by r = t - u. The
+// rotations are split baby-step giant-step style into r = g * B + b, so that
+// rotations by b are shared per input chunk and rotations by g * B are applied
+// once per output chunk after summing, with the diagonals pre-rotated to
+// match. B is picked to minimize the total rotation count.
+class TMatVecC final : public TOp {
+ public:
+  TMatVecC(const TensorLayout& input_layout, const TensorLayout& output_layout,
+           const std::string& pt_tensor_name, LogScale pt_log_scale);
+  LaidOutTensorCt AmendCtProgram(
+      ct_program::CtProgram& ct_program,
+      const std::vector<LaidOutTensorCt>& input_tensors) const final;
+  const TensorLayout& InputLayout() const { return input_layout_; }
+  const TensorLayout& OutputLayout() const final { return output_layout_; }
+  std::unique_ptr<TOp> CloneUniq() const final {
+    return std::make_unique<TMatVecC>(*this);
+  }
+  const std::string& PtTensorName() const { return pt_tensor_name_; }
+  LogScale PtLogScale() const { return pt_log_scale_; }
+  // [N] + V
+  Shape PtTensorShape() const;
+
+  LogScale AddedLogScale() const final { return pt_log_scale_; }
+  int BackendMaskDepth() const final { return 0; }
+  std::size_t Hash() const final;
+  // Number of ciphertext rotations AmendCtProgram emits for these layouts
+  int RotationCount() const;
+
+  const std::string& TypeName() const final { return StaticTypeName(); }
+
+  void WriteStreamHelper(std::ostream& stream) const final {
+    WriteStream<TMatVecC>(stream, *this);
+  }
+
+  static const std::string& StaticTypeName() {
+    static const std::string type_name_ = "TMatVecC";
+    return type_name_;
+  }
+  void SetLayouts(const TensorLayout& input_layout,
+                  const TensorLayout& output_layout) final;
+
+ private:
+  // (input chunk, output chunk) -> rotation amounts in [0, chunk size)
+  using Diagonals = std::map<std::pair<int, int>, std::set<int>>;
+
+  TensorLayout input_layout_;
+  TensorLayout output_layout_;
+  std::string pt_tensor_name_;
+  LogScale pt_log_scale_;
+
+  static TOpDerivedRegistrar<TMatVecC> reg_;
+  bool EqualTo(const TOp& other) const final;
+  Diagonals NonZeroDiagonals() const;
+  int BabyStep(const Diagonals& diagonals) const;
+};
+
+inline TOpDerivedRegistrar<TMatVecC> TMatVecC::reg_{
+    TMatVecC::StaticTypeName()};
+
+template <>
+inline void WriteStream<TMatVecC>(std::ostream& stream, const TMatVecC& node) {
+  WriteStream<std::string>(stream, TMatVecC::StaticTypeName());
+  stream << " ";
+  WriteStream<TensorLayout>(stream, node.InputLayout());
+  stream << " ";
+  WriteStream<TensorLayout>(stream, node.OutputLayout());
+  stream << " ";
+  WriteStream<std::string>(stream, node.PtTensorName());
+  stream << " ";
+  WriteStream<LogScale>(stream, node.PtLogScale());
+}
+
+template <>
+inline TMatVecC ReadStreamWithoutTypeNamePrefix<TMatVecC>(
+    std::istream& stream) {
+  auto input_layout = ReadStream<TensorLayout>(stream);
+  auto output_layout = ReadStream<TensorLayout>(stream);
+  auto pt_tensor_name = ReadStream<std::string>(stream);
+  auto pt_log_scale = ReadStream<LogScale>(stream);
+  return {input_layout, output_layout, pt_tensor_name, pt_log_scale};
+}
+
+}  // namespace fhelipe
+
+#endif  // FHELIPE_T_MAT_VEC_C_H_
@@ -26,6 +26,7 @@
 
 #include "ct_program.h"
 #include "laid_out_tensor.h"
+#include "plaintext.h"
 #include "shape.h"
 #include "t_op.h"
 #include "tensor_layout.h"
@@ -43,20 +44,28 @@ template <>
 void WriteStream<TMergedMulChainCP>(std::ostream& stream,
                                     const TMergedMulChainCP& node);
 
+// A chain of TMulCP and TMulCSI on the same ciphertext path, folded into one
+// plaintext multiply. The plaintext is the product of the frontend tensors and
+// the scalar; it is encoded at the largest log scale of the chain's links.
 class TMergedMulChainCP final : public TOp {
  public:
-  TMergedMulChainCP(const TensorLayout& input_layout,
-                    const TensorLayout& output_layout);
+  TMergedMulChainCP(const TensorLayout& layout,
+                    const std::vector<std::string>& pt_tensor_names,
+                    PtVal scalar, LogScale pt_log_scale);
   TOp::LaidOutTensorCt AmendCtProgram(
       ct_program::CtProgram& ct_program,
       const std::vector<TOp::LaidOutTensorCt>& input_tensors) const final;
-  const TensorLayout& OutputLayout() const final { return output_layout_; }
-  const TensorLayout& InputLayout() const { return input_layout_; }
+  const TensorLayout& OutputLayout() const final { return layout_; }
   std::unique_ptr<TOp> CloneUniq() const final {
     return std::make_unique<TMergedMulChainCP>(*this);
   }
+  const std::vector<std::string>& PtTensorNames() const {
+    return pt_tensor_names_;
+  }
+  PtVal Scalar() const { return scalar_; }
+  LogScale PtLogScale() const { return pt_log_scale_; }
 
-  LogScale AddedLogScale() const final { return 0; }
+  LogScale AddedLogScale() const final { return pt_log_scale_; }
   int BackendMaskDepth() const final { return 0; }
 
   const std::string& TypeName() const final { return StaticTypeName(); }
@@ -73,8 +82,10 @@ class TMergedMulChainCP final : public TOp {
                   const TensorLayout& output_layout) final;
 
  private:
-  TensorLayout input_layout_;
-  TensorLayout output_layout_;
+  TensorLayout layout_;
+  std::vector<std::string> pt_tensor_names_;
+  PtVal scalar_;
+  LogScale pt_log_scale_;
 
   static TOpDerivedRegistrar<TMergedMulChainCP> reg_;
   bool EqualTo(const TOp& other) const final;
@@ -88,17 +99,23 @@ inline void WriteStream<TMergedMulChainCP>(std::ostream& stream,
                                            const TMergedMulChainCP& node) {
   WriteStream<std::string>(stream, TMergedMulChainCP::StaticTypeName());
   stream << " ";
-  WriteStream<TensorLayout>(stream, node.InputLayout());
-  stream << " ";
   WriteStream<TensorLayout>(stream, node.OutputLayout());
+  stream << " ";
+  WriteStream<std::vector<std::string>>(stream, node.PtTensorNames());
+  stream << " ";
+  WriteStream<PtVal>(stream, node.Scalar());
+  stream << " ";
+  WriteStream<LogScale>(stream, node.PtLogScale());
 }
 
 template <>
 inline TMergedMulChainCP ReadStreamWithoutTypeNamePrefix<TMergedMulChainCP>(
     std::istream& stream) {
-  auto input_layout = ReadStream<TensorLayout>(stream);
-  auto output_layout = ReadStream<TensorLayout>(stream);
-  return {input_layout, output_layout};
+  auto layout = ReadStream<TensorLayout>(stream);
+  auto pt_tensor_names = ReadStream<std::vector<std::string>>(stream);
+  auto scalar = ReadStream<PtVal>(stream);
+  auto pt_log_scale = ReadStream<LogScale>(stream);
+  return {layout, pt_tensor_names, scalar, pt_log_scale};
 }
 
 }  // namespace fhelipe
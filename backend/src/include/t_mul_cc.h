@@ -53,6 +53,7 @@ class TMulCC final : public TOp {
   }
   LogScale AddedLogScale() const final { return 0; }
   int BackendMaskDepth() const final { return 0; }
+  bool IsCommutative() const final { return true; }
 
   const std::string& TypeName() const final { return StaticTypeName(); }
 
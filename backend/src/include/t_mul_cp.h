@@ -58,6 +58,7 @@ class TMulCP final : public TOp {
 
   LogScale AddedLogScale() const final { return pt_tensor_log_scale_; }
   int BackendMaskDepth() const final { return 0; }
+  std::size_t Hash() const final;
 
   const std::string& TypeName() const final { return StaticTypeName(); }
 
@@ -19,8 +19,10 @@
 #ifndef FHELIPE_T_OP_H_
 #define FHELIPE_T_OP_H_
 
+#include <cstddef>
 #include <memory>
 #include <ostream>
+#include <string>
 #include <vector>
 
 #include "laid_out_tensor.h"
@@ -62,6 +64,15 @@ class TOp {
   virtual LogScale AddedLogScale() const { return 0; }
   virtual int BackendMaskDepth() const { return 0; }
 
+  // Structural hash; TOps that compare equal hash to the same value
+  virtual std::size_t Hash() const;
+  // Whether the result is independent of the order of the input tensors
+  virtual bool IsCommutative() const { return false; }
+  static std::size_t HashCombine(std::size_t seed, std::size_t value) {
+    return seed ^
+           (value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2));
+  }
+
   virtual const std::string& TypeName() const = 0;
   static std::unique_ptr<TOp> CreateInstance(std::istream& stream);
   virtual void SetLayouts(const TensorLayout& input_layout,
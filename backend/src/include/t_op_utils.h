@@ -20,6 +20,7 @@
 #define FHELIPE_T_OP_UTILS_H_
 
 #include <functional>
+#include <memory>
 #include <vector>
 
 #include "chunk_ir.h"
@@ -27,6 +28,7 @@
 #include "ct_program.h"
 #include "dictionary.h"
 #include "laid_out_tensor.h"
+#include "node.h"
 #include "t_op.h"
 
 namespace fhelipe {
@@ -37,6 +39,10 @@ TOp::LaidOutTensorCt CreateCtPtTensorOp(
     const std::function<TOp::Chunk(ct_program::CtProgram&, const TOp::Chunk&,
                                    const ChunkIr&, LogScale)>& CreateCtOp);
 
+// Removes `node` and then, transitively, the parents it leaves unused. Inputs
+// and outputs are never removed.
+void RemoveDeadTOps(const std::shared_ptr<Node<TOp>>& node);
+
 }  // namespace fhelipe
 
 #endif  // FHELIPE_T_OP_UTILS_H_
@@ -30,6 +30,7 @@
 #include "shape.h"
 #include "t_op.h"
 #include "tensor_layout.h"
+#include "translation_mask_utils.h"
 #include "utils.h"
 
 namespace fhelipe {
@@ -66,10 +67,10 @@ class TReorderDimsC final : public TOp {
   void SetLayouts(const TensorLayout& input_layout,
                   const TensorLayout& output_layout) final;
   LogScale AddedLogScale() const final { return 0; }
-  int BackendMaskDepth() const final {
-    // TODO(nsamar): Not sure this needs to be depth 1
-    // Could get away with zero?
-    return 1;
+  int BackendMaskDepth() const final;
+  bool InputPaddingIsZero() const { return mask_depth_.InputPaddingIsZero(); }
+  void SetInputPaddingIsZero(bool input_padding_is_zero) {
+    mask_depth_.SetInputPaddingIsZero(input_padding_is_zero);
   }
 
   const std::vector<int>& DimensionOrder() const { return dim_order_; }
@@ -89,9 +90,11 @@ class TReorderDimsC final : public TOp {
   TensorLayout input_layout_;
   TensorLayout output_layout_;
   std::vector<int> dim_order_;
+  TranslationMaskDepthCache mask_depth_;
 
   static TOpDerivedRegistrar<TReorderDimsC> reg_;
   bool EqualTo(const TOp& other) const final;
+  std::vector<TranslationMask> TranslationMasks() const;
 };
 
 inline TOpDerivedRegistrar<TReorderDimsC> TReorderDimsC::reg_{
@@ -107,6 +110,8 @@ inline void WriteStream<TReorderDimsC>(std::ostream& stream,
   WriteStream<TensorLayout>(stream, node.OutputLayout());
   stream << " ";
   WriteStream(stream, node.DimensionOrder());
+  stream << " ";
+  WriteStream<bool>(stream, node.InputPaddingIsZero());
 }
 
 template <>
@@ -115,7 +120,10 @@ inline TReorderDimsC ReadStreamWithoutTypeNamePrefix<TReorderDimsC>(
   auto input_layout = ReadStream<TensorLayout>(stream);
   auto output_layout = ReadStream<TensorLayout>(stream);
   auto dim_order = ReadStream<std::vector<int>>(stream);
-  return {input_layout, output_layout, dim_order};
+  auto input_padding_is_zero = ReadStream<bool>(stream);
+  TReorderDimsC result(input_layout, output_layout, dim_order);
+  result.SetInputPaddingIsZero(input_padding_is_zero);
+  return result;
 }
 
 }  // namespace fhelipe
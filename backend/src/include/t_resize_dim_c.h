@@ -28,6 +28,7 @@
 #include "include/constants.h"
 #include "include/laid_out_tensor.h"
 #include "include/tensor_layout.h"
+#include "include/translation_mask_utils.h"
 #include "shape.h"
 #include "t_op.h"
 
@@ -57,6 +58,10 @@ class TResizeDimC final : public TOp {
   }
   LogScale AddedLogScale() const final { return 0; }
   int BackendMaskDepth() const final;
+  bool InputPaddingIsZero() const { return mask_depth_.InputPaddingIsZero(); }
+  void SetInputPaddingIsZero(bool input_padding_is_zero) {
+    mask_depth_.SetInputPaddingIsZero(input_padding_is_zero);
+  }
 
   const std::string& TypeName() const final { return StaticTypeName(); }
 
@@ -74,9 +79,11 @@ class TResizeDimC final : public TOp {
  private:
   TensorLayout input_layout_;
   TensorLayout output_layout_;
+  TranslationMaskDepthCache mask_depth_;
 
   static TOpDerivedRegistrar<TResizeDimC> reg_;
   bool EqualTo(const TOp& other) const final;
+  std::vector<TranslationMask> TranslationMasks() const;
 };
 
 inline TOpDerivedRegistrar<TResizeDimC> TResizeDimC::reg_{
@@ -90,6 +97,8 @@ inline void WriteStream<TResizeDimC>(std::ostream& stream,
   WriteStream<TensorLayout>(stream, node.InputLayout());
   stream << " ";
   WriteStream<TensorLayout>(stream, node.OutputLayout());
+  stream << " ";
+  WriteStream<bool>(stream, node.InputPaddingIsZero());
 }
 
 template <>
@@ -97,7 +106,10 @@ inline TResizeDimC ReadStreamWithoutTypeNamePrefix<TResizeDimC>(
     std::istream& stream) {
   auto input_layout = ReadStream<TensorLayout>(stream);
   auto output_layout = ReadStream<TensorLayout>(stream);
-  return {input_layout, output_layout};
+  auto input_padding_is_zero = ReadStream<bool>(stream);
+  TResizeDimC result(input_layout, output_layout);
+  result.SetInputPaddingIsZero(input_padding_is_zero);
+  return result;
 }
 }  // namespace fhelipe
 
@@ -60,6 +60,7 @@ class TRotateC final : public TOp {
 
   LogScale AddedLogScale() const final { return 0; }
   int BackendMaskDepth() const final { return 0; }
+  std::size_t Hash() const final;
   int RotateBy() const { return rotate_by_; }
   void SetLayouts(const TensorLayout& input_layout,
                   const TensorLayout& output_layout) final;
@@ -30,6 +30,7 @@
 #include "include/laid_out_tensor.h"
 #include "include/shape.h"
 #include "include/tensor_layout.h"
+#include "include/translation_mask_utils.h"
 #include "t_op.h"
 #include "utils.h"
 
@@ -75,7 +76,11 @@ class TStrideC final : public TOp {
       ct_program::CtProgram& ct_program,
       const std::vector<LaidOutTensorCt>& input_tensors) const final;
   LogScale AddedLogScale() const final { return 0; }
-  int BackendMaskDepth() const final { return 1; }
+  int BackendMaskDepth() const final;
+  bool InputPaddingIsZero() const { return mask_depth_.InputPaddingIsZero(); }
+  void SetInputPaddingIsZero(bool input_padding_is_zero) {
+    mask_depth_.SetInputPaddingIsZero(input_padding_is_zero);
+  }
   const TensorLayout& InputLayout() const { return input_layout_; }
   const TensorLayout& OutputLayout() const final { return output_layout_; }
   std::unique_ptr<TOp> CloneUniq() const final {
@@ -102,9 +107,11 @@ class TStrideC final : public TOp {
   TensorLayout input_layout_;
   TensorLayout output_layout_;
   std::vector<Stride> strides_;
+  TranslationMaskDepthCache mask_depth_;
 
   static TOpDerivedRegistrar<TStrideC> reg_;
   bool EqualTo(const TOp& other) const final;
+  std::vector<TranslationMask> TranslationMasks() const;
 };
 
 inline Stride::Stride(int stride) : stride_(stride) {
@@ -122,6 +129,8 @@ inline void WriteStream<TStrideC>(std::ostream& stream, const TStrideC& node) {
   WriteStream<TensorLayout>(stream, node.OutputLayout());
   stream << " ";
   WriteStream(stream, node.Strides());
+  stream << " ";
+  WriteStream<bool>(stream, node.InputPaddingIsZero());
 }
 
 template <>
@@ -130,7 +139,10 @@ inline TStrideC ReadStreamWithoutTypeNamePrefix<TStrideC>(
   auto input_layout = ReadStream<TensorLayout>(stream);
   auto output_layout = ReadStream<TensorLayout>(stream);
   auto strides = ReadStream<std::vector<Stride>>(stream);
-  return {input_layout, output_layout, strides};
+  auto input_padding_is_zero = ReadStream<bool>(stream);
+  TStrideC result(input_layout, output_layout, strides);
+  result.SetInputPaddingIsZero(input_padding_is_zero);
+  return result;
 }
 
 }  // namespace fhelipe
@@ -58,7 +58,7 @@ class TUnpaddedShiftC final : public TOp {
   }
   const DiffTensorIndex& RotateBy() const { return rotate_by_; }
   LogScale AddedLogScale() const final { return 0; }
-  int BackendMaskDepth() const final;
+  int BackendMaskDepth() const final { return backend_mask_depth_; }
 
   const DiffTensorIndex& GetDiffTensorIndex() const { return rotate_by_; }
 
@@ -79,9 +79,12 @@ class TUnpaddedShiftC final : public TOp {
   TensorLayout layout_;
   DiffTensorIndex rotate_by_;
   std::vector<TranslationMask> translation_masks_;
+  // Derived from translation_masks_ whenever they are rebuilt
+  int backend_mask_depth_;
 
   static TOpDerivedRegistrar<TUnpaddedShiftC> reg_;
   bool EqualTo(const TOp& other) const final;
+  int ComputeBackendMaskDepth() const;
 };
 
 inline TOpDerivedRegistrar<TUnpaddedShiftC> TUnpaddedShiftC::reg_{
@@ -20,7 +20,9 @@
 #define FHELIPE_TENSOR_LAYOUT_H_
 
 #include <algorithm>
+#include <atomic>
 #include <iostream>
+#include <memory>
 #include <optional>
 #include <string>
 #include <unordered_map>
@@ -41,6 +43,10 @@ class TensorLayout {
  public:
   using LayoutBit = std::optional<DimensionBit>;
   TensorLayout(const Shape& shape, const std::vector<LayoutBit>& layout_bits);
+  TensorLayout(const TensorLayout& other);
+  TensorLayout(TensorLayout&& other) noexcept;
+  TensorLayout& operator=(const TensorLayout& other);
+  TensorLayout& operator=(TensorLayout&& other) noexcept;
 
   const Shape& GetShape() const;
   TensorIndex ChunkOffsetAt(const TensorIndex& ti) const;
@@ -52,6 +58,10 @@ class TensorLayout {
 
   MaybeTensorIndex TensorIndexAt(int chunk_index) const;
   std::vector<MaybeTensorIndex> TensorIndices(TensorIndex offset) const;
+  // Flat tensor index held by every slot of the chunk at `offset`, or
+  // std::nullopt for slots that do not hold a tensor element
+  std::vector<std::optional<int>> FlatTensorIndices(
+      const TensorIndex& offset) const;
   int ChunkIndexAt(const TensorIndex& ti) const;
   IndexMask MaskOfChunk() const;
   IndexMask MaskOfDimension(int dimension) const;
@@ -61,13 +71,44 @@ class TensorLayout {
   std::vector<DimensionBit> TensorOffsetBits() const;
 
  private:
+  struct IndexTables;
+
   Shape shape_;
   std::vector<LayoutBit> bits_;
+  // Built on first use and owned by a process-wide cache that is shared
+  // between equal layouts; atomic since layouts are used by several threads
+  mutable std::atomic<const IndexTables*> index_tables_ = nullptr;
 
   void CheckRep() const;
-  std::vector<std::pair<int, LayoutBit>> BitsInIndex(int index) const;
+  const IndexTables& Tables() const;
 };
 
+inline TensorLayout::TensorLayout(const TensorLayout& other)
+    : shape_(other.shape_),
+      bits_(other.bits_),
+      index_tables_(other.index_tables_.load(std::memory_order_acquire)) {}
+
+inline TensorLayout::TensorLayout(TensorLayout&& other) noexcept
+    : shape_(std::move(other.shape_)),
+      bits_(std::move(other.bits_)),
+      index_tables_(other.index_tables_.exchange(nullptr)) {}
+
+inline TensorLayout& TensorLayout::operator=(const TensorLayout& other) {
+  shape_ = other.shape_;
+  bits_ = other.bits_;
+  index_tables_.store(other.index_tables_.load(std::memory_order_acquire),
+                      std::memory_order_release);
+  return *this;
+}
+
+inline TensorLayout& TensorLayout::operator=(TensorLayout&& other) noexcept {
+  shape_ = std::move(other.shape_);
+  bits_ = std::move(other.bits_);
+  index_tables_.store(other.index_tables_.exchange(nullptr),
+                      std::memory_order_release);
+  return *this;
+}
+
 inline const Shape& TensorLayout::GetShape() const { return shape_; }
 
 inline int TensorLayout::TotalChunks() const { return ChunkOffsets().size(); }
@@ -19,6 +19,7 @@
 #ifndef FHELIPE_TRANSLATION_MASK_GENERATOR_H_
 #define FHELIPE_TRANSLATION_MASK_GENERATOR_H_
 
+#include <cstdint>
 #include <iosfwd>
 #include <string>
 #include <unordered_map>
@@ -62,14 +63,15 @@ class TranslationMaskGenerator {
 
   std::vector<TranslationMask> GetTranslationMasks() const;
   void RegisterTranslation(const LaidOutTensorTranslation& diff,
-                           const LaidOutTensorIndex& ti);
+                           int chunk_number, int chunk_index);
 
  private:
-  std::unordered_map<LaidOutTensorTranslation, std::vector<LaidOutTensorIndex>,
-                     transhash>
-      diff_map_;
+  // One bitset of slots per chunk of layout_; left empty for all-zero chunks
+  using MaskBits = std::vector<std::vector<uint64_t>>;
+
+  std::unordered_map<LaidOutTensorTranslation, MaskBits, transhash> diff_map_;
   TensorLayout layout_;
-  LaidOutTensor<ChunkIr> GetMask(const LaidOutTensorTranslation& trans) const;
+  LaidOutTensor<ChunkIr> GetMask(const MaskBits& mask_bits) const;
 };
 
 }  // namespace fhelipe
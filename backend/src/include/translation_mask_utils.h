@@ -19,10 +19,14 @@
 #ifndef FHELIPE_TRANSLATION_MASK_UTILS_H_
 #define FHELIPE_TRANSLATION_MASK_UTILS_H_
 
+#include <functional>
+#include <optional>
 #include <vector>
 
+#include "dimension_bit.h"
 #include "laid_out_tensor.h"
 #include "laid_out_tensor_index.h"
+#include "shape.h"
 #include "t_op.h"
 #include "translation_mask_generator.h"
 
@@ -51,11 +55,66 @@ std::vector<TOp::LaidOutChunk> ApplyTranslationsButNotMasks(
     const std::vector<TranslationMask>& trans_masks,
     const TensorLayout& output_layout);
 
+// Masks that are one on every slot of their chunk keep the chunk as is, so
+// their multiplications can be skipped: returns 0 if all masks are like that
+// and 1 otherwise. Slots that hold no tensor element are only assumed to be
+// zero if `input_padding_is_zero`, in which case the masks need not be one
+// there.
+int TranslationMaskDepth(const std::vector<TranslationMask>& trans_masks,
+                         bool input_padding_is_zero = false);
+
+// TranslationMaskDepth of a TOp's translation masks, computed on first query
+// since the masks are costly to build; Reset() it when the layouts change
+class TranslationMaskDepthCache {
+ public:
+  int Get(const std::function<std::vector<TranslationMask>()>& make_masks)
+      const;
+  void Reset() { depth_.reset(); }
+
+  // Set by ZeroPaddingPass; the input of a fresh TOp is not assumed to have
+  // zero padding
+  bool InputPaddingIsZero() const { return input_padding_is_zero_; }
+  void SetInputPaddingIsZero(bool input_padding_is_zero) {
+    input_padding_is_zero_ = input_padding_is_zero;
+    Reset();
+  }
+
+ private:
+  mutable std::optional<int> depth_;
+  bool input_padding_is_zero_ = false;
+};
+
+// Dispatches to ApplyTranslationMasks or ApplyTranslationsButNotMasks
+// according to TranslationMaskDepth(trans_masks, input_padding_is_zero).
+std::vector<TOp::LaidOutChunk> ApplyTranslations(
+    ct_program::CtProgram& ct_program, const TOp::LaidOutTensorCt& input_tensor,
+    const std::vector<TranslationMask>& trans_masks,
+    const TensorLayout& output_layout, bool input_padding_is_zero = false);
+
 std::vector<TranslationMask> MakeTranslationMasks(
     const TensorLayout& input_layout, const TensorLayout& output_layout,
     const std::function<std::optional<TensorIndex>(const TensorIndex&)>&
         src_to_dest_func);
 
+// [dimension][bit] -> bit of the destination index that this bit of a source
+// index moves to, or std::nullopt if only sources with this bit cleared have
+// a destination
+using IndexBitMap = std::vector<std::vector<std::optional<DimensionBit>>>;
+
+// Maps every index bit of `shape` to itself, as a layout conversion does
+IndexBitMap IdentityIndexBitMap(const Shape& shape);
+// The bit map of striding `shape` by `strides`, if they are all powers of two
+std::optional<IndexBitMap> StrideIndexBitMap(const Shape& shape,
+                                             const std::vector<int>& strides);
+
+// Same as above for a destination that is a permutation of the source index
+// bits: the destination of every slot is assembled from per-bit tables
+// instead of being looked up per element. Destinations must lie within the
+// output shape.
+std::vector<TranslationMask> MakeTranslationMasks(
+    const TensorLayout& input_layout, const TensorLayout& output_layout,
+    const IndexBitMap& index_bit_map);
+
 }  // namespace fhelipe
 
 #endif  // FHELIPE_TRANSLATION_MASK_UTILS_H_
@@ -22,6 +22,7 @@
 #include <glog/logging.h>
 
 #include <cmath>
+#include <functional>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -42,6 +43,10 @@ inline int Log2(int x) {
   return 1 + Log2(x >> 1);
 }
 
+// Calls `func` on 0, ..., count - 1 from up to `thread_count` threads
+void ParallelFor(int count, int thread_count,
+                 const std::function<void(int)>& func);
+
 }  // namespace fhelipe
 
 #endif  // FHELIPE_UTILS_H_
@@ -35,6 +35,7 @@ class WaterlineRescale : public RescalingPass {
     static PassName pass_name = PassName("waterline_rescale");
     return pass_name;
   }
+  std::string PassSettings() const final { return ToString(context_); }
   std::unique_ptr<RescalingPass> CloneUniq() const final {
     return std::make_unique<WaterlineRescale>(*this);
   }
@@ -24,7 +24,11 @@
 #include <cstdint>
 #include <cstdlib>
 #include <fstream>
+#include <map>
+#include <mutex>
 #include <string>
+#include <tuple>
+#include <utility>
 #include <vector>
 
 #include "include/checker.h"
@@ -83,13 +87,24 @@ LattigoCt LattigoCt::ZeroC(const ProgramContext& context,
   if (!scheme_initialized_) {
     InitScheme(context);
   }
-  auto pt_chunk =
-      PtChunk(std::vector<PtVal>(1 << context.GetLogChunkSize().value()));
-  Plaintext pt = encodeNTTAtLvlNew(*params_, *encoder_, pt_chunk.Values(),
-                                   level_info.Level().value(),
-                                   LogScaleToScale(level_info.LogScale()));
-  return LattigoCt{encryptNew(context.GetLattigoParam(), *encryptor_, pt),
-                   Cleartext::ZeroC(context, level_info)};
+  // A freshly allocated ciphertext has all-zero polynomials, i.e., it is a
+  // trivial encryption of zero. Every LattigoCt operation copies its operands
+  // before writing, so one ciphertext per parameter set, level and scale can
+  // be shared. Evaluation may run on several threads.
+  static std::mutex zero_cts_mutex;
+  static std::map<std::tuple<std::string, int, int>, Ciphertext> zero_cts;
+  auto key = std::make_tuple(
+      context.GetLattigoParam().GetMarshalFolderExtension(),
+      level_info.Level().value(), level_info.LogScale().value());
+  std::lock_guard<std::mutex> lock(zero_cts_mutex);
+  auto it = zero_cts.find(key);
+  if (it == zero_cts.end()) {
+    auto zero_ct = newCiphertext(context.GetLattigoParam(), *params_, 1,
+                                 level_info.Level().value(),
+                                 LogScaleToScale(level_info.LogScale()));
+    it = zero_cts.emplace(key, zero_ct).first;
+  }
+  return LattigoCt{it->second, Cleartext::ZeroC(context, level_info)};
 }
 
 LattigoCt LattigoCt::Encrypt(const ProgramContext& context,
@@ -216,6 +231,14 @@ LattigoCt LattigoCt::RescaleC(LogScale rescale_amount) const {
   return latti_result;
 }
 
+LattigoCt LattigoCt::DropLevelC(Level level) const {
+  InitEvaluator(MakeProgramContext(ciphertext_.GetLattigoParam()));
+  CHECK(level <= GetLevel());
+  auto result = copyNew(ciphertext_);
+  dropLevel(*evaluator_, result, GetLevel().value() - level.value());
+  return LattigoCt(result, GetCleartext().DropLevelC(level));
+}
+
 LattigoCt LattigoCt::RotateC(int rotate_by) const {
   InitEvaluator(MakeProgramContext(ciphertext_.GetLattigoParam()));
   int slot_count = 1 << (ciphertext_.GetLattigoParam().LogN() - 1);
@@ -0,0 +1,125 @@
+/** $lic$
+ * Copyright (C) 2023-2024 by Massachusetts Institute of Technology
+ *
+ * This file is part of the Fhelipe compiler.
+ *
+ * Fhelipe is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * Fhelipe is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>. 
+ */
+
+#include "include/layout_cost_model.h"
+
+#include <glog/logging.h>
+
+#include "include/extended_std.h"
+#include "include/layout_hoisting_pass.h"
+#include "include/t_cyclic_shift_c.h"
+#include "include/t_input_c.h"
+#include "include/t_layout_conversion_c.h"
+#include "include/t_mul_cc.h"
+#include "include/t_output_c.h"
+#include "include/t_reduce_dim_c.h"
+#include "include/t_replicate_dim_c.h"
+#include "include/t_rotate_c.h"
+#include "include/t_unpadded_shift_c.h"
+#include "include/utils.h"
+
+namespace fhelipe {
+
+namespace {
+
+// Bits of `dimension` at or above `min_bit_index` that lie inside chunks
+int ChunkBitCount(const TensorLayout& layout, int dimension,
+                  int min_bit_index = 0) {
+  return Estd::count_if(layout.Bits(), [=](const auto& bit) {
+    return bit.has_value() && bit.value().dimension == dimension &&
+           bit.value().bit_index >= min_bit_index;
+  });
+}
+
+// Key switches per output chunk, counted the way AmendCtProgram lowers each
+// TOp: only bits inside chunks need rotations
+double KeySwitchCount(const TOp& t_op) {
+  int chunks = t_op.OutputLayout().TotalChunks();
+  if (const auto* t_layout_conversion_c =
+          dynamic_cast<const TLayoutConversionC*>(&t_op)) {
+    return TotalLayoutConversionTentaclesEstimate(
+        t_layout_conversion_c->InputLayout(),
+        t_layout_conversion_c->OutputLayout());
+  }
+  if (const auto* t_reduce_dim_c = dynamic_cast<const TReduceDimC*>(&t_op)) {
+    return chunks * ChunkBitCount(t_reduce_dim_c->InputLayout(),
+                                  t_reduce_dim_c->DimensionToReduce());
+  }
+  if (const auto* t_replicate_dim_c =
+          dynamic_cast<const TReplicateDimC*>(&t_op)) {
+    const auto& input_layout = t_replicate_dim_c->InputLayout();
+    int dimension = t_replicate_dim_c->DimensionToReplicate();
+    int new_bits = ChunkBitCount(t_replicate_dim_c->OutputLayout(), dimension,
+                                 ceil_log2(input_layout.GetShape()[dimension]));
+    return input_layout.TotalChunks() * new_bits;
+  }
+  if (dynamic_cast<const TMulCC*>(&t_op) ||
+      dynamic_cast<const TRotateC*>(&t_op)) {
+    return chunks;
+  }
+  if (dynamic_cast<const TUnpaddedShiftC*>(&t_op) ||
+      dynamic_cast<const TCyclicShiftC*>(&t_op)) {
+    // A shift generally splits every chunk across two chunks
+    return 2 * chunks;
+  }
+  return 0;
+}
+
+}  // namespace
+
+double KeySwitchCostModel::TOpCost(const TOp& t_op) const {
+  if (dynamic_cast<const TInputC*>(&t_op) ||
+      dynamic_cast<const TOutputC*>(&t_op)) {
+    return 0;
+  }
+  double key_switches = KeySwitchCount(t_op);
+  // Every rotation also comes with a masking multiply and an addition
+  return key_switches +
+         other_op_cost_ * (t_op.OutputLayout().TotalChunks() + key_switches);
+}
+
+double TentacleCostModel::TOpCost(const TOp& t_op) const {
+  if (const auto* t_layout_conversion_c =
+          dynamic_cast<const TLayoutConversionC*>(&t_op)) {
+    return TotalLayoutConversionTentaclesEstimate(
+        t_layout_conversion_c->InputLayout(),
+        t_layout_conversion_c->OutputLayout());
+  }
+  return 0;
+}
+
+std::unique_ptr<LayoutCostModel> LayoutCostModelFromName(
+    const std::string& name) {
+  if (name == KeySwitchCostModel().Name()) {
+    return std::make_unique<KeySwitchCostModel>();
+  }
+  if (name == TentacleCostModel().Name()) {
+    return std::make_unique<TentacleCostModel>();
+  }
+  LOG(FATAL) << "Unknown layout cost model: " << name;
+}
+
+double EstimatedCost(const Dag<TOp>& dag, const LayoutCostModel& cost_model) {
+  double result = 0;
+  for (const auto& node : dag.NodesInTopologicalOrder()) {
+    result += cost_model.TOpCost(node->Value());
+  }
+  return result;
+}
+
+}  // namespace fhelipe
@@ -18,14 +18,18 @@
 
 #include "include/level_minimization_pass.h"
 
+#include <unordered_map>
+
 #include "include/bootstrap_c.h"
 #include "include/ct_op.h"
 #include "include/ct_program.h"
+#include "include/drop_level_c.h"
 #include "include/extended_std.h"
 #include "include/input_c.h"
 #include "include/output_c.h"
 #include "include/pass_utils.h"
 #include "include/rescale_c.h"
+#include "include/zero_c.h"
 
 namespace fhelipe {
 
@@ -49,19 +53,91 @@ Level GetMinLevel(const Node<CtOp>& node) {
   }));
 }
 
+using RuntimeLevels = std::unordered_map<const Node<CtOp>*, Level>;
+
+// Level of the ciphertext the runtime actually produces for `node`: inputs are
+// encrypted at the top level, bootstraps produce the usable levels of their
+// TBootstrapC, and only rescales and explicit level drops lower it
+Level GetRuntimeLevel(const Node<CtOp>& node,
+                      const RuntimeLevels& runtime_levels,
+                      const RuntimeLevels& bootstrap_levels,
+                      Level usable_levels) {
+  if (dynamic_cast<const InputC*>(&node.Value())) {
+    return usable_levels;
+  }
+  if (dynamic_cast<const BootstrapC*>(&node.Value())) {
+    return bootstrap_levels.at(&node);
+  }
+  if (dynamic_cast<const ZeroC*>(&node.Value())) {
+    return node.Value().GetLevel();
+  }
+  auto parent_levels = Estd::transform(
+      node.Parents(),
+      [&runtime_levels](const auto& parent) {
+        return runtime_levels.at(parent.get());
+      });
+  auto level = Estd::min_element(parent_levels);
+  if (dynamic_cast<const RescaleC*>(&node.Value())) {
+    return Level(level.value() - 1);
+  }
+  return level;
+}
+
+// Drops `node` to its minimized level before it reaches its consumers.
+// Bootstraps are left alone, since they handle their own input level.
+void InsertDropLevel(ct_program::CtProgram& ct_program,
+                     const std::shared_ptr<Node<CtOp>>& node,
+                     RuntimeLevels& runtime_levels) {
+  auto children = Estd::filter(
+      Estd::set_to_vector(node->Children()), [](const auto& child) {
+        return !dynamic_cast<const BootstrapC*>(&child->Value());
+      });
+  if (children.empty()) {
+    return;
+  }
+  // Shares the ancestors of `node`, so it is scheduled right after it
+  auto drop = ct_program.AddNode(
+      std::make_unique<DropLevelC>(node->Value().GetLevelInfo()), {node},
+      node->Ancestors());
+  for (const auto& child : children) {
+    ReplaceParent(child, *node, drop);
+  }
+  runtime_levels.emplace(drop.get(), node->Value().GetLevel());
+}
+
 }  // namespace
 
 CtOpOptimizerOutput LevelMinimizationPass::DoPass(
     const CtOpOptimizerInput& in_dag) {
   auto out_dag = CloneFromAncestor(in_dag.GetDag());
 
+  // Taken before minimization, which lowers the annotations of bootstraps to
+  // what their consumers need
+  RuntimeLevels bootstrap_levels;
+  for (const auto& node : out_dag.NodesInTopologicalOrder()) {
+    if (dynamic_cast<const BootstrapC*>(&node->Value())) {
+      bootstrap_levels.emplace(node.get(), node->Value().GetLevel());
+    }
+  }
   for (const auto& node : out_dag.NodesInReverseTopologicalOrder()) {
     auto new_level = GetMinLevel(*node);
     node->Value().SetLevelInfo({new_level, node->Value().LogScale()});
   }
-  return ct_program::CtProgram{in_dag.GetProgramContext(),
-                               in_dag.ChunkDictionary()->CloneUniq(),
-                               std::move(out_dag)};
+  auto out_program = in_dag.WithDag(std::move(out_dag));
+
+  // The annotated levels are only honored at runtime through explicit drops
+  auto usable_levels = in_dag.GetProgramContext().UsableLevels();
+  RuntimeLevels runtime_levels;
+  for (const auto& node : out_program.NodesInTopologicalOrder()) {
+    auto level = GetRuntimeLevel(*node, runtime_levels, bootstrap_levels,
+                                 usable_levels);
+    runtime_levels.emplace(node.get(), level);
+    if (level > node->Value().GetLevel() &&
+        !dynamic_cast<const OutputC*>(&node->Value())) {
+      InsertDropLevel(out_program, node, runtime_levels);
+    }
+  }
+  return out_program;
 }
 
 }  // namespace fhelipe
@@ -0,0 +1,245 @@
+/** $lic$
+ * Copyright (C) 2023-2024 by Massachusetts Institute of Technology
+ *
+ * This file is part of the Fhelipe compiler.
+ *
+ * Fhelipe is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * Fhelipe is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>. 
+ */
+
+#include "include/level_path_counts.h"
+
+#include <functional>
+#include <limits>
+#include <queue>
+
+#include "include/extended_std.h"
+#include "include/rescale_c.h"
+
+namespace fhelipe {
+
+namespace {
+
+typedef LevelPathCounts::PathCount PathCount;
+
+constexpr PathCount kMaxPathCount = std::numeric_limits<PathCount>::max();
+
+// Counts are never negative, so overflowing always means too large
+PathCount SaturatingAdd(PathCount lhs, PathCount rhs) {
+  PathCount result;
+  return __builtin_add_overflow(lhs, rhs, &result) ? kMaxPathCount : result;
+}
+
+PathCount SaturatingMul(PathCount lhs, PathCount rhs) {
+  PathCount result;
+  return __builtin_mul_overflow(lhs, rhs, &result) ? kMaxPathCount : result;
+}
+
+bool IsRescale(const Node<CtOp>& node) {
+  return dynamic_cast<const RescaleC*>(&node.Value()) != nullptr;
+}
+
+// Visits `first`'s neighbors and, for every neighbor whose counts change,
+// that neighbor's neighbors. The neighbor that comes first in `Compare` on
+// dense indices is visited first.
+template <class Compare>
+void Propagate(int first, const std::vector<std::vector<int>>& neighbors,
+               const std::function<bool(int)>& update,
+               std::vector<int>& changed) {
+  // The heap puts the last element in `Compare` on top
+  auto comes_later = [](int lhs, int rhs) { return Compare()(rhs, lhs); };
+  std::priority_queue<int, std::vector<int>, decltype(comes_later)> pending(
+      comes_later);
+  std::vector<bool> queued(neighbors.size());
+  auto enqueue_neighbors = [&](int idx) {
+    for (int neighbor : neighbors.at(idx)) {
+      if (!queued.at(neighbor)) {
+        queued.at(neighbor) = true;
+        pending.push(neighbor);
+      }
+    }
+  };
+  enqueue_neighbors(first);
+  while (!pending.empty()) {
+    int idx = pending.top();
+    pending.pop();
+    if (update(idx)) {
+      changed.push_back(idx);
+      enqueue_neighbors(idx);
+    }
+  }
+}
+
+}  // namespace
+
+LevelPathCounts::LevelPathCounts(const Dag<CtOp>& dag,
+                                 const Level& usable_levels)
+    : level_count_(usable_levels.value()),
+      nodes_(dag.NodesInTopologicalOrder()) {
+  for (int idx : Estd::indices(nodes_.size())) {
+    dense_indices_.emplace(nodes_.at(idx).get(), idx);
+  }
+  for (const auto& node : nodes_) {
+    parents_.push_back(Estd::set_to_vector(Estd::transform(
+        Estd::vector_to_set(node->Parents()),
+        [this](const auto& parent) { return DenseIndex(*parent); })));
+    children_.push_back(Estd::set_to_vector(Estd::transform(
+        node->Children(),
+        [this](const auto& child) { return DenseIndex(*child); })));
+    is_rescale_.push_back(IsRescale(*node));
+    has_rescale_child_.push_back(Estd::any_of(
+        node->Children(), [](const auto& child) { return IsRescale(*child); }));
+  }
+  bootstrapped_.resize(nodes_.size());
+  backward_.resize(nodes_.size() * level_count_);
+  forward_.resize(nodes_.size() * level_count_);
+  path_counts_.resize(nodes_.size());
+
+  for (int idx : Estd::indices(nodes_.size())) {
+    UpdateBackward(idx);
+  }
+  for (int idx : Estd::reverse(Estd::indices(nodes_.size()))) {
+    UpdateForward(idx);
+  }
+  for (int idx : Estd::indices(nodes_.size())) {
+    UpdatePathCount(idx);
+  }
+
+  max_tree_.resize(2 * nodes_.size());
+  for (int idx : Estd::indices(nodes_.size())) {
+    max_tree_.at(nodes_.size() + idx) = idx;
+  }
+  for (int tree_idx = nodes_.size() - 1; tree_idx > 0; --tree_idx) {
+    int lhs = max_tree_.at(2 * tree_idx);
+    int rhs = max_tree_.at(2 * tree_idx + 1);
+    max_tree_.at(tree_idx) = MorePaths(lhs, rhs) ? lhs : rhs;
+  }
+}
+
+bool LevelPathCounts::UpdateBackward(int idx) {
+  std::vector<PathCount> counts(level_count_);
+  if (!bootstrapped_.at(idx)) {
+    if (is_rescale_.at(idx)) {
+      counts.at(0) = 1;
+    }
+    for (int parent : parents_.at(idx)) {
+      for (int level : Estd::indices(level_count_)) {
+        if (!is_rescale_.at(idx)) {
+          counts.at(level) =
+              SaturatingAdd(counts.at(level), Backward(parent, level));
+        } else if (level > 0) {
+          counts.at(level) =
+              SaturatingAdd(counts.at(level), Backward(parent, level - 1));
+        }
+      }
+    }
+  }
+  bool changed = false;
+  for (int level : Estd::indices(level_count_)) {
+    changed |= Backward(idx, level) != counts.at(level);
+    Backward(idx, level) = counts.at(level);
+  }
+  return changed;
+}
+
+bool LevelPathCounts::UpdateForward(int idx) {
+  std::vector<PathCount> counts(level_count_);
+  if (!bootstrapped_.at(idx)) {
+    if (has_rescale_child_.at(idx)) {
+      counts.at(0) = 1;
+    }
+    for (int child : children_.at(idx)) {
+      for (int level : Estd::indices(level_count_)) {
+        if (is_rescale_.at(idx)) {
+          if (level > 0) {
+            counts.at(level) =
+                SaturatingAdd(counts.at(level), Forward(child, level - 1));
+          }
+        } else if (level > 0 || !has_rescale_child_.at(idx)) {
+          counts.at(level) =
+              SaturatingAdd(counts.at(level), Forward(child, level));
+        }
+      }
+    }
+  }
+  bool changed = false;
+  for (int level : Estd::indices(level_count_)) {
+    changed |= Forward(idx, level) != counts.at(level);
+    Forward(idx, level) = counts.at(level);
+  }
+  return changed;
+}
+
+void LevelPathCounts::UpdatePathCount(int idx) {
+  PathCount count = 0;
+  if (!bootstrapped_.at(idx)) {
+    for (int level : Estd::indices(level_count_)) {
+      count = SaturatingAdd(
+          count, SaturatingMul(Backward(idx, level),
+                               Forward(idx, level_count_ - 1 - level)));
+    }
+  }
+  path_counts_.at(idx) = count;
+}
+
+bool LevelPathCounts::MorePaths(int lhs, int rhs) const {
+  auto key = [this](int idx) {
+    return bootstrapped_.at(idx) ? -1 : path_counts_.at(idx);
+  };
+  return key(lhs) > key(rhs) || (key(lhs) == key(rhs) && lhs < rhs);
+}
+
+void LevelPathCounts::UpdateMaxTree(int idx) {
+  for (int tree_idx = (nodes_.size() + idx) / 2; tree_idx > 0; tree_idx /= 2) {
+    int lhs = max_tree_.at(2 * tree_idx);
+    int rhs = max_tree_.at(2 * tree_idx + 1);
+    max_tree_.at(tree_idx) = MorePaths(lhs, rhs) ? lhs : rhs;
+  }
+}
+
+LevelPathCounts::PathCount LevelPathCounts::MaxCount() const {
+  if (nodes_.empty() || bootstrapped_.at(max_tree_.at(1))) {
+    return 0;
+  }
+  return path_counts_.at(max_tree_.at(1));
+}
+
+const std::shared_ptr<Node<CtOp>>& LevelPathCounts::MaxNode() const {
+  CHECK(!nodes_.empty() && !bootstrapped_.at(max_tree_.at(1)));
+  return nodes_.at(max_tree_.at(1));
+}
+
+void LevelPathCounts::Bootstrap(const Node<CtOp>& node) {
+  int idx = DenseIndex(node);
+  CHECK(!bootstrapped_.at(idx));
+  bootstrapped_.at(idx) = true;
+  UpdateBackward(idx);
+  UpdateForward(idx);
+  UpdatePathCount(idx);
+  UpdateMaxTree(idx);
+
+  // Dense indices are in topological order, so every node is recomputed after
+  // all of the neighbors it is recomputed from
+  std::vector<int> changed;
+  Propagate<std::less<int>>(
+      idx, children_, [this](int child) { return UpdateBackward(child); },
+      changed);
+  Propagate<std::greater<int>>(
+      idx, parents_, [this](int parent) { return UpdateForward(parent); },
+      changed);
+  for (int changed_idx : changed) {
+    UpdatePathCount(changed_idx);
+    UpdateMaxTree(changed_idx);
+  }
+}
+
+}  // namespace fhelipe
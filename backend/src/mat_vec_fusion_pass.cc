@@ -0,0 +1,217 @@
+/** $lic$
+ * Copyright (C) 2023-2024 by Massachusetts Institute of Technology
+ *
+ * This file is part of the Fhelipe compiler.
+ *
+ * Fhelipe is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * Fhelipe is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>. 
+ */
+
+#include "include/mat_vec_fusion_pass.h"
+
+#include <algorithm>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "include/extended_std.h"
+#include "include/node.h"
+#include "include/shape.h"
+#include "include/t_drop_dim_c.h"
+#include "include/t_insert_dim_c.h"
+#include "include/t_mat_vec_c.h"
+#include "include/t_mul_cp.h"
+#include "include/t_op_utils.h"
+#include "include/t_reduce_dim_c.h"
+#include "include/t_replicate_dim_c.h"
+#include "include/t_resize_dim_c.h"
+#include "include/tensor_layout.h"
+
+namespace fhelipe {
+
+namespace {
+
+using TOpNode = std::shared_ptr<Node<TOp>>;
+
+// base -> broadcast -> TMulCP -> reduction, as lowered from
+// matrix * vector.replicate(dim=0, n=N) followed by sums over dims 1, 2, ...
+struct MatVec {
+  TOpNode base;
+  std::vector<TOpNode> broadcast;
+  TOpNode product;
+  std::vector<TOpNode> reduction;
+};
+
+bool IsBroadcast(const TOp& t_op) {
+  return dynamic_cast<const TInsertDimC*>(&t_op) ||
+         dynamic_cast<const TResizeDimC*>(&t_op) ||
+         dynamic_cast<const TReplicateDimC*>(&t_op);
+}
+
+bool IsNoopResize(const TOp& t_op) {
+  const auto* t_resize_dim_c = dynamic_cast<const TResizeDimC*>(&t_op);
+  return t_resize_dim_c && t_resize_dim_c->InputLayout().GetShape() ==
+                               t_resize_dim_c->OutputLayout().GetShape();
+}
+
+// Whether `broadcast` inserts dimension 0 and replicates along it, and does
+// nothing else
+bool IsReplicationAlongNewDim(const std::vector<TOpNode>& broadcast) {
+  bool inserted = false;
+  bool replicated = false;
+  for (const auto& node : broadcast) {
+    const auto& t_op = node->Value();
+    if (const auto* t_insert_dim_c = dynamic_cast<const TInsertDimC*>(&t_op)) {
+      if (inserted || t_insert_dim_c->DimensionToInsert() != 0) {
+        return false;
+      }
+      inserted = true;
+    } else if (const auto* t_replicate_dim_c =
+                   dynamic_cast<const TReplicateDimC*>(&t_op)) {
+      if (!inserted || replicated ||
+          t_replicate_dim_c->DimensionToReplicate() != 0 ||
+          t_replicate_dim_c->InputLayout().GetShape()[0] != 1) {
+        return false;
+      }
+      replicated = true;
+    } else if (!IsNoopResize(t_op)) {
+      return false;
+    }
+  }
+  return inserted && replicated;
+}
+
+// Longest prefix of the single-child chain below `product` after which all
+// dimensions but the first are summed away
+std::vector<TOpNode> Reduction(const TOpNode& product) {
+  const auto& shape = product->Value().OutputLayout().GetShape();
+  std::vector<bool> reduced;
+  for (int dim : Estd::indices(shape.DimensionCount())) {
+    reduced.push_back(dim != 0 && shape[dim] == 1);
+  }
+  std::vector<TOpNode> chain;
+  int fused_size = 0;
+  bool summed = false;
+  auto node = product;
+  while (node->Children().size() == 1) {
+    node = *node->Children().begin();
+    const auto& t_op = node->Value();
+    if (const auto* t_reduce_dim_c = dynamic_cast<const TReduceDimC*>(&t_op)) {
+      int dim = t_reduce_dim_c->DimensionToReduce();
+      if (dim == 0) {
+        break;
+      }
+      reduced[dim] = true;
+      summed = true;
+    } else if (const auto* t_drop_dim_c =
+                   dynamic_cast<const TDropDimC*>(&t_op)) {
+      int dim = t_drop_dim_c->DimensionToDrop();
+      if (dim == 0 || !reduced[dim]) {
+        break;
+      }
+      reduced.erase(reduced.begin() + dim);
+    } else if (!IsNoopResize(t_op)) {
+      break;
+    }
+    chain.push_back(node);
+    if (summed && std::all_of(reduced.begin() + 1, reduced.end(),
+                              [](bool x) { return x; })) {
+      fused_size = chain.size();
+    }
+  }
+  chain.resize(fused_size);
+  return chain;
+}
+
+std::optional<MatVec> AsMatVec(const TOpNode& product) {
+  if (!dynamic_cast<const TMulCP*>(&product->Value())) {
+    return std::nullopt;
+  }
+  MatVec mat_vec{nullptr, {}, product, Reduction(product)};
+  if (mat_vec.reduction.empty()) {
+    return std::nullopt;
+  }
+  auto node = product->Parents().at(0);
+  while (IsBroadcast(node->Value())) {
+    mat_vec.broadcast.insert(mat_vec.broadcast.begin(), node);
+    node = node->Parents().at(0);
+  }
+  mat_vec.base = node;
+  if (!IsReplicationAlongNewDim(mat_vec.broadcast)) {
+    return std::nullopt;
+  }
+  return mat_vec;
+}
+
+int InChunkBitCount(const TensorLayout& layout, int dimension) {
+  return std::count_if(
+      layout.Bits().begin(), layout.Bits().end(), [dimension](const auto& bit) {
+        return bit.has_value() && bit.value().dimension == dimension;
+      });
+}
+
+// The unfused TOps rotate every chunk once per bit of the replicated or
+// reduced dimension that lies inside chunks
+int UnfusedRotationCount(const MatVec& mat_vec) {
+  int count = 0;
+  for (const auto& node : mat_vec.broadcast) {
+    if (const auto* t_replicate_dim_c =
+            dynamic_cast<const TReplicateDimC*>(&node->Value())) {
+      const auto& layout = t_replicate_dim_c->OutputLayout();
+      count += layout.TotalChunks() *
+               InChunkBitCount(layout,
+                               t_replicate_dim_c->DimensionToReplicate());
+    }
+  }
+  for (const auto& node : mat_vec.reduction) {
+    if (const auto* t_reduce_dim_c =
+            dynamic_cast<const TReduceDimC*>(&node->Value())) {
+      const auto& layout = t_reduce_dim_c->InputLayout();
+      count += layout.TotalChunks() *
+               InChunkBitCount(layout, t_reduce_dim_c->DimensionToReduce());
+    }
+  }
+  return count;
+}
+
+}  // namespace
+
+LayoutOptimizerOutput MatVecFusionPass::DoPass(
+    const LayoutOptimizerInput& in_dag) {
+  Dag<TOp> out_dag = CloneFromAncestor(in_dag);
+
+  auto products = Estd::filter(
+      out_dag.NodesInTopologicalOrder(), [](const auto& node) {
+        return dynamic_cast<const TMulCP*>(&node->Value()) != nullptr;
+      });
+  for (const auto& product : products) {
+    auto mat_vec = AsMatVec(product);
+    if (!mat_vec.has_value()) {
+      continue;
+    }
+    const auto& t_mul_cp = dynamic_cast<const TMulCP&>(product->Value());
+    const auto& last = mat_vec->reduction.back();
+    auto t_mat_vec_c = std::make_unique<TMatVecC>(
+        mat_vec->base->Value().OutputLayout(), last->Value().OutputLayout(),
+        t_mul_cp.PtTensorName(), t_mul_cp.PtTensorLogScale());
+    if (t_mat_vec_c->RotationCount() > UnfusedRotationCount(mat_vec.value())) {
+      continue;
+    }
+    auto fused = out_dag.AddNode(std::move(t_mat_vec_c), {mat_vec->base},
+                                 last->Ancestors());
+    InheritChildren(*last, fused);
+    RemoveDeadTOps(last);
+  }
+  return out_dag;
+}
+
+}  // namespace fhelipe
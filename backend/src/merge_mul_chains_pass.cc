@@ -18,15 +18,93 @@
 
 #include "include/merge_mul_chains_pass.h"
 
+#include <algorithm>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "include/node.h"
 #include "include/pass_utils.h"
 #include "include/t_merged_mul_chain_cp.h"
+#include "include/t_mul_cp.h"
+#include "include/t_mul_csi.h"
 
 namespace fhelipe {
 
-// nsamar: Does nothing currently
+namespace {
+
+// One or more plaintext or scalar multiplies folded together
+struct MulChain {
+  std::vector<std::string> pt_tensor_names;
+  PtVal scalar;
+  LogScale pt_log_scale;
+};
+
+std::optional<MulChain> AsMulChain(const TOp& t_op) {
+  if (const auto* t_mul_cp = dynamic_cast<const TMulCP*>(&t_op)) {
+    return MulChain{{t_mul_cp->PtTensorName()},
+                    1,
+                    t_mul_cp->PtTensorLogScale()};
+  }
+  if (const auto* t_mul_csi = dynamic_cast<const TMulCSI*>(&t_op)) {
+    return MulChain{{},
+                    t_mul_csi->Scalar().value(),
+                    t_mul_csi->Scalar().GetLogScale()};
+  }
+  if (const auto* merged = dynamic_cast<const TMergedMulChainCP*>(&t_op)) {
+    return MulChain{merged->PtTensorNames(), merged->Scalar(),
+                    merged->PtLogScale()};
+  }
+  return std::nullopt;
+}
+
+MulChain Concatenate(const MulChain& lhs, const MulChain& rhs) {
+  MulChain result = lhs;
+  result.pt_tensor_names.insert(result.pt_tensor_names.end(),
+                                rhs.pt_tensor_names.begin(),
+                                rhs.pt_tensor_names.end());
+  result.scalar *= rhs.scalar;
+  result.pt_log_scale = std::max(lhs.pt_log_scale, rhs.pt_log_scale);
+  return result;
+}
+
+// The parent must feed only this node, or else folding would duplicate it
+bool ParentAndMeAreAMulChain(const Node<TOp>& node) {
+  if (node.Parents().size() != 1) {
+    return false;
+  }
+  auto parent = node.Parents()[0];
+  return parent->Children().size() == 1 && AsMulChain(node.Value()) &&
+         AsMulChain(parent->Value()) &&
+         !(dynamic_cast<const TMulCSI*>(&node.Value()) &&
+           dynamic_cast<const TMulCSI*>(&parent->Value()));
+}
+
+}  // namespace
+
 LayoutOptimizerOutput MergeMulChainsPass::DoPass(
     const LayoutOptimizerInput& in_dag) {
   Dag<TOp> out_dag = CloneFromAncestor(in_dag);
+
+  for (auto node : out_dag.NodesInTopologicalOrder()) {
+    if (!ParentAndMeAreAMulChain(*node)) {
+      continue;
+    }
+    auto parent = node->Parents()[0];
+    CHECK(parent->Value().OutputLayout() == node->Value().OutputLayout());
+    auto chain = Concatenate(AsMulChain(parent->Value()).value(),
+                             AsMulChain(node->Value()).value());
+    AddNodeOnParentChildEdge(
+        parent, node,
+        std::make_shared<Node<TOp>>(
+            std::make_unique<TMergedMulChainCP>(
+                node->Value().OutputLayout(), chain.pt_tensor_names,
+                chain.scalar, chain.pt_log_scale),
+            node->Ancestors()));
+    RemoveNode(*parent);
+    RemoveNode(*node);
+  }
   return out_dag;
 }
 
@@ -28,8 +28,6 @@
 #include "include/encryption_config.h"
 #include "include/extended_std.h"
 #include "include/laid_out_tensor.h"
-#include "include/laid_out_tensor_index.h"
-#include "include/maybe_tensor_index.h"
 #include "include/plaintext.h"
 #include "include/plaintext_chunk.h"
 #include "include/shape.h"
@@ -38,30 +36,27 @@
 
 namespace fhelipe {
 
-PtVal FlatIndexIntoLaidOutTensor(const LaidOutTensor<PtChunk>& lot,
-                                 int flat_index) {
-  auto ti = TensorIndex(lot.Layout().GetShape(), flat_index);
-  return lot.AtOffset(lot.Layout().ChunkOffsetAt(ti))
-      .Chunk()
-      .Values()[lot.Layout().ChunkIndexAt(ti)];
-}
-
 Tensor<PtVal> Unpack(const LaidOutTensor<PtChunk>& tensor) {
-  std::vector<PtVal> result =
-      Estd::transform(Estd::indices(tensor.Layout().GetShape().ValueCnt()),
-                      [&tensor](const auto& flat_index) {
-                        return FlatIndexIntoLaidOutTensor(tensor, flat_index);
-                      });
-
-  return {tensor.Layout().GetShape(), result};
+  const auto& layout = tensor.Layout();
+  std::vector<PtVal> result(layout.GetShape().ValueCnt());
+  for (const auto& chunk : tensor.Chunks()) {
+    const auto& values = chunk.Chunk().Values();
+    const auto flat_indices = layout.FlatTensorIndices(chunk.Offset());
+    for (int slot = 0; slot < flat_indices.size(); ++slot) {
+      if (flat_indices[slot].has_value()) {
+        result[flat_indices[slot].value()] = values[slot];
+      }
+    }
+  }
+  return {layout.GetShape(), result};
 }
 
 LaidOutChunk<PtChunk> IndexIntoVector(const std::vector<PtVal>& vec,
                                       const TensorLayout& layout,
                                       const TensorIndex& offset) {
-  auto indices = layout.TensorIndices(offset);
+  auto indices = layout.FlatTensorIndices(offset);
   auto curr_chunk = Estd::transform(indices, [&vec](const auto& idx) {
-    return idx.has_value() ? vec[idx.value().Flat()] : 0;
+    return idx.has_value() ? vec[idx.value()] : 0;
   });
   return {layout, offset, PtChunk(curr_chunk)};
 }
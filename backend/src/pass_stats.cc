@@ -0,0 +1,113 @@
+/** $lic$
+ * Copyright (C) 2023-2024 by Massachusetts Institute of Technology
+ *
+ * This file is part of the Fhelipe compiler.
+ *
+ * Fhelipe is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * Fhelipe is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>. 
+ */
+
+#include "include/pass_stats.h"
+
+#include <sys/resource.h>
+
+#include <iomanip>
+
+#include "include/mul_cc.h"
+#include "include/rotate_c.h"
+
+namespace fhelipe {
+
+namespace {
+
+bool RequiresKeyswitching(const CtOp& ct_op) {
+  return dynamic_cast<const MulCC*>(&ct_op) ||
+         dynamic_cast<const RotateC*>(&ct_op);
+}
+
+void WriteJsonString(std::ostream& stream, const std::string& str) {
+  stream << '"';
+  for (char c : str) {
+    if (c == '"' || c == '\\') {
+      stream << '\\';
+    }
+    stream << c;
+  }
+  stream << '"';
+}
+
+}  // namespace
+
+long PeakRssKb() {
+  struct rusage usage;
+  CHECK(getrusage(RUSAGE_SELF, &usage) == 0);
+  // ru_maxrss is in KiB on Linux
+  return usage.ru_maxrss;
+}
+
+void PassProfiler::Restart() {
+  start_time_ = std::chrono::steady_clock::now();
+  start_peak_rss_kb_ = PeakRssKb();
+}
+
+double PassProfiler::ElapsedSeconds() const {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start_time_)
+      .count();
+}
+
+long PassProfiler::PeakRssDeltaKb() const {
+  return PeakRssKb() - start_peak_rss_kb_;
+}
+
+PassStats::PassStats(int pass_idx, const PassName& pass_name,
+                     const PassProfiler& profiler,
+                     const ct_program::CtProgram& ct_program)
+    : PassStats(pass_idx, pass_name, profiler, ct_program.GetDag()) {
+  for (const auto& node : ct_program.GetDag().NodesInTopologicalOrder()) {
+    ++ct_op_cnts_[node->Value().TypeName()];
+    if (RequiresKeyswitching(node->Value())) {
+      ++key_switch_cnt_;
+    }
+  }
+}
+
+void WriteCompileStatsJson(std::ostream& stream,
+                           const std::vector<PassStats>& pass_stats) {
+  stream << "[\n";
+  for (int idx = 0; idx < pass_stats.size(); ++idx) {
+    const auto& stats = pass_stats.at(idx);
+    stream << "  {\"pass_idx\": " << stats.PassIndex() << ", \"pass_name\": ";
+    WriteJsonString(stream, stats.GetPassName().String());
+    stream << ", \"wall_time_s\": " << std::setprecision(6)
+           << stats.WallTimeSeconds()
+           << ", \"peak_rss_delta_kb\": " << stats.PeakRssDeltaKb()
+           << ", \"nodes\": " << stats.NodeCount()
+           << ", \"edges\": " << stats.EdgeCount();
+    if (!stats.CtOpCounts().empty()) {
+      stream << ", \"key_switches\": " << stats.KeySwitchCount()
+             << ", \"ct_ops\": {";
+      bool first = true;
+      for (const auto& [type_name, cnt] : stats.CtOpCounts()) {
+        stream << (first ? "" : ", ");
+        WriteJsonString(stream, type_name);
+        stream << ": " << cnt;
+        first = false;
+      }
+      stream << "}";
+    }
+    stream << "}" << (idx + 1 < pass_stats.size() ? "," : "") << "\n";
+  }
+  stream << "]\n";
+}
+
+}  // namespace fhelipe
@@ -0,0 +1,365 @@
+/** $lic$
+ * Copyright (C) 2023-2024 by Massachusetts Institute of Technology
+ *
+ * This file is part of the Fhelipe compiler.
+ *
+ * Fhelipe is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * Fhelipe is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>. 
+ */
+
+#include "include/paterson_stockmeyer_pass.h"
+
+#include <glog/logging.h>
+
+#include <map>
+#include <memory>
+#include <optional>
+#include <set>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#include "include/extended_std.h"
+#include "include/node.h"
+#include "include/plaintext.h"
+#include "include/scaled_pt_val.h"
+#include "include/t_add_cc.h"
+#include "include/t_add_csi.h"
+#include "include/t_mul_cc.h"
+#include "include/t_mul_csi.h"
+#include "include/t_op_utils.h"
+#include "include/tensor_layout.h"
+#include "include/utils.h"
+
+namespace fhelipe {
+
+namespace {
+
+using TOpNode = std::shared_ptr<Node<TOp>>;
+// Coefficients in the monomial basis, indexed by exponent
+using Polynomial = std::vector<PtVal>;
+
+constexpr int kMaxDegree = 1 << 10;
+
+Polynomial Trimmed(Polynomial poly) {
+  while (!poly.empty() && poly.back() == 0) {
+    poly.pop_back();
+  }
+  return poly;
+}
+
+bool IsSumNode(const TOp& t_op) {
+  return dynamic_cast<const TAddCC*>(&t_op) ||
+         dynamic_cast<const TAddCSI*>(&t_op);
+}
+
+// A polynomial in `base`, as built by the frontend's poly_eval: a sum of
+// scalar multiples of powers, where the powers are TMulCC products of `base`
+class PolyMatcher {
+ public:
+  bool Match(const TOpNode& root);
+
+  const TOpNode& Base() const { return base_; }
+  Polynomial Coefficients() const { return Trimmed(coefficients_); }
+  std::optional<LogScale> ScalarLogScale() const { return scalar_log_scale_; }
+  std::optional<LogScale> ConstantLogScale() const {
+    return constant_log_scale_;
+  }
+  // Multiplicative depth of the matched TOps
+  int Depth(const TOpNode& node);
+  int MulCCCount() const;
+
+ private:
+  TOpNode base_;
+  Polynomial coefficients_;
+  std::set<TOpNode> nodes_;
+  std::optional<LogScale> scalar_log_scale_;
+  std::optional<LogScale> constant_log_scale_;
+  std::unordered_map<const Node<TOp>*, int> depths_;
+
+  std::optional<int> MatchPower(const TOpNode& node);
+  bool MatchTerm(const TOpNode& node);
+};
+
+bool PolyMatcher::Match(const TOpNode& root) {
+  std::vector<TOpNode> stack{root};
+  while (!stack.empty()) {
+    auto node = stack.back();
+    stack.pop_back();
+    const auto& t_op = node->Value();
+    if (!IsSumNode(t_op) || (node != root && node->Children().size() != 1)) {
+      if (!MatchTerm(node)) {
+        return false;
+      }
+      continue;
+    }
+    nodes_.insert(node);
+    if (const auto* t_add_csi = dynamic_cast<const TAddCSI*>(&t_op)) {
+      coefficients_.resize(std::max<int>(coefficients_.size(), 1));
+      coefficients_[0] += t_add_csi->Scalar().value();
+      constant_log_scale_ = t_add_csi->Scalar().GetLogScale();
+    }
+    auto parents = node->Parents();
+    stack.insert(stack.end(), parents.begin(), parents.end());
+  }
+  return base_ != nullptr;
+}
+
+bool PolyMatcher::MatchTerm(const TOpNode& node) {
+  PtVal coefficient = 1;
+  auto power = node;
+  if (const auto* t_mul_csi = dynamic_cast<const TMulCSI*>(&node->Value())) {
+    nodes_.insert(node);
+    coefficient = t_mul_csi->Scalar().value();
+    scalar_log_scale_ = t_mul_csi->Scalar().GetLogScale();
+    power = node->Parents().at(0);
+  }
+  auto exponent = MatchPower(power);
+  if (!exponent.has_value()) {
+    return false;
+  }
+  coefficients_.resize(std::max<int>(coefficients_.size(), *exponent + 1));
+  coefficients_[*exponent] += coefficient;
+  return true;
+}
+
+std::optional<int> PolyMatcher::MatchPower(const TOpNode& node) {
+  if (!dynamic_cast<const TMulCC*>(&node->Value())) {
+    if (base_ == nullptr) {
+      base_ = node;
+    }
+    return node == base_ ? std::make_optional(1) : std::nullopt;
+  }
+  nodes_.insert(node);
+  const auto& parents = node->Parents();
+  auto lhs = MatchPower(parents.front());
+  auto rhs = MatchPower(parents.back());
+  if (!lhs.has_value() || !rhs.has_value() || *lhs + *rhs > kMaxDegree) {
+    return std::nullopt;
+  }
+  return *lhs + *rhs;
+}
+
+int PolyMatcher::Depth(const TOpNode& node) {
+  if (node == base_ || !Estd::contains(nodes_, node)) {
+    return 0;
+  }
+  auto it = depths_.find(node.get());
+  if (it != depths_.end()) {
+    return it->second;
+  }
+  int depth = 0;
+  for (const auto& parent : node->Parents()) {
+    depth = std::max(depth, Depth(parent));
+  }
+  const auto& t_op = node->Value();
+  if (dynamic_cast<const TMulCC*>(&t_op) ||
+      dynamic_cast<const TMulCSI*>(&t_op)) {
+    ++depth;
+  }
+  depths_.emplace(node.get(), depth);
+  return depth;
+}
+
+int PolyMatcher::MulCCCount() const {
+  return std::count_if(nodes_.begin(), nodes_.end(), [](const auto& node) {
+    return dynamic_cast<const TMulCC*>(&node->Value()) != nullptr;
+  });
+}
+
+// Emits the Paterson-Stockmeyer evaluation of a polynomial into `dag`, or only
+// tracks its depth and TMulCC count if `dag` is null
+class PatersonStockmeyer {
+ public:
+  struct Term {
+    TOpNode node;
+    int depth;
+  };
+
+  PatersonStockmeyer(Dag<TOp>* dag, const TOpNode& base,
+                     const std::vector<int>& ancestors,
+                     std::optional<LogScale> scalar_log_scale,
+                     std::optional<LogScale> constant_log_scale, int baby_step)
+      : dag_(dag),
+        layout_(base->Value().OutputLayout()),
+        ancestors_(ancestors),
+        scalar_log_scale_(scalar_log_scale),
+        constant_log_scale_(constant_log_scale.has_value() ? constant_log_scale
+                                                           : scalar_log_scale),
+        baby_step_(baby_step) {
+    powers_.emplace(1, Term{base, 0});
+  }
+
+  // `poly` must be trimmed and of degree at least 1
+  Term Evaluate(const Polynomial& poly);
+  int MulCCCount() const { return mul_cc_count_; }
+
+ private:
+  Dag<TOp>* dag_;
+  TensorLayout layout_;
+  std::vector<int> ancestors_;
+  std::optional<LogScale> scalar_log_scale_;
+  // Also used for the constant terms of the high halves, which come from
+  // coefficients of the polynomial and not from a TAddCSI; falls back to
+  // `scalar_log_scale_` when the polynomial has no constant term
+  std::optional<LogScale> constant_log_scale_;
+  int baby_step_;
+  std::map<int, Term> powers_;
+  int mul_cc_count_ = 0;
+
+  Term Power(int exponent);
+  Term Scaled(const Term& term, PtVal scalar);
+  Term Emit(std::unique_ptr<TOp>&& t_op, const std::vector<Term>& parents,
+            int added_depth);
+};
+
+PatersonStockmeyer::Term PatersonStockmeyer::Evaluate(const Polynomial& poly) {
+  const int degree = poly.size() - 1;
+  CHECK(degree > 0 && poly.back() != 0);
+  std::optional<Term> result;
+  if (degree < baby_step_) {
+    for (int exponent = 1; exponent <= degree; ++exponent) {
+      if (poly[exponent] == 0) {
+        continue;
+      }
+      auto term = Scaled(Power(exponent), poly[exponent]);
+      result = result.has_value()
+                   ? Emit(std::make_unique<TAddCC>(layout_), {*result, term}, 0)
+                   : term;
+    }
+  } else {
+    int split = baby_step_;
+    while (2 * split <= degree) {
+      split *= 2;
+    }
+    Polynomial high(poly.begin() + split, poly.end());
+    result = high.size() == 1
+                 ? Scaled(Power(split), high[0])
+                 : Emit(std::make_unique<TMulCC>(layout_),
+                        {Evaluate(high), Power(split)}, 1);
+    auto low = Trimmed(Polynomial(poly.begin() + 1, poly.begin() + split));
+    if (!low.empty()) {
+      low.insert(low.begin(), 0);
+      result = Emit(std::make_unique<TAddCC>(layout_),
+                    {*result, Evaluate(low)}, 0);
+    }
+  }
+  if (poly[0] != 0) {
+    CHECK(constant_log_scale_.has_value());
+    result = Emit(std::make_unique<TAddCSI>(
+                      layout_, ScaledPtVal(*constant_log_scale_, poly[0])),
+                  {*result}, 0);
+  }
+  return *result;
+}
+
+// Minimal-depth power tree: x^e = x^h * x^(e - h) for the largest power of two
+// h < e
+PatersonStockmeyer::Term PatersonStockmeyer::Power(int exponent) {
+  auto it = powers_.find(exponent);
+  if (it != powers_.end()) {
+    return it->second;
+  }
+  int half = 1 << (ceil_log2(exponent) - 1);
+  auto power = Emit(std::make_unique<TMulCC>(layout_),
+                    {Power(half), Power(exponent - half)}, 1);
+  powers_.emplace(exponent, power);
+  return power;
+}
+
+PatersonStockmeyer::Term PatersonStockmeyer::Scaled(const Term& term,
+                                                    PtVal scalar) {
+  if (scalar == 1) {
+    return term;
+  }
+  CHECK(scalar_log_scale_.has_value());
+  return Emit(std::make_unique<TMulCSI>(
+                  layout_, ScaledPtVal(*scalar_log_scale_, scalar)),
+              {term}, 1);
+}
+
+PatersonStockmeyer::Term PatersonStockmeyer::Emit(
+    std::unique_ptr<TOp>&& t_op, const std::vector<Term>& parents,
+    int added_depth) {
+  if (dynamic_cast<const TMulCC*>(t_op.get())) {
+    ++mul_cc_count_;
+  }
+  int depth = 0;
+  for (const auto& parent : parents) {
+    depth = std::max(depth, parent.depth);
+  }
+  TOpNode node;
+  if (dag_ != nullptr) {
+    node = dag_->AddNode(
+        std::move(t_op),
+        Estd::transform(parents, [](const Term& term) { return term.node; }),
+        ancestors_);
+  }
+  return {node, depth + added_depth};
+}
+
+}  // namespace
+
+LayoutOptimizerOutput PatersonStockmeyerPass::DoPass(
+    const LayoutOptimizerInput& in_dag) {
+  Dag<TOp> out_dag = CloneFromAncestor(in_dag);
+
+  auto roots = Estd::filter(
+      out_dag.NodesInTopologicalOrder(), [](const auto& node) {
+        const auto& t_op = node->Value();
+        if (!IsSumNode(t_op) && !dynamic_cast<const TMulCSI*>(&t_op)) {
+          return false;
+        }
+        return node->Children().size() != 1 ||
+               !IsSumNode((*node->Children().begin())->Value());
+      });
+  for (const auto& root : roots) {
+    PolyMatcher matcher;
+    if (root->Children().empty() || !matcher.Match(root)) {
+      continue;
+    }
+    const auto& base = matcher.Base();
+    auto poly = matcher.Coefficients();
+    if (poly.size() < 3 || !matcher.ScalarLogScale().has_value() ||
+        base->Value().OutputLayout() != root->Value().OutputLayout()) {
+      continue;
+    }
+
+    auto cost = [&](int baby_step) {
+      PatersonStockmeyer dry_run(nullptr, base, {}, matcher.ScalarLogScale(),
+                                 matcher.ConstantLogScale(), baby_step);
+      int depth = dry_run.Evaluate(poly).depth;
+      return std::make_tuple(depth, dry_run.MulCCCount(), baby_step);
+    };
+    auto best = cost(1);
+    for (int baby_step = 2; baby_step < static_cast<int>(poly.size());
+         baby_step *= 2) {
+      best = std::min(best, cost(baby_step));
+    }
+    const auto& [depth, mul_cc_count, baby_step] = best;
+    int old_depth = matcher.Depth(root);
+    int old_mul_cc_count = matcher.MulCCCount();
+    if (depth > old_depth || mul_cc_count > old_mul_cc_count ||
+        (depth == old_depth && mul_cc_count == old_mul_cc_count)) {
+      continue;
+    }
+
+    PatersonStockmeyer lowering(&out_dag, base, root->Ancestors(),
+                                matcher.ScalarLogScale(),
+                                matcher.ConstantLogScale(), baby_step);
+    InheritChildren(*root, lowering.Evaluate(poly).node);
+    RemoveDeadTOps(root);
+  }
+  return out_dag;
+}
+
+}  // namespace fhelipe
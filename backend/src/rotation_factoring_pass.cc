@@ -0,0 +1,148 @@
+/** $lic$
+ * Copyright (C) 2023-2024 by Massachusetts Institute of Technology
+ *
+ * This file is part of the Fhelipe compiler.
+ *
+ * Fhelipe is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * Fhelipe is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>. 
+ */
+
+#include "include/rotation_factoring_pass.h"
+
+#include <memory>
+#include <optional>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "include/add_cc.h"
+#include "include/chunk_ir.h"
+#include "include/ct_op.h"
+#include "include/ct_program.h"
+#include "include/extended_std.h"
+#include "include/glog_flag_avoid_writes.h"
+#include "include/mul_cp.h"
+#include "include/pass_utils.h"
+#include "include/rotate_c.h"
+
+namespace fhelipe {
+
+namespace {
+
+using CtNode = std::shared_ptr<Node<CtOp>>;
+
+// Both operands of an AddCC, if they are distinct nodes that only feed it
+std::optional<std::pair<CtNode, CtNode>> FactorableOperands(
+    const CtNode& node) {
+  if (!dynamic_cast<const AddCC*>(&node->Value()) ||
+      node->Parents().size() != 2) {
+    return std::nullopt;
+  }
+  auto lhs = node->Parents()[0];
+  auto rhs = node->Parents()[1];
+  if (lhs == rhs || lhs->Children().size() != 1 ||
+      rhs->Children().size() != 1 ||
+      lhs->Value().GetLevelInfo() != rhs->Value().GetLevelInfo()) {
+    return std::nullopt;
+  }
+  return std::make_pair(lhs, rhs);
+}
+
+void ReplaceNode(const CtNode& old_node, const CtNode& new_node,
+                 const std::vector<CtNode>& dead_nodes) {
+  InheritChildren(*old_node, new_node);
+  RemoveNodeWithoutReassaigningChildren(old_node);
+  for (const auto& dead_node : dead_nodes) {
+    RemoveNodeWithoutReassaigningChildren(dead_node);
+  }
+}
+
+// Replacement nodes take the ancestors of the AddCC they replace, so they are
+// ordered like it in NodesInAncestorIdOrder()
+bool FactorRotation(ct_program::CtProgram& ct_program, const CtNode& node) {
+  auto operands = FactorableOperands(node);
+  if (!operands) {
+    return false;
+  }
+  auto [lhs, rhs] = operands.value();
+  const auto* lhs_rotate = dynamic_cast<const RotateC*>(&lhs->Value());
+  const auto* rhs_rotate = dynamic_cast<const RotateC*>(&rhs->Value());
+  if (!lhs_rotate || !rhs_rotate ||
+      lhs_rotate->RotateBy() != rhs_rotate->RotateBy()) {
+    return false;
+  }
+  const auto& level_info = node->Value().GetLevelInfo();
+  auto sum = ct_program.AddNode(std::make_unique<AddCC>(level_info),
+                                {lhs->Parents()[0], rhs->Parents()[0]},
+                                node->Ancestors());
+  auto rotated = ct_program.AddNode(
+      std::make_unique<RotateC>(level_info, lhs_rotate->RotateBy()), {sum},
+      node->Ancestors());
+  ReplaceNode(node, rotated, {lhs, rhs});
+  return true;
+}
+
+// Flattens nested sums so that repeated factoring keeps a single SumChunkIr
+std::vector<ChunkIr> SumTerms(const ChunkIr& chunk) {
+  if (const auto* sum = std::get_if<SumChunkIr>(&chunk)) {
+    return Estd::transform(sum->Terms(),
+                           [](const auto& term) { return *term; });
+  }
+  return {chunk};
+}
+
+bool FactorMulCP(ct_program::CtProgram& ct_program, const CtNode& node) {
+  // Summing the masks reads them back, but nothing is written under
+  // --avoid_writes
+  if (AvoidWrites()) {
+    return false;
+  }
+  auto operands = FactorableOperands(node);
+  if (!operands) {
+    return false;
+  }
+  auto [lhs, rhs] = operands.value();
+  const auto* lhs_mul = dynamic_cast<const MulCP*>(&lhs->Value());
+  const auto* rhs_mul = dynamic_cast<const MulCP*>(&rhs->Value());
+  if (!lhs_mul || !rhs_mul || lhs->Parents()[0] != rhs->Parents()[0] ||
+      lhs_mul->GetPtLogScale() != rhs_mul->GetPtLogScale()) {
+    return false;
+  }
+  auto terms = SumTerms(ct_program.GetChunkIr(lhs_mul->GetHandle()));
+  auto rhs_terms = SumTerms(ct_program.GetChunkIr(rhs_mul->GetHandle()));
+  terms.insert(terms.end(), rhs_terms.begin(), rhs_terms.end());
+  auto handle = ct_program.RecordChunk(SumChunkIr(terms));
+  auto product = ct_program.AddNode(
+      std::make_unique<MulCP>(node->Value().GetLevelInfo(), handle,
+                              lhs_mul->GetPtLogScale()),
+      {lhs->Parents()[0]}, node->Ancestors());
+  ReplaceNode(node, product, {lhs, rhs});
+  return true;
+}
+
+}  // namespace
+
+CtOpOptimizerOutput RotationFactoringPass::DoPass(
+    const CtOpOptimizerInput& in_dag) {
+  auto out_program = in_dag.WithDag(CloneFromAncestor(in_dag.GetDag()));
+
+  // Replacement nodes are not visited, but the AddCC consuming them is, so a
+  // tree of AddCCs factors bottom-up
+  for (const auto& node : out_program.NodesInTopologicalOrder()) {
+    if (!FactorRotation(out_program, node)) {
+      FactorMulCP(out_program, node);
+    }
+  }
+  return out_program;
+}
+
+}  // namespace fhelipe
@@ -0,0 +1,65 @@
+/** $lic$
+ * Copyright (C) 2023-2024 by Massachusetts Institute of Technology
+ *
+ * This file is part of the Fhelipe compiler.
+ *
+ * Fhelipe is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * Fhelipe is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>. 
+ */
+
+#include "include/rotation_sinking_pass.h"
+
+#include <memory>
+
+#include "include/ct_op.h"
+#include "include/ct_program.h"
+#include "include/extended_std.h"
+#include "include/pass_utils.h"
+#include "include/rescale_c.h"
+#include "include/rotate_c.h"
+
+namespace fhelipe {
+
+namespace {
+
+// A rotation feeding only a rescale; sinking a rotation with other children
+// would duplicate it
+std::shared_ptr<Node<CtOp>> RescaleBelowRotation(const Node<CtOp>& node) {
+  if (!dynamic_cast<const RotateC*>(&node.Value()) ||
+      node.Children().size() != 1) {
+    return nullptr;
+  }
+  auto child = *node.Children().begin();
+  if (!dynamic_cast<const RescaleC*>(&child->Value())) {
+    return nullptr;
+  }
+  return child;
+}
+
+}  // namespace
+
+CtOpOptimizerOutput RotationSinkingPass::DoPass(
+    const CtOpOptimizerInput& in_dag) {
+  auto out_dag = CloneFromAncestor(in_dag.GetDag());
+
+  for (const auto& node : out_dag.NodesInTopologicalOrder()) {
+    while (auto rescale = RescaleBelowRotation(*node)) {
+      // The rescale's level info only depends on the rotation's, which is the
+      // same as that of the rotation's parent
+      node->Value().SetLevelInfo(rescale->Value().GetLevelInfo());
+      SwapParentAndChild(node, rescale);
+    }
+  }
+  return in_dag.WithDag(std::move(out_dag));
+}
+
+}  // namespace fhelipe
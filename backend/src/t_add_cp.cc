@@ -50,6 +50,10 @@ void TAddCP::SetLayouts(const TensorLayout& input_layout,
   layout_ = input_layout;
 }
 
+std::size_t TAddCP::Hash() const {
+  return HashCombine(TOp::Hash(), std::hash<std::string>()(PtTensorName()));
+}
+
 bool TAddCP::EqualTo(const TOp& other) const {
   const auto* t_add_cp = dynamic_cast<const TAddCP*>(&other);
   return t_add_cp && other.OutputLayout() == OutputLayout() &&
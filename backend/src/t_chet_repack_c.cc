@@ -67,6 +67,11 @@ void TChetRepackC::SetLayouts(const TensorLayout& input_layout,
   output_layout_ = output_layout;
 }
 
+std::size_t TChetRepackC::Hash() const {
+  return HashCombine(std::hash<std::string>()(TypeName()),
+                     std::hash<TensorLayout>()(InputLayout()));
+}
+
 bool TChetRepackC::EqualTo(const TOp& other) const {
   const auto* t_chet_repack_c = dynamic_cast<const TChetRepackC*>(&other);
   return t_chet_repack_c && t_chet_repack_c->InputLayout() == InputLayout();
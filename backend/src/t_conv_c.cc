@@ -0,0 +1,162 @@
+/** $lic$
+ * Copyright (C) 2023-2024 by Massachusetts Institute of Technology
+ *
+ * This file is part of the Fhelipe compiler.
+ *
+ * Fhelipe is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * Fhelipe is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>. 
+ */
+
+#include "include/t_conv_c.h"
+
+#include <glog/logging.h>
+
+#include <map>
+#include <optional>
+#include <set>
+#include <string>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "include/chunk_ir.h"
+#include "include/ct_program.h"
+#include "include/extended_std.h"
+#include "include/laid_out_tensor.h"
+#include "include/tensor_layout.h"
+#include "include/translation_mask_utils.h"
+
+namespace fhelipe {
+
+class CtOp;
+
+TConvC::TConvC(const TensorLayout& layout,
+               const std::vector<DiffTensorIndex>& shifts,
+               const std::vector<std::string>& pt_tensor_names,
+               LogScale pt_log_scale)
+    : layout_(layout),
+      shifts_(shifts),
+      pt_tensor_names_(pt_tensor_names),
+      pt_log_scale_(pt_log_scale) {
+  CHECK(!shifts_.empty());
+  CHECK(shifts_.size() == pt_tensor_names_.size());
+  for (const auto& shift : shifts_) {
+    CHECK(shift.GetShape() == layout_.GetShape());
+  }
+}
+
+TOp::LaidOutTensorCt TConvC::AmendCtProgram(
+    ct_program::CtProgram& ct_program,
+    const std::vector<TOp::LaidOutTensorCt>& input_tensors) const {
+  CHECK(input_tensors.size() == 1);
+  const auto& input_tensor = input_tensors[0];
+  CHECK(input_tensor.Layout() == layout_);
+  const int chunk_count = layout_.TotalChunks();
+
+  std::map<std::pair<int, int>, TOp::Chunk> rotated;
+  std::vector<std::optional<TOp::Chunk>> sums(chunk_count);
+  for (int tap : Estd::indices(shifts_.size())) {
+    for (const auto& [translation, mask_tensor] : TapMasks(tap)) {
+      const int rotate_by = translation.ChunkIndexDiff();
+      for (int src_chunk : Estd::indices(chunk_count)) {
+        const auto& mask_chunk = mask_tensor.Chunks()[src_chunk].Chunk();
+        const auto* mask = std::get_if<DirectChunkIr>(&mask_chunk);
+        if (mask == nullptr) {
+          continue;
+        }
+        auto key = std::make_pair(src_chunk, rotate_by);
+        auto it = rotated.find(key);
+        if (it == rotated.end()) {
+          auto rotate_c = ct_program::CreateRotateC(
+              ct_program, input_tensor.Chunks()[src_chunk].Chunk(), rotate_by);
+          it = rotated.emplace(key, rotate_c).first;
+        }
+        int dest_chunk = (src_chunk + translation.ChunkNumberDiff()) %
+                         translation.TotalChunks();
+        auto product = ct_program::CreateMulCP(
+            ct_program, it->second,
+            MaskedWeights(tap, *mask, dest_chunk, rotate_by), pt_log_scale_);
+        sums[dest_chunk] =
+            sums[dest_chunk].has_value()
+                ? ct_program::CreateAddCC(ct_program, sums[dest_chunk].value(),
+                                          product)
+                : product;
+      }
+    }
+  }
+
+  auto zero_c = ct_program::FetchZeroCThatIsAtSameLevelInfoAsAMulCPChildOf(
+      input_tensor.Chunks().at(0).Chunk(), pt_log_scale_);
+  std::vector<TOp::LaidOutChunk> result;
+  for (int idx : Estd::indices(chunk_count)) {
+    result.emplace_back(layout_, layout_.ChunkOffsets()[idx],
+                        sums[idx].value_or(zero_c));
+  }
+  return TOp::LaidOutTensorCt{result};
+}
+
+int TConvC::RotationCount() const {
+  std::set<std::pair<int, int>> rotations;
+  for (int tap : Estd::indices(shifts_.size())) {
+    for (const auto& [translation, mask_tensor] : TapMasks(tap)) {
+      if (translation.ChunkIndexDiff() == 0) {
+        continue;
+      }
+      for (int src_chunk : Estd::indices(mask_tensor.Chunks().size())) {
+        if (std::holds_alternative<DirectChunkIr>(
+                mask_tensor.Chunks()[src_chunk].Chunk())) {
+          rotations.emplace(src_chunk, translation.ChunkIndexDiff());
+        }
+      }
+    }
+  }
+  return rotations.size();
+}
+
+std::vector<TranslationMask> TConvC::TapMasks(int tap) const {
+  return MakeTranslationMasks(layout_, layout_,
+                              [this, tap](const TensorIndex& ti) {
+                                return shifts_[tap].NonCyclicAdd(ti);
+                              });
+}
+
+// Weights of `tap` laid out in the destination chunk, but only in the slots
+// that the rotated source chunk fills through `mask`
+IndirectChunkIr TConvC::MaskedWeights(int tap, const DirectChunkIr& mask,
+                                      int dest_chunk, int rotate_by) const {
+  auto flat_indices =
+      layout_.FlatTensorIndices(layout_.ChunkOffsets()[dest_chunk]);
+  const int chunk_size = layout_.ChunkSize().value();
+  for (int slot : Estd::indices(chunk_size)) {
+    int src_slot = (slot - rotate_by + chunk_size) % chunk_size;
+    if (!mask.IsOne(src_slot)) {
+      flat_indices[slot] = std::nullopt;
+    }
+  }
+  return IndirectChunkIr(pt_tensor_names_[tap], flat_indices);
+}
+
+void TConvC::SetLayouts(const TensorLayout& input_layout,
+                        const TensorLayout& output_layout) {
+  CHECK(input_layout == output_layout);
+  layout_ = input_layout;
+}
+
+bool TConvC::EqualTo(const TOp& other) const {
+  const auto* t_conv_c = dynamic_cast<const TConvC*>(&other);
+  return t_conv_c && t_conv_c->OutputLayout() == OutputLayout() &&
+         Shifts() == t_conv_c->Shifts() &&
+         PtTensorNames() == t_conv_c->PtTensorNames() &&
+         PtLogScale() == t_conv_c->PtLogScale();
+}
+
+}  // namespace fhelipe
@@ -39,27 +39,36 @@ TOp::LaidOutTensorCt TCyclicShiftC::AmendCtProgram(
     const std::vector<TOp::LaidOutTensorCt>& input_tensors) const {
   CHECK(input_tensors.size() == 1);
   CHECK(input_tensors[0].Layout() == layout_);
-  const auto& input_layout = input_tensors[0].Layout();
-  const std::vector<TranslationMask>& trans_masks = MakeTranslationMasks(
-      input_layout, input_layout, [this](const TensorIndex& src_ti) {
-        return (this->rotate_by_).CyclicAdd(src_ti);
-      });
-  const auto& result = ApplyTranslationMasks(ct_program, input_tensors[0],
-                                             trans_masks, input_layout);
+  const auto& result =
+      ApplyTranslations(ct_program, input_tensors[0], TranslationMasks(),
+                        layout_, InputPaddingIsZero());
   return TOp::LaidOutTensorCt{result};
 }
 
+int TCyclicShiftC::BackendMaskDepth() const {
+  return mask_depth_.Get([this] { return TranslationMasks(); });
+}
+
+std::vector<TranslationMask> TCyclicShiftC::TranslationMasks() const {
+  return MakeTranslationMasks(layout_, layout_,
+                              [this](const TensorIndex& src_ti) {
+                                return rotate_by_.CyclicAdd(src_ti);
+                              });
+}
+
 void TCyclicShiftC::SetLayouts(const TensorLayout& input_layout,
                                const TensorLayout& output_layout) {
   CHECK(input_layout == output_layout);
   layout_ = input_layout;
+  mask_depth_.Reset();
 }
 
 bool TCyclicShiftC::EqualTo(const TOp& other) const {
   const auto* t_cyclic_shift_c = dynamic_cast<const TCyclicShiftC*>(&other);
   return t_cyclic_shift_c &&
          t_cyclic_shift_c->OutputLayout() == OutputLayout() &&
-         GetDiffTensorIndex() == t_cyclic_shift_c->GetDiffTensorIndex();
+         GetDiffTensorIndex() == t_cyclic_shift_c->GetDiffTensorIndex() &&
+         InputPaddingIsZero() == t_cyclic_shift_c->InputPaddingIsZero();
 }
 
 }  // namespace fhelipe
@@ -60,6 +60,11 @@ void TInputC::SetLayouts(const TensorLayout& input_layout,
   layout_ = input_layout;
 }
 
+std::size_t TInputC::Hash() const {
+  return HashCombine(std::hash<std::string>()(TypeName()),
+                     std::hash<std::string>()(Name()));
+}
+
 bool TInputC::EqualTo(const TOp& other) const {
   const auto* t_input_c = dynamic_cast<const TInputC*>(&other);
   return t_input_c && Name() == t_input_c->Name() &&
@@ -39,19 +39,26 @@ TOp::LaidOutTensorCt TLayoutConversionC::AmendCtProgram(
     const std::vector<LaidOutTensorCt>& input_tensors) const {
   const auto& input_tensor = input_tensors[0];
   CHECK(input_tensor.Layout() == input_layout_);
-  const auto& input_layout = input_tensor.Layout();
-  const auto& trans_masks =
-      MakeTranslationMasks(input_layout, output_layout_,
-                           [](const TensorIndex& src_ti) { return src_ti; });
-  const auto& result = ApplyTranslationMasks(ct_program, input_tensor,
-                                             trans_masks, output_layout_);
+  const auto& result =
+      ApplyTranslations(ct_program, input_tensor, TranslationMasks(),
+                        output_layout_, InputPaddingIsZero());
   return TOp::LaidOutTensorCt{AdaptToLayout(output_layout_, result)};
 }
 
+int TLayoutConversionC::BackendMaskDepth() const {
+  return mask_depth_.Get([this] { return TranslationMasks(); });
+}
+
+std::vector<TranslationMask> TLayoutConversionC::TranslationMasks() const {
+  return MakeTranslationMasks(input_layout_, output_layout_,
+                              IdentityIndexBitMap(input_layout_.GetShape()));
+}
+
 void TLayoutConversionC::SetLayouts(const TensorLayout& input_layout,
                                     const TensorLayout& output_layout) {
   input_layout_ = input_layout;
   output_layout_ = output_layout;
+  mask_depth_.Reset();
 }
 
 bool TLayoutConversionC::EqualTo(const TOp& other) const {
@@ -59,7 +66,8 @@ bool TLayoutConversionC::EqualTo(const TOp& other) const {
       dynamic_cast<const TLayoutConversionC*>(&other);
   return t_layout_conversion_c &&
          OutputLayout() == t_layout_conversion_c->OutputLayout() &&
-         InputLayout() == t_layout_conversion_c->InputLayout();
+         InputLayout() == t_layout_conversion_c->InputLayout() &&
+         InputPaddingIsZero() == t_layout_conversion_c->InputPaddingIsZero();
 }
 
 }  // namespace fhelipe
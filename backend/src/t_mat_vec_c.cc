@@ -0,0 +1,230 @@
+/** $lic$
+ * Copyright (C) 2023-2024 by Massachusetts Institute of Technology
+ *
+ * This file is part of the Fhelipe compiler.
+ *
+ * Fhelipe is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * Fhelipe is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>. 
+ */
+
+#include "include/t_mat_vec_c.h"
+
+#include <glog/logging.h>
+
+#include <functional>
+#include <map>
+#include <optional>
+#include <set>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "include/chunk_ir.h"
+#include "include/ct_program.h"
+#include "include/extended_std.h"
+#include "include/laid_out_tensor.h"
+#include "include/shape.h"
+#include "include/tensor_layout.h"
+
+namespace fhelipe {
+
+class CtOp;
+
+namespace {
+
+// (slot, flat tensor index) of the valid slots of each chunk of `layout`
+std::vector<std::vector<std::pair<int, int>>> ValidSlots(
+    const TensorLayout& layout) {
+  std::vector<std::vector<std::pair<int, int>>> result;
+  for (const auto& offset : layout.ChunkOffsets()) {
+    auto& slots = result.emplace_back();
+    auto flat_indices = layout.FlatTensorIndices(offset);
+    for (int slot : Estd::indices(flat_indices.size())) {
+      if (flat_indices[slot].has_value()) {
+        slots.emplace_back(slot, flat_indices[slot].value());
+      }
+    }
+  }
+  return result;
+}
+
+void SanityCheckTMatVecC(const TensorLayout& input_layout,
+                         const TensorLayout& output_layout) {
+  CHECK(input_layout.ChunkSize() == output_layout.ChunkSize());
+  const auto& output_shape = output_layout.GetShape();
+  CHECK(output_shape.ValueCnt() == output_shape[0]);
+}
+
+int RotationCountForBabyStep(
+    const std::map<std::pair<int, int>, std::set<int>>& diagonals,
+    int baby_step) {
+  std::set<std::pair<int, int>> baby_rotations;
+  std::set<std::pair<int, int>> giant_rotations;
+  for (const auto& [chunks, rotations] : diagonals) {
+    const auto& [src_chunk, dest_chunk] = chunks;
+    for (int rotate_by : rotations) {
+      if (rotate_by % baby_step != 0) {
+        baby_rotations.emplace(src_chunk, rotate_by % baby_step);
+      }
+      if (rotate_by / baby_step != 0) {
+        giant_rotations.emplace(dest_chunk, rotate_by / baby_step);
+      }
+    }
+  }
+  return baby_rotations.size() + giant_rotations.size();
+}
+
+}  // namespace
+
+TMatVecC::TMatVecC(const TensorLayout& input_layout,
+                   const TensorLayout& output_layout,
+                   const std::string& pt_tensor_name, LogScale pt_log_scale)
+    : input_layout_(input_layout),
+      output_layout_(output_layout),
+      pt_tensor_name_(pt_tensor_name),
+      pt_log_scale_(pt_log_scale) {
+  SanityCheckTMatVecC(input_layout_, output_layout_);
+}
+
+Shape TMatVecC::PtTensorShape() const {
+  return ShapeWithChannels(output_layout_.GetShape()[0],
+                           input_layout_.GetShape());
+}
+
+TOp::LaidOutTensorCt TMatVecC::AmendCtProgram(
+    ct_program::CtProgram& ct_program,
+    const std::vector<TOp::LaidOutTensorCt>& input_tensors) const {
+  CHECK(input_tensors.size() == 1);
+  const auto& input_tensor = input_tensors[0];
+  CHECK(input_tensor.Layout() == input_layout_);
+  const int chunk_size = input_layout_.ChunkSize().value();
+  const int row_size = input_layout_.GetShape().ValueCnt();
+  const int baby_step = BabyStep(NonZeroDiagonals());
+
+  // (output chunk, giant step, input chunk, baby step) -> diagonal, already
+  // rotated back by the giant step
+  std::map<std::tuple<int, int, int, int>, std::vector<std::optional<int>>>
+      diagonals;
+  auto input_slots = ValidSlots(input_layout_);
+  auto output_slots = ValidSlots(output_layout_);
+  for (int dest_chunk : Estd::indices(output_slots.size())) {
+    for (const auto& [dest_slot, row] : output_slots[dest_chunk]) {
+      for (int src_chunk : Estd::indices(input_slots.size())) {
+        for (const auto& [src_slot, col] : input_slots[src_chunk]) {
+          int rotate_by = (dest_slot - src_slot + chunk_size) % chunk_size;
+          int giant = rotate_by / baby_step;
+          int baby = rotate_by % baby_step;
+          auto& diagonal = diagonals[{dest_chunk, giant, src_chunk, baby}];
+          diagonal.resize(chunk_size);
+          diagonal[(dest_slot - giant * baby_step + chunk_size) % chunk_size] =
+              row * row_size + col;
+        }
+      }
+    }
+  }
+
+  std::map<std::pair<int, int>, TOp::Chunk> baby_rotated;
+  std::vector<std::map<int, TOp::Chunk>> giant_sums(output_slots.size());
+  for (const auto& [key, diagonal] : diagonals) {
+    const auto& [dest_chunk, giant, src_chunk, baby] = key;
+    auto it = baby_rotated.find({src_chunk, baby});
+    if (it == baby_rotated.end()) {
+      auto rotate_c = ct_program::CreateRotateC(
+          ct_program, input_tensor.Chunks()[src_chunk].Chunk(), baby);
+      it = baby_rotated.emplace(std::make_pair(src_chunk, baby), rotate_c)
+               .first;
+    }
+    auto product = ct_program::CreateMulCP(
+        ct_program, it->second, IndirectChunkIr(pt_tensor_name_, diagonal),
+        pt_log_scale_);
+    auto [sum, inserted] = giant_sums[dest_chunk].emplace(giant, product);
+    if (!inserted) {
+      sum->second = ct_program::CreateAddCC(ct_program, sum->second, product);
+    }
+  }
+
+  auto zero_c = ct_program::FetchZeroCThatIsAtSameLevelInfoAsAMulCPChildOf(
+      input_tensor.Chunks().at(0).Chunk(), pt_log_scale_);
+  std::vector<TOp::LaidOutChunk> result;
+  for (int idx : Estd::indices(output_slots.size())) {
+    std::optional<TOp::Chunk> total;
+    for (const auto& [giant, sum] : giant_sums[idx]) {
+      auto rotated =
+          ct_program::CreateRotateC(ct_program, sum, giant * baby_step);
+      total = total.has_value()
+                  ? ct_program::CreateAddCC(ct_program, total.value(), rotated)
+                  : rotated;
+    }
+    result.emplace_back(output_layout_, output_layout_.ChunkOffsets()[idx],
+                        total.value_or(zero_c));
+  }
+  return TOp::LaidOutTensorCt{result};
+}
+
+TMatVecC::Diagonals TMatVecC::NonZeroDiagonals() const {
+  const int chunk_size = input_layout_.ChunkSize().value();
+  auto input_slots = ValidSlots(input_layout_);
+  auto output_slots = ValidSlots(output_layout_);
+  Diagonals diagonals;
+  for (int src_chunk : Estd::indices(input_slots.size())) {
+    for (int dest_chunk : Estd::indices(output_slots.size())) {
+      auto& rotations = diagonals[{src_chunk, dest_chunk}];
+      for (const auto& src : input_slots[src_chunk]) {
+        for (const auto& dest : output_slots[dest_chunk]) {
+          rotations.insert((dest.first - src.first + chunk_size) % chunk_size);
+        }
+      }
+    }
+  }
+  return diagonals;
+}
+
+int TMatVecC::BabyStep(const Diagonals& diagonals) const {
+  const int chunk_size = input_layout_.ChunkSize().value();
+  int best = 1;
+  int best_count = RotationCountForBabyStep(diagonals, best);
+  for (int baby_step = 2; baby_step <= chunk_size; baby_step *= 2) {
+    int count = RotationCountForBabyStep(diagonals, baby_step);
+    if (count < best_count) {
+      best = baby_step;
+      best_count = count;
+    }
+  }
+  return best;
+}
+
+int TMatVecC::RotationCount() const {
+  auto diagonals = NonZeroDiagonals();
+  return RotationCountForBabyStep(diagonals, BabyStep(diagonals));
+}
+
+std::size_t TMatVecC::Hash() const {
+  return HashCombine(TOp::Hash(), std::hash<std::string>()(pt_tensor_name_));
+}
+
+void TMatVecC::SetLayouts(const TensorLayout& input_layout,
+                          const TensorLayout& output_layout) {
+  SanityCheckTMatVecC(input_layout, output_layout);
+  input_layout_ = input_layout;
+  output_layout_ = output_layout;
+}
+
+bool TMatVecC::EqualTo(const TOp& other) const {
+  const auto* t_mat_vec_c = dynamic_cast<const TMatVecC*>(&other);
+  return t_mat_vec_c && t_mat_vec_c->OutputLayout() == OutputLayout() &&
+         t_mat_vec_c->InputLayout() == InputLayout() &&
+         PtTensorName() == t_mat_vec_c->PtTensorName() &&
+         PtLogScale() == t_mat_vec_c->PtLogScale();
+}
+
+}  // namespace fhelipe
@@ -20,59 +20,63 @@
 
 #include <glog/logging.h>
 
-#include <algorithm>
-#include <iterator>
+#include <string>
+#include <utility>
 #include <vector>
 
+#include "include/chunk_ir.h"
 #include "include/ct_program.h"
+#include "include/extended_std.h"
 #include "include/laid_out_tensor.h"
-#include "include/t_op_utils.h"
 #include "include/tensor_layout.h"
 
 namespace fhelipe {
 
 class CtOp;
 
-namespace {
-
-void CheckLayouts(const TensorLayout& input_layout,
-                  const TensorLayout& output_layout) {
-  CHECK(input_layout.TotalChunks() == output_layout.TotalChunks());
+TMergedMulChainCP::TMergedMulChainCP(
+    const TensorLayout& layout, const std::vector<std::string>& pt_tensor_names,
+    PtVal scalar, LogScale pt_log_scale)
+    : layout_(layout),
+      pt_tensor_names_(pt_tensor_names),
+      scalar_(scalar),
+      pt_log_scale_(pt_log_scale) {
+  CHECK(!pt_tensor_names_.empty());
 }
 
-}  // namespace
-
 TOp::LaidOutTensorCt TMergedMulChainCP::AmendCtProgram(
     ct_program::CtProgram& ct_program,
     const std::vector<TOp::LaidOutTensorCt>& input_tensors) const {
   CHECK(input_tensors.size() == 1);
-  CHECK(input_tensors[0].Layout() == input_layout_);
+  CHECK(input_tensors[0].Layout() == layout_);
   return TOp::LaidOutTensorCt{Estd::transform(
-      input_tensors[0].Chunks(), Estd::indices(output_layout_.TotalChunks()),
-      [this](const auto& chunk, auto idx) {
-        return LaidOutChunk{output_layout_, output_layout_.ChunkOffsets()[idx],
-                            chunk.Chunk()};
+      input_tensors[0].Chunks(), [&](const TOp::LaidOutChunk& chunk) {
+        const auto& flat_indices = layout_.FlatTensorIndices(chunk.Offset());
+        auto factors = Estd::transform(
+            pt_tensor_names_, [&flat_indices](const std::string& name) {
+              return IndirectChunkIr(name, flat_indices);
+            });
+        auto ct_op = ct_program::CreateMulCP(
+            ct_program, chunk.Chunk(),
+            ProductChunkIr(std::move(factors), scalar_), pt_log_scale_);
+        return TOp::LaidOutChunk{chunk.Layout(), chunk.Offset(), ct_op};
       })};
 }
 
 void TMergedMulChainCP::SetLayouts(const TensorLayout& input_layout,
                                    const TensorLayout& output_layout) {
-  input_layout_ = input_layout;
-  output_layout_ = output_layout;
-  CheckLayouts(input_layout_, output_layout_);
+  CHECK(input_layout == output_layout);
+  layout_ = input_layout;
 }
 
 bool TMergedMulChainCP::EqualTo(const TOp& other) const {
   const auto* t_merged_mul_chain_cp =
       dynamic_cast<const TMergedMulChainCP*>(&other);
   return t_merged_mul_chain_cp &&
-         t_merged_mul_chain_cp->OutputLayout() == OutputLayout();
-}
-
-TMergedMulChainCP::TMergedMulChainCP(const TensorLayout& input_layout,
-                                     const TensorLayout& output_layout)
-    : input_layout_(input_layout), output_layout_(output_layout) {
-  CheckLayouts(input_layout_, output_layout_);
+         t_merged_mul_chain_cp->OutputLayout() == OutputLayout() &&
+         PtTensorNames() == t_merged_mul_chain_cp->PtTensorNames() &&
+         Scalar() == t_merged_mul_chain_cp->Scalar() &&
+         PtLogScale() == t_merged_mul_chain_cp->PtLogScale();
 }
 
 }  // namespace fhelipe
@@ -48,6 +48,10 @@ void TMulCP::SetLayouts(const TensorLayout& input_layout,
   layout_ = input_layout;
 }
 
+std::size_t TMulCP::Hash() const {
+  return HashCombine(TOp::Hash(), std::hash<std::string>()(PtTensorName()));
+}
+
 bool TMulCP::EqualTo(const TOp& other) const {
   const auto* t_mul_cp = dynamic_cast<const TMulCP*>(&other);
   return t_mul_cp && t_mul_cp->OutputLayout() == OutputLayout() &&
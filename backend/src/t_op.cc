@@ -20,6 +20,11 @@
 
 namespace fhelipe {
 
+std::size_t TOp::Hash() const {
+  return HashCombine(std::hash<std::string>()(TypeName()),
+                     std::hash<TensorLayout>()(OutputLayout()));
+}
+
 std::unique_ptr<TOp> TOp::CreateInstance(std::istream& stream) {
   std::string token = ReadStream<std::string>(stream);
   DerivedRecordType::iterator it = GetMap().find(token);
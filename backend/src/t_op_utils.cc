@@ -19,6 +19,7 @@
 #include "include/t_op_utils.h"
 
 #include <functional>
+#include <memory>
 #include <vector>
 
 #include "include/chunk_ir.h"
@@ -26,7 +27,10 @@
 #include "include/ct_program.h"
 #include "include/dictionary.h"
 #include "include/extended_std.h"
+#include "include/node.h"
+#include "include/t_input_c.h"
 #include "include/t_op.h"
+#include "include/t_output_c.h"
 
 namespace fhelipe {
 
@@ -43,8 +47,7 @@ TOp::LaidOutTensorCt CreateCtPtTensorOp(
       ct_ops, offsets,
       [&frontend_tensor_name, &layout, &ct_program, &CreateCtOp,
        &pt_tensor_log_scale](const auto& chunk, const TensorIndex& offset) {
-        auto flat_indices =
-            FlatMaybeTensorIndices(layout.TensorIndices(offset));
+        auto flat_indices = layout.FlatTensorIndices(offset);
         auto ct_op =
             CreateCtOp(ct_program, chunk.Chunk(),
                        IndirectChunkIr(frontend_tensor_name, flat_indices),
@@ -55,4 +58,20 @@ TOp::LaidOutTensorCt CreateCtPtTensorOp(
   return TOp::LaidOutTensorCt{result};
 }
 
+void RemoveDeadTOps(const std::shared_ptr<Node<TOp>>& node) {
+  std::vector<std::shared_ptr<Node<TOp>>> stack{node};
+  while (!stack.empty()) {
+    auto curr = stack.back();
+    stack.pop_back();
+    if (curr->IsSentinel() || !curr->Children().empty() ||
+        dynamic_cast<const TInputC*>(&curr->Value()) ||
+        dynamic_cast<const TOutputC*>(&curr->Value())) {
+      continue;
+    }
+    auto parents = Estd::set_to_vector(Estd::vector_to_set(curr->Parents()));
+    RemoveNodeWithoutReassaigningChildren(curr);
+    stack.insert(stack.end(), parents.begin(), parents.end());
+  }
+}
+
 }  // namespace fhelipe
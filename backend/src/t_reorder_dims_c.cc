@@ -50,16 +50,22 @@ TOp::LaidOutTensorCt TReorderDimsC::AmendCtProgram(
   CHECK(input_tensors.size() == 1);
   const auto& input_tensor = input_tensors[0];
   CHECK(input_tensor.Layout() == input_layout_);
-  auto output_layout = OutputLayout();
-  const std::vector<TranslationMask>& translation_masks = MakeTranslationMasks(
-      input_layout_, output_layout,
-      [&output_layout, this](const TensorIndex& ti) {
-        return TensorIndex(output_layout.GetShape(),
+  const auto& result =
+      ApplyTranslations(ct_program, input_tensors[0], TranslationMasks(),
+                        output_layout_, InputPaddingIsZero());
+  return TOp::LaidOutTensorCt{result};
+}
+
+int TReorderDimsC::BackendMaskDepth() const {
+  return mask_depth_.Get([this] { return TranslationMasks(); });
+}
+
+std::vector<TranslationMask> TReorderDimsC::TranslationMasks() const {
+  return MakeTranslationMasks(
+      input_layout_, output_layout_, [this](const TensorIndex& ti) {
+        return TensorIndex(output_layout_.GetShape(),
                            Estd::permute(ti.DimensionIndices(), dim_order_));
       });
-  const auto& result = ApplyTranslationMasks(ct_program, input_tensors[0],
-                                             translation_masks, output_layout);
-  return TOp::LaidOutTensorCt{result};
 }
 
 void SanityCheckTReorderDimsCLayouts(const TensorLayout& input_layout,
@@ -85,6 +91,7 @@ void TReorderDimsC::SetLayouts(const TensorLayout& input_layout,
   SanityCheckTReorderDimsCLayouts(input_layout, output_layout, dim_order_);
   input_layout_ = input_layout;
   output_layout_ = output_layout;
+  mask_depth_.Reset();
 }
 
 bool TReorderDimsC::EqualTo(const TOp& other) const {
@@ -92,7 +99,8 @@ bool TReorderDimsC::EqualTo(const TOp& other) const {
   return t_reorder_dims_c &&
          t_reorder_dims_c->OutputLayout() == OutputLayout() &&
          t_reorder_dims_c->InputLayout() == InputLayout() &&
-         t_reorder_dims_c->DimensionOrder() == DimensionOrder();
+         t_reorder_dims_c->DimensionOrder() == DimensionOrder() &&
+         t_reorder_dims_c->InputPaddingIsZero() == InputPaddingIsZero();
 }
 
 }  // namespace fhelipe
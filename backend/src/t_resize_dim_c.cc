@@ -59,6 +59,7 @@ void TResizeDimC::SetLayouts(const TensorLayout& input_layout,
   SanityCheckTResizeDimC(input_layout, output_layout);
   input_layout_ = input_layout;
   output_layout_ = output_layout;
+  mask_depth_.Reset();
 }
 
 TOp::LaidOutTensorCt TResizeDimC::AmendCtProgram(
@@ -71,26 +72,34 @@ TOp::LaidOutTensorCt TResizeDimC::AmendCtProgram(
     return input_tensors[0];
   }
 
-  const std::vector<TranslationMask>& translation_masks = MakeTranslationMasks(
+  const auto& result =
+      ApplyTranslations(ct_program, input_tensors[0], TranslationMasks(),
+                        output_layout_, InputPaddingIsZero());
+  return TOp::LaidOutTensorCt{result};
+}
+
+std::vector<TranslationMask> TResizeDimC::TranslationMasks() const {
+  return MakeTranslationMasks(
       input_layout_, output_layout_, [this](const TensorIndex& ti) {
         return IsInRange(output_layout_.GetShape(), ti.DimensionIndices())
                    ? std::make_optional<TensorIndex>(TensorIndex(
                          output_layout_.GetShape(), ti.DimensionIndices()))
                    : std::nullopt;
       });
-  const auto& result = ApplyTranslationMasks(ct_program, input_tensors[0],
-                                             translation_masks, output_layout_);
-  return TOp::LaidOutTensorCt{result};
 }
 
 bool TResizeDimC::EqualTo(const TOp& other) const {
   const auto* t_resize_dim_c = dynamic_cast<const TResizeDimC*>(&other);
   return t_resize_dim_c && t_resize_dim_c->OutputLayout() == OutputLayout() &&
-         t_resize_dim_c->InputLayout() == InputLayout();
+         t_resize_dim_c->InputLayout() == InputLayout() &&
+         t_resize_dim_c->InputPaddingIsZero() == InputPaddingIsZero();
 }
 
 int TResizeDimC::BackendMaskDepth() const {
-  return input_layout_ != output_layout_;
+  if (input_layout_ == output_layout_) {
+    return 0;
+  }
+  return mask_depth_.Get([this] { return TranslationMasks(); });
 }
 
 }  // namespace fhelipe
@@ -69,6 +69,10 @@ void TRotateC::SetLayouts(const TensorLayout& input_layout,
   layout_ = input_layout;
 }
 
+std::size_t TRotateC::Hash() const {
+  return HashCombine(TOp::Hash(), std::hash<int>()(RotateBy()));
+}
+
 bool TRotateC::EqualTo(const TOp& other) const {
   const auto* t_rotate_c = dynamic_cast<const TRotateC*>(&other);
   return t_rotate_c && t_rotate_c->OutputLayout() == OutputLayout() &&
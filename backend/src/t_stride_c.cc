@@ -101,6 +101,7 @@ void TStrideC::SetLayouts(const TensorLayout& input_layout,
   SanityCheckTStrideC(input_layout, output_layout, strides_);
   input_layout_ = input_layout;
   output_layout_ = output_layout;
+  mask_depth_.Reset();
 }
 
 TOp::LaidOutTensorCt TStrideC::AmendCtProgram(
@@ -109,26 +110,40 @@ TOp::LaidOutTensorCt TStrideC::AmendCtProgram(
   CHECK(input_tensors.size() == 1);
   const auto& input_tensor = input_tensors[0];
   CHECK(input_tensor.Layout() == input_layout_);
-  auto output_layout = OutputLayout();
-  const std::vector<TranslationMask>& translation_masks = MakeTranslationMasks(
-      input_layout_, output_layout,
-      [this, &output_layout](const TensorIndex& ti) {
+  const auto& result =
+      ApplyTranslations(ct_program, input_tensors[0], TranslationMasks(),
+                        output_layout_, InputPaddingIsZero());
+  return TOp::LaidOutTensorCt{result};
+}
+
+int TStrideC::BackendMaskDepth() const {
+  return mask_depth_.Get([this] { return TranslationMasks(); });
+}
+
+std::vector<TranslationMask> TStrideC::TranslationMasks() const {
+  auto index_bit_map = StrideIndexBitMap(
+      input_layout_.GetShape(),
+      Estd::transform(strides_, [](auto x) { return x.value(); }));
+  if (index_bit_map.has_value()) {
+    return MakeTranslationMasks(input_layout_, output_layout_,
+                                index_bit_map.value());
+  }
+  return MakeTranslationMasks(
+      input_layout_, output_layout_, [this](const TensorIndex& ti) {
         const auto& dim_indices = ti.DimensionIndices();
         return KeepIndexAfterStride(strides_, dim_indices)
                    ? std::make_optional<TensorIndex>(
-                         output_layout.GetShape(),
+                         output_layout_.GetShape(),
                          DimensionIndicesAfterStride(strides_, dim_indices))
                    : std::nullopt;
       });
-  const auto& result = ApplyTranslationMasks(ct_program, input_tensors[0],
-                                             translation_masks, output_layout);
-  return TOp::LaidOutTensorCt{result};
 }
 
 bool TStrideC::EqualTo(const TOp& other) const {
   const auto* t_stride_c = dynamic_cast<const TStrideC*>(&other);
   return t_stride_c && t_stride_c->OutputLayout() == OutputLayout() &&
          t_stride_c->InputLayout() == InputLayout() &&
+         t_stride_c->InputPaddingIsZero() == InputPaddingIsZero() &&
          Estd::transform(t_stride_c->Strides(), [](auto x) {
            return x.value();
          }) == Estd::transform(Strides(), [](auto x) { return x.value(); });
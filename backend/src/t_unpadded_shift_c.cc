@@ -55,6 +55,7 @@ void TUnpaddedShiftC::SetLayouts(const TensorLayout& input_layout,
   translation_masks_ = MakeTranslationMasks(
       layout_, OutputLayout(),
       [this](const TensorIndex& ti) { return rotate_by_.NonCyclicAdd(ti); });
+  backend_mask_depth_ = ComputeBackendMaskDepth();
 }
 
 bool TUnpaddedShiftC::EqualTo(const TOp& other) const {
@@ -71,45 +72,53 @@ TUnpaddedShiftC::TUnpaddedShiftC(const TensorLayout& layout,
       translation_masks_(MakeTranslationMasks(
           layout_, OutputLayout(), [this](const TensorIndex& ti) {
             return rotate_by_.NonCyclicAdd(ti);
-          })) {}
+          })),
+      backend_mask_depth_(ComputeBackendMaskDepth()) {}
 
-int TUnpaddedShiftC::BackendMaskDepth() const {
+int TUnpaddedShiftC::ComputeBackendMaskDepth() const {
   // nsamar: If all translation masks are either:
   // 1) all zeroes
   // OR
   // 2) only have 1s at the valid slots, and 0s in invalid slots, then the mask
   // need not be applied, because the invalid slots are already zeroed out!
+  std::vector<std::vector<std::optional<int>>> chunk_flat_indices;
+  for (const auto& offset : layout_.ChunkOffsets()) {
+    chunk_flat_indices.push_back(layout_.FlatTensorIndices(offset));
+  }
+  const auto& shape = layout_.GetShape();
+  auto source_in_bounds = [this, &shape](int dest_flat) {
+    auto dest_ti = TensorIndex(shape, dest_flat);
+    for (int dim_idx = 0; dim_idx < shape.DimensionCount(); dim_idx++) {
+      int target_idx = dest_ti[dim_idx] - rotate_by_[dim_idx];
+      if (target_idx < 0 || target_idx >= shape[dim_idx]) {
+        return false;
+      }
+    }
+    return true;
+  };
+
   for (const auto& [translation, mask_tensor] : translation_masks_) {
     int chunk_number = 0;
     for (const auto& chunk : mask_tensor.Chunks()) {
       if (std::holds_alternative<ZeroChunkIr>(chunk.Chunk())) {
+        chunk_number++;
         continue;
       }
-      const auto& values = std::get<DirectChunkIr>(chunk.Chunk()).Values();
-      auto indices =
-          layout_.TensorIndices(layout_.ChunkOffsets()[chunk_number]);
-      for (int i = 0; i < values.size(); i++) {
-        if (indices[i].has_value() && values[i] == 0) {
+      const auto& mask = std::get<DirectChunkIr>(chunk.Chunk());
+      const auto& indices = chunk_flat_indices.at(chunk_number);
+      for (int i = 0; i < mask.Size(); i++) {
+        if (indices[i].has_value() && !mask.IsOne(i)) {
           // What would happen if a value that wasn't selected, was selected...
           // if we end up in a index that is not to be padded, then we still
           // don't need to mask!
-          int dest_chunk = chunk_number + translation.ChunkNumberDiff();
+          int dest_chunk = (chunk_number + translation.ChunkNumberDiff()) %
+                           layout_.TotalChunks();
           int slot =
               (i + translation.ChunkIndexDiff()) % layout_.ChunkSize().value();
-          auto dest_ti =
-              layout_.TensorIndices(layout_.ChunkOffsets()[dest_chunk])[slot];
-          if (!dest_ti.has_value()) {
+          const auto& dest_flat = chunk_flat_indices.at(dest_chunk)[slot];
+          if (!dest_flat.has_value() || source_in_bounds(dest_flat.value())) {
             return 1;
           }
-          for (int dim_idx = 0; dim_idx < layout_.GetShape().DimensionCount();
-               dim_idx++) {
-            int target_idx = dest_ti.value()[dim_idx] - rotate_by_[dim_idx];
-            if (target_idx < 0 || target_idx >= layout_.GetShape()[dim_idx]) {
-              goto notit;
-            }
-          }
-          return 1;
-        notit:;
         }
       }
       chunk_number++;
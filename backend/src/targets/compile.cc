@@ -19,8 +19,10 @@
 #include <gflags/gflags.h>
 #include <glog/logging.h>
 
+#include <algorithm>
 #include <ostream>
 #include <string>
+#include <thread>
 
 #include "include/basic_ct_op_pass.h"
 #include "include/fhebooster_pass.h"
@@ -29,9 +31,12 @@
 #include "include/bootstrap_prunning_pass.h"
 #include "include/bootstrapping_precision.h"
 #include "include/chet_layout_pass.h"
+#include "include/compile_cache.h"
 #include "include/compiler.h"
 #include "include/constants.h"
+#include "include/conv_fusion_pass.h"
 #include "include/conversion_decomposer_pass.h"
+#include "include/cost_model_layout_pass.h"
 #include "include/ct_program.h"
 #include "include/dag.h"
 #include "include/dag_io.h"  // IWYU pragma: keep
@@ -41,21 +46,28 @@
 #include "include/filesystem_utils.h"
 #include "include/fill_gaps_layout_pass.h"
 #include "include/input_layout_pass.h"
+#include "include/layout_cost_model.h"
 #include "include/layout_hoisting_pass.h"
 #include "include/lazy_bootstrapping_on_chet_repacks_pass.h"
 #include "include/lazy_bootstrapping_pass.h"
 #include "include/level_minimization_pass.h"
 #include "include/leveled_t_op.h"
+#include "include/mat_vec_fusion_pass.h"
+#include "include/merge_mul_chains_pass.h"
 #include "include/merge_stride_chain_pass.h"
 #include "include/noop_leveling_pass.h"
 #include "include/pass_utils.h"
+#include "include/paterson_stockmeyer_pass.h"
 #include "include/persisted_dictionary.h"
 #include "include/repack_showering_pass.h"
+#include "include/rotation_factoring_pass.h"
+#include "include/rotation_sinking_pass.h"
 #include "include/scaled_t_op.h"
 #include "include/t_op.h"         // IWYU pragma: keep
 #include "include/t_op_embrio.h"  // IWYU pragma: keep
 #include "include/value_numbering_pass.h"
 #include "include/waterline_rescale.h"
+#include "include/zero_padding_pass.h"
 #include "latticpp/ckks/lattigo_param.h"
 #include "targets/gflag_utils/exe_folder_gflag_utils.h"
 #include "targets/gflag_utils/program_context_gflag_utils.h"
@@ -70,18 +82,56 @@ DEFINE_bool(sched_dfg, false,
 DEFINE_string(leveling_pass, "dp",
               "Bootstrapping pass type for the compiler (dp, lazy, or noop)");
 DEFINE_string(layout_pass, "fill_gaps",
-              "Layout pass type for the compiler (fill_gaps, chet)");
+              "Layout pass type for the compiler (fill_gaps, chet, or "
+              "cost_model)");
+DEFINE_string(layout_cost_model, "key_switch",
+              "Cost model that the cost_model layout pass minimizes "
+              "(key_switch or tentacles)");
+DEFINE_int32(dp_bootstrapping_max_states, 0,
+             "Transitions that the dp leveling pass evaluates in full before "
+             "falling back to a beam search (0 for no limit)");
+DEFINE_int32(bootstrap_pruning_threads, 0,
+             "Threads that the bootstrap pruning pass evaluates candidates on "
+             "(0 for one per hardware thread); does not change the output");
 DEFINE_int32(
     max_tentacles_per_conversion, 16,
     "Maximum number of tentacles per layout conversion (must be power of 2)");
 DEFINE_string(ct_op_pass, "basic",
               "CtOp pass type for the compiler (basic, dummy)");
+DEFINE_int32(ct_op_pass_threads, 0,
+             "Threads that the basic CtOp pass lowers TOps on (0 for one per "
+             "hardware thread); does not change the output");
 DEFINE_bool(repack_shower, false, "Set to true to add repacks to all edges");
+DEFINE_bool(fuse_conv, false,
+            "Replace the shift, multiply and add TOps of convolutions with "
+            "TConvC");
+DEFINE_bool(fuse_mat_vec, false,
+            "Replace the replicate, multiply and reduce TOps of matrix-vector "
+            "products with TMatVecC unless that costs more rotations");
+DEFINE_bool(paterson_stockmeyer, false,
+            "Re-lower polynomials built from powers of a ciphertext with the "
+            "Paterson-Stockmeyer method where that saves levels or TMulCCs");
+DEFINE_bool(merge_mul_chains, false,
+            "Fold chains of plaintext and scalar multiplies into a single "
+            "plaintext multiply");
+DEFINE_bool(track_zero_padding, false,
+            "Skip the masks of layout changes whose input is known to hold "
+            "zero in the slots that hold no tensor element");
+DEFINE_bool(factor_rotations, false,
+            "Factor rotations and plaintext multiplies shared by the operands "
+            "of a ciphertext addition out of the addition");
+DEFINE_bool(sink_rotations, false,
+            "Move each rotation below the rescale that consumes it, so that "
+            "it key-switches one level lower");
+DEFINE_string(compile_cache, "",
+              "Folder for caching pass outputs across compilations (no caching "
+              "if empty)");
 
 std::unique_ptr<LevelingPass> BootstrappingPassFromFlags(
     const ProgramContext& context) {
   if (FLAGS_leveling_pass == "dp") {
-    return std::make_unique<DpBootstrappingPass>(context);
+    return std::make_unique<DpBootstrappingPass>(
+        context, FLAGS_dp_bootstrapping_max_states);
   } else if (FLAGS_leveling_pass == "lazy") {
     return std::make_unique<LazyBootstrappingPass>(context);
   } else if (FLAGS_leveling_pass == "noop") {
@@ -99,9 +149,19 @@ std::unique_ptr<LayoutPass> LayoutPassFromFlags(const ProgramContext& context) {
   if (FLAGS_layout_pass == "chet") {
     return std::make_unique<ChetLayoutPass>(context);
   }
+  if (FLAGS_layout_pass == "cost_model") {
+    return std::make_unique<CostModelLayoutPass>(
+        context, LayoutCostModelFromName(FLAGS_layout_cost_model));
+  }
   LOG(FATAL);
 }
 
+int ThreadCount(int flag_value) {
+  return flag_value > 0
+             ? flag_value
+             : std::max<int>(1, std::thread::hardware_concurrency());
+}
+
 std::unique_ptr<CtOpPass> CtOpPassFromFlags(
     const ProgramContext& context,
     std::unique_ptr<PersistedDictionary<ChunkIr>>&& chunk_dict) {
@@ -109,7 +169,8 @@ std::unique_ptr<CtOpPass> CtOpPassFromFlags(
     return std::make_unique<DummyCtOpPass>(context, std::move(chunk_dict));
   }
   if (FLAGS_ct_op_pass == "basic") {
-    return std::make_unique<BasicCtOpPass>(context, std::move(chunk_dict));
+    return std::make_unique<BasicCtOpPass>(
+        context, std::move(chunk_dict), ThreadCount(FLAGS_ct_op_pass_threads));
   }
   LOG(FATAL);
 }
@@ -130,6 +191,9 @@ int main(int argc, char* argv[]) {
   auto context = ProgramContextFromFlags();
 
   auto builder = CompilerBuilder();
+  if (!FLAGS_compile_cache.empty()) {
+    builder.SetCompileCache(CompileCache(FLAGS_compile_cache));
+  }
 
   builder.AddPass<Preprocessor>(
       BasicPreprocessor(context.LogScale(), context.UsableLevels()));
@@ -140,8 +204,10 @@ int main(int argc, char* argv[]) {
   }
   builder.AddPass<EmbrioOptimizer>(MergeStrideChainPass());
   builder.AddPass<LayoutPass>(*LayoutPassFromFlags(context));
-  if (FLAGS_layout_pass == "fill_gaps") {
-    builder.AddPass<LayoutOptimizer>(LayoutHoistingPass());
+  if (FLAGS_layout_pass == "fill_gaps" || FLAGS_layout_pass == "cost_model") {
+    if (FLAGS_layout_pass == "fill_gaps") {
+      builder.AddPass<LayoutOptimizer>(LayoutHoistingPass());
+    }
     builder.AddPass<LayoutOptimizer>(ValueNumberingPass());
     builder.AddPass<LayoutOptimizer>(InputLayoutPass());
     builder.AddPass<LayoutOptimizer>(
@@ -150,15 +216,37 @@ int main(int argc, char* argv[]) {
     builder.AddPass<LayoutOptimizer>(
         ConversionDecomposerPass(FLAGS_max_tentacles_per_conversion));
   }
+  if (FLAGS_fuse_conv) {
+    builder.AddPass<LayoutOptimizer>(ConvFusionPass());
+  }
+  if (FLAGS_fuse_mat_vec) {
+    builder.AddPass<LayoutOptimizer>(MatVecFusionPass());
+  }
+  if (FLAGS_paterson_stockmeyer) {
+    builder.AddPass<LayoutOptimizer>(PatersonStockmeyerPass());
+  }
+  if (FLAGS_merge_mul_chains) {
+    builder.AddPass<LayoutOptimizer>(MergeMulChainsPass());
+  }
+  if (FLAGS_track_zero_padding) {
+    builder.AddPass<LayoutOptimizer>(ZeroPaddingPass());
+  }
   builder.AddPass<RescalingPass>(WaterlineRescale(context));
   builder.AddPass<LevelingPass>(*BootstrappingPassFromFlags(context));
   if (PruneBootstraps()) {
-    builder.AddPass<LevelingOptimizer>(BootstrapPrunningPass(context));
+    builder.AddPass<LevelingOptimizer>(BootstrapPrunningPass(
+        context, ThreadCount(FLAGS_bootstrap_pruning_threads)));
   }
   builder.AddPass<CtOpPass>(*CtOpPassFromFlags(
       context, std::make_unique<PersistedDictionary<ChunkIr>>(
                    ClearedPersistedDictionary<ChunkIr>(exe_folder / kChIr))));
   if (FLAGS_ct_op_pass != "dummy") {
+    if (FLAGS_factor_rotations) {
+      builder.AddPass<CtOpOptimizer>(RotationFactoringPass());
+    }
+    if (FLAGS_sink_rotations) {
+      builder.AddPass<CtOpOptimizer>(RotationSinkingPass());
+    }
     builder.AddPass<CtOpOptimizer>(LevelMinimizationPass());
   }
 
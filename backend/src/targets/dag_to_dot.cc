@@ -48,15 +48,18 @@ std::vector<PassName> layout_optimizers = {
     PassName{"fill_gaps_layout_pass"}, PassName{"conversion_decomposer_pass"},
     PassName{"layout_hoisting_pass"},  PassName{"value_numbering_pass"},
     PassName{"input_layout_pass"},     PassName{"chet_layout_pass"},
-    PassName{"merge_mul_chains_pass"}};
+    PassName{"merge_mul_chains_pass"}, PassName{"cost_model_layout_pass"},
+    PassName{"conv_fusion_pass"},      PassName{"mat_vec_fusion_pass"},
+    PassName{"paterson_stockmeyer_pass"}, PassName{"zero_padding_pass"}};
 std::vector<PassName> rescalers = {PassName{"waterline_rescale"}};
 std::vector<PassName> leveling_optimizers = {
     PassName{"dp_bootstrapping_pass"}, PassName{"lazy_bootstrapping_pass"},
     PassName{"noop_leveling_pass"}, PassName{"bootstrap_prunning_pass"},
     PassName{"lazy_bootstrapping_on_chet_repacks_pass"}};
-std::vector<PassName> ct_op_optimizers = {PassName{"dummy_ct_op_pass"},
-                                          PassName{"basic_ct_op_pass"},
-                                          PassName{"level_minimization_pass"}};
+std::vector<PassName> ct_op_optimizers = {
+    PassName{"dummy_ct_op_pass"},        PassName{"basic_ct_op_pass"},
+    PassName{"level_minimization_pass"}, PassName{"rotation_factoring_pass"},
+    PassName{"rotation_sinking_pass"}};
 
 DEFINE_string(src_pass, "basic_parser", "Source pass name");
 DEFINE_string(dest_pass, "", "Destination pass name");
@@ -32,12 +32,15 @@ DEFINE_int32(usable_levels, fhelipe::kDefaultUsableLevels,
 DEFINE_int32(bootstrapping_precision,
              fhelipe::kDefaultBootstrappingPrecision.value(),
              "Bit-precision of bootstrapping");
+DEFINE_int32(mask_log_scale, 0,
+             "LogScale of backend-generated 0/1 masks; 0 uses log_scale");
 
 namespace {
 
 fhelipe::ProgramContext ProgramContextFromFlags() {
   return {FLAGS_log_chunk_size, FLAGS_log_scale, FLAGS_usable_levels,
-          FLAGS_bootstrapping_precision};
+          FLAGS_bootstrapping_precision,
+          FLAGS_mask_log_scale > 0 ? FLAGS_mask_log_scale : FLAGS_log_scale};
 }
 
 }  // namespace
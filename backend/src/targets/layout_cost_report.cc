@@ -0,0 +1,110 @@
+/** $lic$
+ * Copyright (C) 2023-2024 by Massachusetts Institute of Technology
+ *
+ * This file is part of the Fhelipe compiler.
+ *
+ * Fhelipe is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * Fhelipe is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>. 
+ */
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include <map>
+
+#include "include/basic_parser.h"
+#include "include/chet_layout_pass.h"
+#include "include/compiled_program.h"
+#include "include/constants.h"
+#include "include/cost_model_layout_pass.h"
+#include "include/fill_gaps_layout_pass.h"
+#include "include/input_layout_pass.h"
+#include "include/layout_cost_model.h"
+#include "include/layout_hoisting_pass.h"
+#include "include/value_numbering_pass.h"
+#include "targets/gflag_utils/exe_folder_gflag_utils.h"
+#include "targets/gflag_utils/program_context_gflag_utils.h"
+
+using namespace fhelipe;
+
+namespace {
+
+DEFINE_string(layout_cost_model, "key_switch",
+              "Cost model to compare layout passes with: key_switch or "
+              "tentacles.");
+DEFINE_bool(full, false, "Set flag to see the cost breakdown per TOp.");
+
+// Runs each layout pass the way compile does on the embrio dag of a compiled
+// program
+Dag<TOp> FillGapsLayout(const ProgramContext& context,
+                        const ParserOutput& embrio_dag) {
+  auto dag = FillGapsLayoutPass(context).DoPass(CloneFromAncestor(embrio_dag));
+  dag = LayoutHoistingPass().DoPass(dag);
+  dag = ValueNumberingPass().DoPass(dag);
+  return InputLayoutPass().DoPass(dag);
+}
+
+Dag<TOp> ChetLayout(const ProgramContext& context,
+                    const ParserOutput& embrio_dag) {
+  return ChetLayoutPass(context).DoPass(CloneFromAncestor(embrio_dag));
+}
+
+Dag<TOp> CostModelLayout(const ProgramContext& context,
+                         const ParserOutput& embrio_dag,
+                         const LayoutCostModel& cost_model) {
+  auto dag = CostModelLayoutPass(context, cost_model.CloneUniq())
+                 .DoPass(CloneFromAncestor(embrio_dag));
+  dag = ValueNumberingPass().DoPass(dag);
+  return InputLayoutPass().DoPass(dag);
+}
+
+void Report(const std::string& name, const Dag<TOp>& dag,
+            const LayoutCostModel& cost_model) {
+  std::map<std::string, double> breakdown;
+  for (const auto& node : dag.NodesInTopologicalOrder()) {
+    breakdown[node->Value().TypeName()] += cost_model.TOpCost(node->Value());
+  }
+  double total_cost = EstimatedCost(dag, cost_model);
+  std::cout << name << ": " << total_cost << std::endl;
+  if (FLAGS_full) {
+    for (const auto& [type, cost] : breakdown) {
+      if (cost > 0) {
+        std::cout << "  " << type << ": " << cost << " ("
+                  << 100 * cost / total_cost << "%)" << std::endl;
+      }
+    }
+  }
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+  google::ParseCommandLineFlags(&argc, &argv, true);
+  std::ios_base::sync_with_stdio(false);
+
+  auto exe_folder = ExeFolderFromFlags();
+  auto context = ProgramContextFromFlags();
+  auto cost_model = LayoutCostModelFromName(FLAGS_layout_cost_model);
+
+  auto compiled_program =
+      ReadFile<CompiledProgram>(exe_folder / kCompiledProgram);
+  const auto& embrio_dag = compiled_program.GetDag<ParserOutput>(
+      BasicParser().GetPassName());
+
+  std::cout << "Estimated cost (" << cost_model->Name() << ")" << std::endl;
+  Report("fill_gaps", FillGapsLayout(context, embrio_dag), *cost_model);
+  Report("chet", ChetLayout(context, embrio_dag), *cost_model);
+  Report("cost_model", CostModelLayout(context, embrio_dag, *cost_model),
+         *cost_model);
+}
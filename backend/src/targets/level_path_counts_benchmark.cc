@@ -0,0 +1,122 @@
+/** $lic$
+ * Copyright (C) 2023-2024 by Massachusetts Institute of Technology
+ *
+ * This file is part of the Fhelipe compiler.
+ *
+ * Fhelipe is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * Fhelipe is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>. 
+ */
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "include/add_cc.h"
+#include "include/constants.h"
+#include "include/ct_op.h"
+#include "include/dag.h"
+#include "include/extended_std.h"
+#include "include/input_c.h"
+#include "include/io_spec.h"
+#include "include/level_info.h"
+#include "include/level_path_counts.h"
+#include "include/mul_cc.h"
+#include "include/rescale_c.h"
+
+using namespace fhelipe;
+
+DEFINE_int32(max_nodes, 1 << 16,
+             "Largest synthetic dag to count paths on (in nodes)");
+DEFINE_int32(usable_levels, kDefaultUsableLevels,
+             "Levels between bootstraps");
+
+namespace {
+
+LevelInfo BenchmarkLevelInfo() {
+  return LevelInfo{FLAGS_usable_levels, kDefaultLogScale};
+}
+
+// `depth` layers of `width` nodes, each multiplying two random nodes of the
+// layer before it, with every other layer rescaled
+Dag<CtOp> CreateLayeredDag(int width, int depth) {
+  std::mt19937 generator(width * 7919 + depth);
+  Dag<CtOp> dag;
+  std::vector<std::shared_ptr<Node<CtOp>>> layer;
+  for (int idx : Estd::indices(width)) {
+    auto io_spec = IoSpec("in" + std::to_string(idx), 0);
+    layer.push_back(dag.AddNode(
+        std::make_unique<InputC>(BenchmarkLevelInfo(), io_spec), {}));
+  }
+  for (int layer_idx : Estd::indices(depth)) {
+    std::vector<std::shared_ptr<Node<CtOp>>> next_layer;
+    for (int idx : Estd::indices(width)) {
+      const auto& lhs = layer.at(idx);
+      const auto& rhs = layer.at(generator() % width);
+      if (layer_idx % 2 == 0) {
+        next_layer.push_back(dag.AddNode(
+            std::make_unique<MulCC>(BenchmarkLevelInfo()), {lhs, rhs}));
+      } else {
+        auto sum = dag.AddNode(std::make_unique<AddCC>(BenchmarkLevelInfo()),
+                               {lhs, rhs});
+        next_layer.push_back(dag.AddNode(
+            std::make_unique<RescaleC>(BenchmarkLevelInfo()), {sum}));
+      }
+    }
+    layer = next_layer;
+  }
+  return dag;
+}
+
+// Times counting the paths and greedily bootstrapping until no path runs
+// out of levels, as FheBoosterPass does
+void Benchmark(const std::string& shape, int width, int depth) {
+  auto dag = CreateLayeredDag(width, depth);
+  auto start = std::chrono::steady_clock::now();
+  LevelPathCounts path_counts(dag, FLAGS_usable_levels);
+  int boot_count = 0;
+  while (path_counts.MaxCount() > 0) {
+    path_counts.Bootstrap(*path_counts.MaxNode());
+    boot_count++;
+  }
+  std::chrono::duration<double, std::milli> elapsed =
+      std::chrono::steady_clock::now() - start;
+  std::cout << shape << "\t" << width << "\t" << depth << "\t"
+            << dag.NodesInTopologicalOrder().size() << "\t" << boot_count
+            << "\t" << elapsed.count() << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  google::InitGoogleLogging(argv[0]);
+  google::InstallFailureSignalHandler();
+  google::ParseCommandLineNonHelpFlags(&argc, &argv, true);
+
+  std::cout << "shape\twidth\tdepth\tnodes\tbootstraps\tms" << std::endl;
+  // Wide dags are a few bootstraps deep; deep dags are a few nodes wide
+  int wide_depth = 4 * FLAGS_usable_levels;
+  for (int width = 16; width * wide_depth * 3 / 2 <= FLAGS_max_nodes;
+       width *= 2) {
+    Benchmark("wide", width, wide_depth);
+  }
+  int deep_width = 4;
+  for (int depth = 4 * FLAGS_usable_levels;
+       depth * deep_width * 3 / 2 <= FLAGS_max_nodes; depth *= 2) {
+    Benchmark("deep", deep_width, depth);
+  }
+}
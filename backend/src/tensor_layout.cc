@@ -25,6 +25,8 @@
 #include <functional>
 #include <iterator>
 #include <memory>
+#include <mutex>
+#include <shared_mutex>
 #include <type_traits>
 #include <vector>
 
@@ -55,51 +57,141 @@ std::vector<DimensionBit> TensorLayout::TensorOffsetBits() const {
   return result;
 }
 
-int TensorLayout::ChunkNumberAt(const TensorIndex& ti) const {
-  int chunk_offset = ChunkOffsetAt(ti).Flat();
-  const auto& offsets = ChunkOffsets();
-  // Binary search
-  int low = 0;
-  int high = offsets.size();
-  int mid = (low + high) / 2;
-  while (offsets[mid].Flat() != chunk_offset) {
-    if (offsets[mid].Flat() > chunk_offset) {
-      high = mid;
-    } else {
-      low = mid;
+// Per-dimension lookup tables; since the layout is a permutation of index
+// bits, every index computation is a sum of per-dimension contributions
+struct TensorLayout::IndexTables {
+  // Row-major strides of the shape
+  std::vector<int> strides;
+  // [dim] -> index bits of dim that are placed in the chunk
+  std::vector<int> in_chunk_masks;
+  // [dim][dim_idx] -> bits that dim_idx sets in the chunk index
+  std::vector<std::vector<int>> chunk_index_bits;
+  // Flat index of chunk offset -> chunk number
+  std::unordered_map<int, int> chunk_numbers;
+  // [slot] -> flat index of the element at slot of the chunk at the zero
+  // offset, or -1 if the slot holds no element at any offset
+  std::vector<int> slot_flat;
+  // [slot * DimensionCount() + dim] -> dim index of slot at the zero offset
+  std::vector<int> slot_dims;
+};
+
+const TensorLayout::IndexTables& TensorLayout::Tables() const {
+  if (const auto* tables = index_tables_.load(std::memory_order_acquire)) {
+    return *tables;
+  }
+  // Tables are never evicted, so layouts can keep plain pointers to them
+  static std::unordered_map<TensorLayout, std::unique_ptr<const IndexTables>>
+      index_tables_cache;
+  static std::shared_mutex index_tables_mutex;
+  {
+    std::shared_lock lock(index_tables_mutex);
+    auto it = index_tables_cache.find(*this);
+    if (it != index_tables_cache.end()) {
+      index_tables_.store(it->second.get(), std::memory_order_release);
+      return *it->second;
     }
-    mid = (low + high) / 2;
   }
-  return mid;
-}
 
-TensorIndex TensorLayout::ChunkOffsetAt(const TensorIndex& ti) const {
-  std::vector<int> result(ti.DimensionIndices().size());
-  auto offset_bits = TensorOffsetBits();
-  auto ti_indices = ti.DimensionIndices();
-  for (int dim = 0; dim < ti.GetShape().DimensionCount(); ++dim) {
-    int ti_idx = ti_indices[dim];
-    for (int bit_idx = 0; bit_idx < offset_bits.size(); ++bit_idx) {
-      TensorLayout::LayoutBit lb = offset_bits[bit_idx];
-      if (!lb.has_value()) {
+  // Built without holding the lock; a thread that loses the race to insert
+  // the same tables drops its copy
+  auto tables = std::make_unique<IndexTables>();
+  const int dim_cnt = shape_.DimensionCount();
+  tables->strides.resize(dim_cnt);
+  int stride = 1;
+  for (int dim = dim_cnt - 1; dim >= 0; --dim) {
+    tables->strides[dim] = stride;
+    stride *= shape_[dim];
+  }
+
+  tables->in_chunk_masks.resize(dim_cnt, 0);
+  tables->chunk_index_bits.resize(dim_cnt);
+  for (int dim = 0; dim < dim_cnt; ++dim) {
+    tables->chunk_index_bits[dim].resize(shape_[dim], 0);
+  }
+  for (int slot_bit = 0; slot_bit < bits_.size(); ++slot_bit) {
+    const LayoutBit& lb = bits_[slot_bit];
+    if (!lb.has_value()) {
+      continue;
+    }
+    tables->in_chunk_masks[lb->dimension] |= 1 << lb->bit_index;
+    auto& chunk_index_bits = tables->chunk_index_bits[lb->dimension];
+    for (int dim_idx = 0; dim_idx < chunk_index_bits.size(); ++dim_idx) {
+      if (dim_idx & (1 << lb->bit_index)) {
+        chunk_index_bits[dim_idx] |= 1 << slot_bit;
+      }
+    }
+  }
+
+  const auto& offsets = ChunkOffsets();
+  for (int chunk_number = 0; chunk_number < offsets.size(); ++chunk_number) {
+    tables->chunk_numbers.emplace(offsets[chunk_number].Flat(), chunk_number);
+  }
+
+  const int chunk_size = ChunkSize().value();
+  tables->slot_flat.resize(chunk_size, -1);
+  tables->slot_dims.resize(chunk_size * dim_cnt, 0);
+  for (int slot = 0; slot < chunk_size; ++slot) {
+    int* dims = &tables->slot_dims[slot * dim_cnt];
+    bool valid = true;
+    for (int slot_bit = 0; slot_bit < bits_.size(); ++slot_bit) {
+      if (!(slot & (1 << slot_bit))) {
         continue;
       }
-      if (lb.value().dimension == dim) {
-        if ((1 << lb.value().bit_index) & ti_idx) {
-          result[dim] += (1 << lb.value().bit_index);
-        }
+      const LayoutBit& lb = bits_[slot_bit];
+      if (!lb.has_value()) {
+        valid = false;
+        break;
       }
+      dims[lb->dimension] += 1 << lb->bit_index;
+    }
+    int flat = 0;
+    for (int dim = 0; valid && dim < dim_cnt; ++dim) {
+      valid = dims[dim] < shape_[dim];
+      flat += dims[dim] * tables->strides[dim];
+    }
+    if (valid) {
+      tables->slot_flat[slot] = flat;
     }
   }
+
+  std::unique_lock lock(index_tables_mutex);
+  const auto& cached =
+      index_tables_cache.emplace(*this, std::move(tables)).first->second;
+  index_tables_.store(cached.get(), std::memory_order_release);
+  return *cached;
+}
+
+int TensorLayout::ChunkNumberAt(const TensorIndex& ti) const {
+  const auto& tables = Tables();
+  int offset_flat = 0;
+  for (int dim = 0; dim < tables.strides.size(); ++dim) {
+    offset_flat +=
+        (ti[dim] & ~tables.in_chunk_masks[dim]) * tables.strides[dim];
+  }
+  return tables.chunk_numbers.at(offset_flat);
+}
+
+TensorIndex TensorLayout::ChunkOffsetAt(const TensorIndex& ti) const {
+  const auto& tables = Tables();
+  Array result(ti.DimensionIndices());
+  for (int dim = 0; dim < result.size(); ++dim) {
+    result[dim] &= ~tables.in_chunk_masks[dim];
+  }
   return TensorIndex(GetShape(), result);
 }
 
 static std::unordered_map<TensorLayout, std::vector<TensorIndex>> chunk_offsets;
+static std::shared_mutex chunk_offsets_mutex;
 
 const std::vector<TensorIndex>& TensorLayout::ChunkOffsets() const {
-  if (Estd::contains_key(chunk_offsets, *this)) {
-    CHECK(chunk_offsets.at(*this)[0].GetShape() == GetShape());
-    return chunk_offsets.at(*this);
+  {
+    // Entries are never erased, so references to them stay valid
+    std::shared_lock lock(chunk_offsets_mutex);
+    auto it = chunk_offsets.find(*this);
+    if (it != chunk_offsets.end()) {
+      CHECK(it->second[0].GetShape() == GetShape());
+      return it->second;
+    }
   }
 
   const auto offset_bits = TensorOffsetBits();
@@ -121,78 +213,83 @@ const std::vector<TensorIndex>& TensorLayout::ChunkOffsets() const {
     }
   }
 
-  chunk_offsets.emplace(*this, offsets);
-  return chunk_offsets.at(*this);
+  std::unique_lock lock(chunk_offsets_mutex);
+  return chunk_offsets.emplace(*this, std::move(offsets)).first->second;
 }
 
 MaybeTensorIndex TensorLayout::TensorIndexAt(int index) const {
-  std::vector<int> dim_inds(shape_.DimensionCount(), 0);
-
-  for (const auto& [bit_i, bit] : BitsInIndex(index)) {
-    if (!bit.has_value()) {
-      return std::nullopt;
-    }
-    dim_inds[bit->dimension] += (1 << bit->bit_index);
-  }
-  for (const auto& [bit_i, bit] : BitsInIndex(index)) {
-    if (dim_inds[bit->dimension] >= shape_[bit->dimension]) {
-      return std::nullopt;
-    }
+  const auto& tables = Tables();
+  if (tables.slot_flat.at(index) < 0) {
+    return std::nullopt;
   }
-  return {TensorIndex(shape_, dim_inds)};
+  return {TensorIndex(shape_, tables.slot_flat[index])};
 }
 
 int TensorLayout::ChunkIndexAt(const TensorIndex& ti) const {
+  const auto& tables = Tables();
   int chunk_idx = 0;
-  auto ti_indices = ti.DimensionIndices();
-  for (int dim = 0; dim < ti.GetShape().DimensionCount(); ++dim) {
-    int ti_idx = ti_indices[dim];
-    for (int bit_idx = 0; bit_idx < bits_.size(); ++bit_idx) {
-      LayoutBit lb = bits_[bit_idx];
-      if (!lb.has_value()) {
-        continue;
-      }
-      if (lb.value().dimension == dim) {
-        if ((1 << lb.value().bit_index) & ti_idx) {
-          chunk_idx += (1 << bit_idx);
-        }
-      }
-    }
+  for (int dim = 0; dim < tables.chunk_index_bits.size(); ++dim) {
+    chunk_idx |= tables.chunk_index_bits[dim][ti[dim]];
   }
   return chunk_idx;
 }
 
+std::vector<std::optional<int>> TensorLayout::FlatTensorIndices(
+    const TensorIndex& offset) const {
+  CHECK(shape_ == offset.GetShape());
+  const auto& tables = Tables();
+  const int dim_cnt = shape_.DimensionCount();
+  // Slot dim index + offset dim index must stay within the shape
+  std::vector<int> limits(dim_cnt);
+  for (int dim = 0; dim < dim_cnt; ++dim) {
+    limits[dim] = shape_[dim] - offset[dim];
+  }
+
+  std::vector<std::optional<int>> result(tables.slot_flat.size());
+  for (int slot = 0; slot < tables.slot_flat.size(); ++slot) {
+    if (tables.slot_flat[slot] < 0) {
+      continue;
+    }
+    const int* dims = &tables.slot_dims[slot * dim_cnt];
+    bool in_range = true;
+    for (int dim = 0; in_range && dim < dim_cnt; ++dim) {
+      in_range = dims[dim] < limits[dim];
+    }
+    if (in_range) {
+      result[slot] = tables.slot_flat[slot] + offset.Flat();
+    }
+  }
+  return result;
+}
+
 // Performance optimization
 std::unordered_map<
     TensorLayout,
     std::unordered_map<TensorIndex, std::vector<MaybeTensorIndex>>>
     tensor_indices_cache;
+std::shared_mutex tensor_indices_mutex;
 
 std::vector<MaybeTensorIndex> TensorLayout::TensorIndices(
     TensorIndex offset) const {
   CHECK(shape_ == offset.GetShape());
-  if (Estd::contains_key(tensor_indices_cache, *this) &&
-      Estd::contains_key(tensor_indices_cache.at(*this), offset)) {
-    return tensor_indices_cache.at(*this).at(offset);
+  {
+    std::shared_lock lock(tensor_indices_mutex);
+    if (Estd::contains_key(tensor_indices_cache, *this) &&
+        Estd::contains_key(tensor_indices_cache.at(*this), offset)) {
+      return tensor_indices_cache.at(*this).at(offset);
+    }
   }
 
   std::vector<MaybeTensorIndex> result;
   result.reserve(ChunkSize().value());
-  for (int i = 0; i < ChunkSize().value(); ++i) {
-    MaybeTensorIndex raw_result = TensorIndexAt(i);
-    if (raw_result.has_value()) {
-      Array dim_indices = raw_result.value().DimensionIndices();
-      Array offset_indices = offset.DimensionIndices();
-      dim_indices = Estd::transform(dim_indices, offset_indices, std::plus<>());
-      if (IsInRange(shape_, dim_indices)) {
-        result.emplace_back(TensorIndex(shape_, dim_indices));
-      } else {
-        result.emplace_back(std::nullopt);
-      }
+  for (const auto& flat : FlatTensorIndices(offset)) {
+    if (flat.has_value()) {
+      result.emplace_back(TensorIndex(shape_, flat.value()));
     } else {
-      result.push_back(raw_result);
+      result.emplace_back(std::nullopt);
     }
   }
+  std::unique_lock lock(tensor_indices_mutex);
   tensor_indices_cache[*this].emplace(offset, result);
   return result;
 }
@@ -230,15 +327,6 @@ void TensorLayout::CheckRep() const {
   }
 }
 
-std::vector<std::pair<int, TensorLayout::LayoutBit>> TensorLayout::BitsInIndex(
-    int index) const {
-  std::vector<int> indices = MaskedIndices(IndexMask(index));
-  return Estd::transform(
-      indices, [this](int index) -> std::pair<int, TensorLayout::LayoutBit> {
-        return std::make_pair(index, this->bits_[index]);
-      });
-}
-
 TensorLayout::TensorLayout(const Shape& shape,
                            const std::vector<LayoutBit>& layout_bits)
     : shape_(shape), bits_(layout_bits) {
@@ -0,0 +1,124 @@
+/** $lic$
+ * Copyright (C) 2023-2024 by Massachusetts Institute of Technology
+ *
+ * This file is part of the Fhelipe compiler.
+ *
+ * Fhelipe is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * Fhelipe is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>. 
+ */
+
+#include <memory>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "include/add_cp.h"
+#include "include/basic_ct_op_pass.h"
+#include "include/chunk_ir.h"
+#include "include/ct_program.h"
+#include "include/lazy_bootstrapping_pass.h"
+#include "include/mul_cp.h"
+#include "include/program_context.h"
+#include "include/ram_dictionary.h"
+#include "include/t_add_cc.h"
+#include "include/t_mat_vec_c.h"
+#include "include/t_mul_cc.h"
+#include "include/tensor_layout.h"
+#include "include/waterline_rescale.h"
+#include "test/test_constants.h"
+#include "test/test_utils.h"
+
+using namespace fhelipe;
+
+namespace {
+
+constexpr int kMaxRows = 16;
+
+// Two matrix-vector products that can be lowered side by side
+Dag<TOp> CreateTwoMatVecTOpDag() {
+  auto input_layout = RandomLayout(RandomShape(1 + rand() % 2));
+  auto output_layout =
+      RandomLayout(Shape({1 + rand() % kMaxRows}), input_layout.ChunkSize());
+  Dag<TOp> top_dag;
+  const auto& a = MakeInputNode(top_dag, input_layout, "in0");
+  const auto& w0_a = top_dag.AddNode(
+      std::make_unique<TMatVecC>(input_layout, output_layout, "w0",
+                                 LogScale(50)),
+      {a});
+  const auto& w1_a = top_dag.AddNode(
+      std::make_unique<TMatVecC>(input_layout, output_layout, "w1",
+                                 LogScale(50)),
+      {a});
+  const auto& sum =
+      top_dag.AddNode(std::make_unique<TAddCC>(output_layout), {w0_a, w1_a});
+  const auto& square =
+      top_dag.AddNode(std::make_unique<TMulCC>(output_layout), {sum, sum});
+  MakeOutputNode(top_dag, square, "out0");
+  return top_dag;
+}
+
+// The program with node ids and chunk keys replaced by what they refer to
+std::vector<std::string> Canonical(const ct_program::CtProgram& ct_program) {
+  std::vector<std::string> result;
+  for (const auto& key : ct_program.RecordedChunkKeys()) {
+    std::stringstream stream;
+    WriteStream(stream, ct_program.GetChunkIr(key));
+    result.push_back(stream.str());
+  }
+  std::unordered_map<const Node<CtOp>*, int> positions;
+  for (const auto& node : ct_program.NodesInTopologicalOrder()) {
+    const auto& ct_op = node->Value();
+    std::stringstream stream;
+    stream << ct_op.TypeName() << " ";
+    WriteStream(stream, ct_op.GetLevelInfo());
+    if (const auto* mul_cp = dynamic_cast<const MulCP*>(&ct_op)) {
+      WriteStream(stream, ct_program.GetChunkIr(mul_cp->GetHandle()));
+    }
+    if (const auto* add_cp = dynamic_cast<const AddCP*>(&ct_op)) {
+      WriteStream(stream, ct_program.GetChunkIr(add_cp->GetHandle()));
+    }
+    for (const auto& parent : node->Parents()) {
+      stream << " " << positions.at(parent.get());
+    }
+    WriteStream(stream, node->Ancestors());
+    positions.emplace(node.get(), positions.size());
+    result.push_back(stream.str());
+  }
+  return result;
+}
+
+}  // namespace
+
+TEST(BasicCtOpPassTest, ThreadCountDoesNotChangeProgram) {
+  for (int i = 0; i < kIterationsPerTest; ++i) {
+    auto top_dag = CreateTwoMatVecTOpDag();
+    auto chunk_size = top_dag.NodesInTopologicalOrder()
+                          .at(0)
+                          ->Value()
+                          .OutputLayout()
+                          .ChunkSize();
+    auto context = ProgramContext{
+        LogChunkSize(chunk_size), kDefaultTestContext.LogScale(),
+        kDefaultTestContext.UsableLevels(),
+        kDefaultTestContext.GetBootstrappingPrecision()};
+    auto leveled_dag = LazyBootstrappingPass(context).DoPass(
+        WaterlineRescale(context).DoPass(top_dag));
+    auto lower = [&](int thread_count) {
+      return Canonical(
+          BasicCtOpPass(context, std::make_unique<RamDictionary<ChunkIr>>(),
+                        thread_count)
+              .DoPass(leveled_dag));
+    };
+    ASSERT_EQ(lower(1), lower(4));
+  }
+}
@@ -0,0 +1,69 @@
+/** $lic$
+ * Copyright (C) 2023-2024 by Massachusetts Institute of Technology
+ *
+ * This file is part of the Fhelipe compiler.
+ *
+ * Fhelipe is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * Fhelipe is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>. 
+ */
+
+#include "include/bootstrap_prunning_pass.h"
+#include "include/bootstrapping_pass_utils.h"
+#include "include/leveled_t_op.h"
+#include "include/t_bootstrap_c.h"
+#include "include/t_rescale_c.h"
+#include "test/test_constants.h"
+#include "test/test_utils.h"
+
+using namespace fhelipe;
+
+namespace {
+
+Dag<LeveledTOp> Prune(const Dag<LeveledTOp>& leveled_dag, int thread_count) {
+  return BootstrapPrunningPass(kDefaultTestContext, thread_count)
+      .DoPass(leveled_dag);
+}
+
+}  // namespace
+
+TEST(BootstrapPrunningPassTest, KeepsLevelsConsistent) {
+  auto leveled_dag = LevelWithDp(CreateDeepResidualTOpDag());
+  auto pruned_dag = Prune(leveled_dag, 1);
+  EXPECT_LE(pruned_dag.NodesInTopologicalOrder().size(),
+            leveled_dag.NodesInTopologicalOrder().size());
+  for (const auto& node : pruned_dag.NodesInTopologicalOrder()) {
+    const auto& t_op = node->Value().GetTOp();
+    auto level = node->Value().Level();
+    EXPECT_GE(level, kMinLevel);
+    if (node->Parents().empty() || dynamic_cast<const TBootstrapC*>(&t_op)) {
+      continue;
+    }
+    auto parent_levels = Estd::transform(node->Parents(), [](const auto& p) {
+      return p->Value().Level().value();
+    });
+    if (dynamic_cast<const TRescaleC*>(&t_op)) {
+      EXPECT_EQ(level.value(), parent_levels.at(0) - 1);
+    } else {
+      EXPECT_EQ(level.value(), Estd::min_element(parent_levels));
+    }
+  }
+}
+
+TEST(BootstrapPrunningPassTest, SecondPruneChangesNothing) {
+  auto pruned_dag = Prune(LevelWithDp(CreateDeepResidualTOpDag()), 1);
+  EXPECT_EQ(Levels(Prune(pruned_dag, 1)), Levels(pruned_dag));
+}
+
+TEST(BootstrapPrunningPassTest, ThreadCountDoesNotChangeOutput) {
+  auto leveled_dag = LevelWithDp(CreateDeepResidualTOpDag());
+  EXPECT_EQ(Levels(Prune(leveled_dag, 4)), Levels(Prune(leveled_dag, 1)));
+}
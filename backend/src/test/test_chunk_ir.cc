@@ -0,0 +1,212 @@
+/** $lic$
+ * Copyright (C) 2023-2024 by Massachusetts Institute of Technology
+ *
+ * This file is part of the Fhelipe compiler.
+ *
+ * Fhelipe is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * Fhelipe is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>. 
+ */
+
+#include <gflags/gflags.h>
+
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <variant>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "include/chunk_ir.h"
+#include "include/constants.h"
+#include "include/ct_program.h"
+#include "include/filesystem_utils.h"
+#include "include/io_utils.h"
+#include "include/persisted_dictionary.h"
+#include "include/ram_dictionary.h"
+#include "test/test_constants.h"
+#include "test/test_utils.h"
+
+DECLARE_bool(avoid_writes);
+
+using namespace fhelipe;
+
+namespace {
+
+std::vector<PtVal> MaskValues() {
+  std::vector<PtVal> values(256, 0);
+  for (int idx : {0, 1, 2, 63, 64, 65, 130, 255}) {
+    values.at(idx) = 1;
+  }
+  return values;
+}
+
+std::vector<PtVal> ResolveMask(const ChunkIr& chunk) {
+  return Resolve(chunk, RamDictionary<Tensor<PtVal>>()).Values();
+}
+
+// Two strided runs separated by padding, plus an irregular tail
+std::vector<std::optional<int>> IndirectIndices() {
+  std::vector<std::optional<int>> result(128);
+  for (int idx : Estd::indices(32)) {
+    result.at(idx) = idx;
+    result.at(64 + idx) = 100 + 2 * idx;
+  }
+  result.at(120) = 7;
+  result.at(122) = 3;
+  return result;
+}
+
+RamDictionary<Tensor<PtVal>> IndirectTensors() {
+  RamDictionary<Tensor<PtVal>> result;
+  std::vector<PtVal> values(200);
+  for (int idx : Estd::indices(values.size())) {
+    values.at(idx) = idx + 1;
+  }
+  result.Record("weights", Tensor<PtVal>(Shape{200}, values));
+  return result;
+}
+
+}  // namespace
+
+TEST(DirectChunkIrTest, ResolveExpandsBits) {
+  auto values = MaskValues();
+  DirectChunkIr mask(values);
+  ASSERT_EQ(mask.Size(), values.size());
+  for (int idx : Estd::indices(values.size())) {
+    ASSERT_EQ(mask.IsOne(idx), values.at(idx) == 1);
+  }
+  ASSERT_EQ(ResolveMask(mask), values);
+}
+
+TEST(DirectChunkIrTest, StreamRoundTrip) {
+  for (const auto& values :
+       {MaskValues(), std::vector<PtVal>(128, 0), std::vector<PtVal>(128, 1)}) {
+    std::stringstream stream;
+    WriteStream<ChunkIr>(stream, DirectChunkIr(values));
+    ASSERT_EQ(ResolveMask(ReadStream<ChunkIr>(stream)), values);
+  }
+}
+
+TEST(DirectChunkIrTest, ReadsIndexListFormat) {
+  std::stringstream stream;
+  stream << kMaskChunkIrKeyword << " 256 ";
+  WriteStream(stream, std::vector<int>{0, 1, 2, 63, 64, 65, 130, 255});
+  ASSERT_EQ(ResolveMask(ReadStream<ChunkIr>(stream)), MaskValues());
+}
+
+TEST(CtProgramTest, RecordChunkDeduplicatesContent) {
+  ct_program::CtProgram ct_program(
+      kDefaultTestContext, std::make_unique<RamDictionary<ChunkIr>>(),
+      Dag<CtOp>());
+  auto mask_key = ct_program.RecordChunk(DirectChunkIr(MaskValues()));
+  ASSERT_EQ(ct_program.RecordChunk(DirectChunkIr(MaskValues())), mask_key);
+
+  auto zeros_key =
+      ct_program.RecordChunk(DirectChunkIr(std::vector<PtVal>(256, 0)));
+  ASSERT_NE(zeros_key, mask_key);
+
+  auto indirect = IndirectChunkIr("weights", {0, std::nullopt, 2, 3});
+  auto indirect_key = ct_program.RecordChunk(indirect);
+  ASSERT_EQ(ct_program.RecordChunk(indirect), indirect_key);
+  ASSERT_NE(ct_program.RecordChunk(IndirectChunkIr("bias", {0, std::nullopt,
+                                                            2, 3})),
+            indirect_key);
+  ASSERT_EQ(ct_program.ChunkDictionary()->Keys().size(), 4);
+}
+
+TEST(CtProgramTest, RecordChunkDoesNotReadBackUnwrittenChunks) {
+  auto folder_path = std::filesystem::temp_directory_path() /
+                     "fhelipe_test_record_chunk_avoid_writes";
+  bool avoid_writes = FLAGS_avoid_writes;
+  FLAGS_avoid_writes = true;
+  {
+    ct_program::CtProgram ct_program(
+        kDefaultTestContext,
+        std::make_unique<PersistedDictionary<ChunkIr>>(
+            ClearedPersistedDictionary<ChunkIr>(folder_path)),
+        Dag<CtOp>());
+    auto mask_key = ct_program.RecordChunk(DirectChunkIr(MaskValues()));
+    ASSERT_EQ(ct_program.RecordChunk(DirectChunkIr(MaskValues())), mask_key);
+
+    auto derived = ct_program.WithDag(Dag<CtOp>());
+    ASSERT_EQ(derived.RecordChunk(DirectChunkIr(MaskValues())), mask_key);
+    ASSERT_NE(derived.RecordChunk(DirectChunkIr(std::vector<PtVal>(256, 0))),
+              mask_key);
+    ASSERT_TRUE(ContainedFilepaths(folder_path).empty());
+  }
+  FLAGS_avoid_writes = avoid_writes;
+  EnsureDoesNotExist(folder_path);
+}
+
+TEST(IndirectChunkIrTest, CompressesAffineRuns) {
+  IndirectChunkIr chunk("weights", IndirectIndices());
+  ASSERT_EQ(chunk.Runs().size(), 4);
+  ASSERT_EQ(chunk.Runs().at(1), (IndexRun{64, 32, 100, 2}));
+  ASSERT_EQ(chunk.FlatIndices(), IndirectIndices());
+}
+
+TEST(IndirectChunkIrTest, ResolveGathers) {
+  auto flat_indices = IndirectIndices();
+  auto resolved =
+      Resolve(IndirectChunkIr("weights", flat_indices), IndirectTensors());
+  for (int idx : Estd::indices(flat_indices.size())) {
+    ASSERT_EQ(resolved.Values().at(idx), flat_indices.at(idx).value_or(-1) + 1);
+  }
+}
+
+TEST(IndirectChunkIrTest, StreamRoundTrip) {
+  std::vector<std::optional<int>> scattered(16);
+  for (int idx : Estd::indices(scattered.size())) {
+    scattered.at(idx) = (idx * 7) % 16;
+  }
+  for (const auto& flat_indices : {IndirectIndices(), scattered}) {
+    IndirectChunkIr chunk("weights", flat_indices);
+    std::stringstream stream;
+    WriteStream<ChunkIr>(stream, chunk);
+    ASSERT_EQ(ReadStream<ChunkIr>(stream), ChunkIr(chunk));
+  }
+}
+
+TEST(ProductChunkIrTest, ResolveMultipliesFactors) {
+  auto flat_indices = IndirectIndices();
+  ProductChunkIr chunk({IndirectChunkIr("weights", flat_indices),
+                        IndirectChunkIr("weights", flat_indices)},
+                       2);
+  auto resolved = Resolve(chunk, IndirectTensors());
+  for (int idx : Estd::indices(flat_indices.size())) {
+    PtVal value = flat_indices.at(idx).value_or(-1) + 1;
+    ASSERT_EQ(resolved.Values().at(idx), 2 * value * value);
+  }
+
+  std::stringstream stream;
+  WriteStream<ChunkIr>(stream, chunk);
+  ASSERT_EQ(ReadStream<ChunkIr>(stream), ChunkIr(chunk));
+}
+
+TEST(SumChunkIrTest, ResolveAddsTerms) {
+  auto flat_indices = IndirectIndices();
+  SumChunkIr chunk({IndirectChunkIr("weights", flat_indices),
+                    SumChunkIr({DirectChunkIr(std::vector<PtVal>(
+                        flat_indices.size(), 1))})});
+  auto resolved = Resolve(chunk, IndirectTensors());
+  for (int idx : Estd::indices(flat_indices.size())) {
+    ASSERT_EQ(resolved.Values().at(idx),
+              flat_indices.at(idx).value_or(-1) + 2);
+  }
+
+  std::stringstream stream;
+  WriteStream<ChunkIr>(stream, chunk);
+  ASSERT_EQ(ReadStream<ChunkIr>(stream), ChunkIr(chunk));
+}
@@ -0,0 +1,54 @@
+/** $lic$
+ * Copyright (C) 2023-2024 by Massachusetts Institute of Technology
+ *
+ * This file is part of the Fhelipe compiler.
+ *
+ * Fhelipe is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * Fhelipe is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>. 
+ */
+
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "include/chunk_size.h"
+#include "include/cleartext.h"
+#include "include/constants.h"
+#include "include/level.h"
+#include "include/plaintext_chunk.h"
+#include "include/scaled_pt_val.h"
+#include "test/test_constants.h"
+#include "test/test_utils.h"
+
+using namespace fhelipe;
+
+TEST(CleartextTest, DropLevelCKeepsValuesAndScale) {
+  PtChunk values(IotaVector(ChunkSize(kDefaultLogChunkSize).value()));
+  auto ct = Encrypt<Cleartext>(values, kDefaultTestContext);
+  auto dropped = ct.DropLevelC(Level(2));
+  EXPECT_EQ(dropped.GetLevelInfo(),
+            LevelInfo(Level(2), ct.GetLevelInfo().LogScale()));
+  EXPECT_EQ(dropped.Decrypt().Values(), values.Values());
+}
+
+// Like the LattigoCt evaluator's addConst, adding a scalar does not scale the
+// ciphertext
+TEST(CleartextTest, AddCSKeepsTheLargerScale) {
+  PtChunk values(IotaVector(ChunkSize(kDefaultLogChunkSize).value()));
+  auto ct = Encrypt<Cleartext>(values, kDefaultTestContext);
+  auto log_scale = ct.GetLevelInfo().LogScale();
+  EXPECT_EQ(ct.AddCS(ScaledPtVal(log_scale, 3)).GetLevelInfo(),
+            ct.GetLevelInfo());
+  EXPECT_EQ(ct.AddCS(ScaledPtVal(log_scale.value() + 10, 3))
+                .GetLevelInfo()
+                .LogScale(),
+            LogScale(log_scale.value() + 10));
+}
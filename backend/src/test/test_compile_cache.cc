@@ -0,0 +1,171 @@
+/** $lic$
+ * Copyright (C) 2023-2024 by Massachusetts Institute of Technology
+ *
+ * This file is part of the Fhelipe compiler.
+ *
+ * Fhelipe is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * Fhelipe is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>. 
+ */
+
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "include/add_cp.h"
+#include "include/chunk_ir.h"
+#include "include/compile_cache.h"
+#include "include/constants.h"
+#include "include/ct_program.h"
+#include "include/filesystem_utils.h"
+#include "include/io_spec.h"
+#include "include/mul_cp.h"
+#include "include/persisted_dictionary.h"
+#include "include/ram_dictionary.h"
+#include "test/test_constants.h"
+
+using namespace fhelipe;
+
+namespace {
+
+std::filesystem::path ScratchFolder(const std::string& name) {
+  auto path = std::filesystem::temp_directory_path() / ("fhelipe_test_" + name);
+  EnsureDoesNotExist(path);
+  return path;
+}
+
+DirectChunkIr Mask(int set_slot) {
+  std::vector<PtVal> values(ChunkSize(kDefaultLogChunkSize).value(), 0);
+  values.at(set_slot) = 1;
+  return DirectChunkIr(values);
+}
+
+LevelInfo InputLevelInfo() {
+  return {kDefaultTestContext.UsableLevels(), kDefaultLogScale};
+}
+
+// Input, masked by a MulCP, shifted by an AddCP, to output
+ct_program::CtProgram CreateMaskingProgram(
+    std::unique_ptr<Dictionary<ChunkIr>>&& chunk_dict) {
+  ct_program::CtProgram ct_program(kDefaultTestContext, std::move(chunk_dict),
+                                   Dag<CtOp>());
+  auto input =
+      ct_program::CreateInputC(ct_program, InputLevelInfo(), IoSpec("in", 0));
+  auto masked =
+      ct_program::CreateMulCP(ct_program, input, Mask(0), kDefaultLogScale);
+  auto shifted = ct_program::CreateAddCP(
+      ct_program, masked, Mask(1), masked->Value().GetLevelInfo().LogScale());
+  ct_program::CreateOutputC(ct_program, shifted->Value().GetLevelInfo(),
+                            IoSpec("out", 0), shifted);
+  return ct_program;
+}
+
+std::optional<KeyType> Handle(const CtOp& ct_op) {
+  if (const auto* mul_cp = dynamic_cast<const MulCP*>(&ct_op)) {
+    return mul_cp->GetHandle();
+  }
+  if (const auto* add_cp = dynamic_cast<const AddCP*>(&ct_op)) {
+    return add_cp->GetHandle();
+  }
+  return std::nullopt;
+}
+
+std::vector<KeyType> Handles(const ct_program::CtProgram& ct_program) {
+  std::vector<KeyType> result;
+  for (const auto& node : ct_program.NodesInTopologicalOrder()) {
+    if (auto handle = Handle(node->Value())) {
+      result.push_back(handle.value());
+    }
+  }
+  return result;
+}
+
+// The chunk each plaintext operand refers to, in topological order
+std::vector<ChunkIr> OperandChunks(const ct_program::CtProgram& ct_program) {
+  std::vector<ChunkIr> result;
+  for (const auto& handle : Handles(ct_program)) {
+    result.push_back(ct_program.GetChunkIr(handle));
+  }
+  return result;
+}
+
+}  // namespace
+
+TEST(CompileCacheTest, MissReturnsNothing) {
+  auto cache_folder = ScratchFolder("cache_miss");
+  CompileCache cache(cache_folder);
+  ASSERT_FALSE(
+      cache.Fetch<ct_program::CtProgram>("missing", cache_folder / "exe"));
+  EnsureDoesNotExist(cache_folder);
+}
+
+TEST(CompileCacheTest, HitRestoresChunksAndTheirIndex) {
+  auto cache_folder = ScratchFolder("cache_hit");
+  CompileCache cache(cache_folder / "cache");
+  auto ct_program =
+      CreateMaskingProgram(std::make_unique<RamDictionary<ChunkIr>>());
+  cache.Store("entry", ct_program);
+
+  auto restored =
+      cache.Fetch<ct_program::CtProgram>("entry", cache_folder / "exe");
+  ASSERT_TRUE(restored);
+  ASSERT_EQ(restored->NodesInTopologicalOrder().size(),
+            ct_program.NodesInTopologicalOrder().size());
+  ASSERT_EQ(OperandChunks(restored.value()), OperandChunks(ct_program));
+  // Identical chunks recorded after the hit still share the restored key
+  ASSERT_EQ(restored->RecordChunk(Mask(0)), Handles(restored.value()).at(0));
+  EnsureDoesNotExist(cache_folder);
+}
+
+TEST(CompileCacheTest, MissAfterHitDoesNotReuseCachedKeys) {
+  auto cache_folder = ScratchFolder("cache_partial_hit");
+  CompileCache cache(cache_folder / "cache");
+  // Cache keys as another process would have minted them: the same keys
+  // this process mints next
+  std::unique_ptr<Dictionary<ChunkIr>> scratch_dict =
+      std::make_unique<RamDictionary<ChunkIr>>();
+  auto next_key = scratch_dict->Record(Mask(0));
+  int next_idx = std::stoi(next_key.substr(2)) + 1;
+  ct_program::CtProgram cached_program(
+      kDefaultTestContext, std::make_unique<RamDictionary<ChunkIr>>(),
+      Dag<CtOp>());
+  auto input = ct_program::CreateInputC(cached_program, InputLevelInfo(),
+                                        IoSpec("in", 0));
+  for (int slot : {0, 1}) {
+    auto key = "__" + std::to_string(next_idx + slot);
+    cached_program.ChunkDictionary()->Record(key, Mask(slot));
+    input = cached_program.AddNode(
+        std::make_unique<MulCP>(input->Value().GetLevelInfo(), key,
+                                kDefaultLogScale),
+        {input});
+  }
+  cache.Store("entry", cached_program);
+
+  auto restored =
+      cache.Fetch<ct_program::CtProgram>("entry", cache_folder / "exe");
+  ASSERT_TRUE(restored);
+  ASSERT_EQ(OperandChunks(restored.value()),
+            std::vector<ChunkIr>({Mask(0), Mask(1)}));
+  // As a CtOpOptimizer that misses the cache would
+  auto new_key = restored->RecordChunk(SumChunkIr({Mask(0), Mask(1)}));
+  auto handles = Handles(restored.value());
+  ASSERT_EQ(std::set<KeyType>(handles.begin(), handles.end()).size(), 2);
+  for (const auto& handle : handles) {
+    ASSERT_NE(handle, new_key);
+  }
+  ASSERT_EQ(restored->GetChunkIr(new_key),
+            ChunkIr(SumChunkIr({Mask(0), Mask(1)})));
+  EnsureDoesNotExist(cache_folder);
+}
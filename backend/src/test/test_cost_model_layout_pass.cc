@@ -0,0 +1,103 @@
+/** $lic$
+ * Copyright (C) 2023-2024 by Massachusetts Institute of Technology
+ *
+ * This file is part of the Fhelipe compiler.
+ *
+ * Fhelipe is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * Fhelipe is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>. 
+ */
+
+#include <memory>
+
+#include "gtest/gtest.h"
+#include "include/cost_model_layout_pass.h"
+#include "include/dag.h"
+#include "include/fill_gaps_layout_pass.h"
+#include "include/layout_cost_model.h"
+#include "include/shape.h"
+#include "include/t_op_embrio.h"
+#include "test/test_constants.h"
+
+using namespace fhelipe;
+
+namespace {
+
+// Two chunks at kDefaultLogChunkSize
+const Shape kTwoChunkShape = {256, 256};
+
+// Sums a two-chunk input over its first dimension
+Dag<TOpEmbrio> CreateReduceDag() {
+  Dag<TOpEmbrio> dag;
+  auto input = dag.AddNode(
+      std::make_unique<TInputCEmbrio>(kTwoChunkShape, "in0", kDefaultLogScale),
+      {});
+  auto reduced =
+      dag.AddNode(std::make_unique<TReduceDimCEmbrio>(kTwoChunkShape, 0),
+                  {input});
+  dag.AddNode(
+      std::make_unique<TOutputCEmbrio>(reduced->Value().OutputShape(), "out0"),
+      {reduced});
+  return dag;
+}
+
+// Adds the input squared to its sum over the first dimension replicated back,
+// so that the input has several consumers
+Dag<TOpEmbrio> CreateDiamondDag() {
+  Dag<TOpEmbrio> dag;
+  auto input = dag.AddNode(
+      std::make_unique<TInputCEmbrio>(kTwoChunkShape, "in0", kDefaultLogScale),
+      {});
+  auto reduced =
+      dag.AddNode(std::make_unique<TReduceDimCEmbrio>(kTwoChunkShape, 0),
+                  {input});
+  auto replicated = dag.AddNode(std::make_unique<TReplicateDimCEmbrio>(
+                                    reduced->Value().OutputShape(), 0, 256),
+                                {reduced});
+  auto squared = dag.AddNode(std::make_unique<TMulCCEmbrio>(kTwoChunkShape),
+                             {input, input});
+  auto sum = dag.AddNode(std::make_unique<TAddCCEmbrio>(kTwoChunkShape),
+                         {replicated, squared});
+  dag.AddNode(std::make_unique<TOutputCEmbrio>(kTwoChunkShape, "out0"), {sum});
+  return dag;
+}
+
+double CostModelCost(const Dag<TOpEmbrio>& dag) {
+  KeySwitchCostModel cost_model;
+  return EstimatedCost(
+      CostModelLayoutPass(kDefaultTestContext, cost_model.CloneUniq())
+          .DoPass(dag),
+      cost_model);
+}
+
+double FillGapsCost(const Dag<TOpEmbrio>& dag) {
+  return EstimatedCost(FillGapsLayoutPass(kDefaultTestContext).DoPass(dag),
+                       KeySwitchCostModel());
+}
+
+}  // namespace
+
+TEST(CostModelLayoutPassTest, KeepsReducedDimensionOutsideChunks) {
+  auto dag = CreateReduceDag();
+  EXPECT_LT(CostModelCost(dag), FillGapsCost(dag));
+}
+
+TEST(CostModelLayoutPassTest, NoWorseThanFillGapsWithSeveralConsumers) {
+  auto dag = CreateDiamondDag();
+  EXPECT_LE(CostModelCost(dag), FillGapsCost(dag));
+}
+
+TEST(CostModelLayoutPassTest, TentacleModelNeedsNoConversionsOnAChain) {
+  auto out_dag = CostModelLayoutPass(kDefaultTestContext,
+                                     std::make_unique<TentacleCostModel>())
+                     .DoPass(CreateReduceDag());
+  EXPECT_EQ(EstimatedCost(out_dag, TentacleCostModel()), 0);
+}
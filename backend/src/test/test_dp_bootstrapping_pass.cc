@@ -0,0 +1,60 @@
+/** $lic$
+ * Copyright (C) 2023-2024 by Massachusetts Institute of Technology
+ *
+ * This file is part of the Fhelipe compiler.
+ *
+ * Fhelipe is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * Fhelipe is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>. 
+ */
+
+#include "include/bootstrapping_pass_utils.h"
+#include "include/constants.h"
+#include "include/dp_bootstrapping_pass.h"
+#include "include/leveled_t_op.h"
+#include "include/t_bootstrap_c.h"
+#include "test/test_constants.h"
+#include "test/test_utils.h"
+
+using namespace fhelipe;
+
+namespace {
+
+int BootstrapCount(const Dag<LeveledTOp>& dag) {
+  return Estd::filter(dag.NodesInTopologicalOrder(), [](const auto& node) {
+           return dynamic_cast<const TBootstrapC*>(&node->Value().GetTOp()) !=
+                  nullptr;
+         }).size();
+}
+
+}  // namespace
+
+TEST(DpBootstrappingPassTest, LevelsDeepDag) {
+  auto leveled_dag = LevelWithDp(CreateDeepResidualTOpDag(), 0);
+  EXPECT_GE(BootstrapCount(leveled_dag), 3);
+  for (const auto& node : leveled_dag.NodesInTopologicalOrder()) {
+    EXPECT_GE(node->Value().Level(), kMinLevel);
+  }
+}
+
+TEST(DpBootstrappingPassTest, UnusedBudgetDoesNotChangeLeveling) {
+  auto top_dag = CreateDeepResidualTOpDag();
+  EXPECT_EQ(Levels(LevelWithDp(top_dag, 1000000)),
+            Levels(LevelWithDp(top_dag, 0)));
+}
+
+TEST(DpBootstrappingPassTest, ExhaustedBudgetStillLevels) {
+  auto leveled_dag = LevelWithDp(CreateDeepResidualTOpDag(), 1);
+  EXPECT_GE(BootstrapCount(leveled_dag), 3);
+  for (const auto& node : leveled_dag.NodesInTopologicalOrder()) {
+    EXPECT_GE(node->Value().Level(), kMinLevel);
+  }
+}
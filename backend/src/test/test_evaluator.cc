@@ -0,0 +1,108 @@
+/** $lic$
+ * Copyright (C) 2023-2024 by Massachusetts Institute of Technology
+ *
+ * This file is part of the Fhelipe compiler.
+ *
+ * Fhelipe is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * Fhelipe is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>. 
+ */
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "include/add_cc.h"
+#include "include/bootstrap_c.h"
+#include "include/chunk_ir.h"
+#include "include/constants.h"
+#include "include/ct_program.h"
+#include "include/io_spec.h"
+#include "include/level_info.h"
+#include "include/mul_cc.h"
+#include "include/mul_cp.h"
+#include "include/rescale_c.h"
+#include "include/rotate_c.h"
+#include "include/zero_c.h"
+#include "test/test_constants.h"
+#include "test/test_utils.h"
+
+using namespace fhelipe;
+
+namespace {
+
+using CtNode = std::shared_ptr<Node<CtOp>>;
+
+LevelInfo TopLevelInfo() {
+  return {kDefaultTestContext.UsableLevels(), kDefaultLogScale};
+}
+
+LevelInfo RescaledLevelInfo() {
+  return {kDefaultTestContext.UsableLevels().value() - 1, kDefaultLogScale};
+}
+
+}  // namespace
+
+// Nodes are added straight to the DAG: the ct_program::Create* helpers already
+// fold zero operands away, but programs built without them still have some
+TEST(EvaluatorTest, FoldsZeroOperands) {
+  auto ct_program = EmptyCtProgram();
+  auto input = MakeInputChunk(ct_program, 0);
+  auto zero = ct_program.AddNode(std::make_unique<ZeroC>(TopLevelInfo()), {});
+  auto zero_sum = ct_program.AddNode(std::make_unique<AddCC>(TopLevelInfo()),
+                                     {zero, zero});
+  auto mask = ct_program.RecordChunk(DirectChunkIr(
+      std::vector<PtVal>(ChunkSize(kDefaultLogChunkSize).value(), 1)));
+
+  std::vector<CtNode> forwarded = {
+      ct_program.AddNode(std::make_unique<AddCC>(TopLevelInfo()),
+                         {input, zero}),
+      ct_program.AddNode(std::make_unique<AddCC>(TopLevelInfo()),
+                         {zero, input}),
+      ct_program.AddNode(std::make_unique<AddCC>(TopLevelInfo()),
+                         {zero_sum, input}),
+  };
+  std::vector<CtNode> zeros = {
+      zero_sum,
+      ct_program.AddNode(std::make_unique<MulCC>(TopLevelInfo()),
+                         {input, zero}),
+      ct_program.AddNode(
+          std::make_unique<MulCP>(TopLevelInfo(), mask, kDefaultLogScale),
+          {zero}),
+      ct_program.AddNode(std::make_unique<RotateC>(TopLevelInfo(), 3), {zero}),
+      ct_program.AddNode(std::make_unique<RescaleC>(RescaledLevelInfo()),
+                         {zero}),
+      ct_program.AddNode(std::make_unique<BootstrapC>(TopLevelInfo()), {zero}),
+  };
+  int offset = 0;
+  for (const auto& node : forwarded) {
+    MakeOutputChunk(ct_program, node, offset++);
+  }
+  for (const auto& node : zeros) {
+    MakeOutputChunk(ct_program, node, offset++);
+  }
+
+  std::vector<PtVal> values(ChunkSize(kDefaultLogChunkSize).value());
+  for (auto& value : values) {
+    value = rand() % 17 - 8;
+  }
+  auto outputs = EvaluateOnCleartext(ct_program, {values});
+  ASSERT_EQ(outputs.size(), forwarded.size() + zeros.size());
+  for (offset = 0; offset < outputs.size(); ++offset) {
+    const auto& output = outputs.at(ToFilename(IoSpec("out", offset)));
+    if (offset < forwarded.size()) {
+      EXPECT_EQ(output, values) << offset;
+    } else {
+      EXPECT_EQ(output, std::vector<PtVal>(values.size(), 0)) << offset;
+    }
+  }
+}
@@ -79,6 +79,17 @@ TEST(LattigoCt, Conv) {
   std::cout << "added ok" << std::endl;
 }
 
+TEST(LattigoCt, DropLevelC) {
+  PtChunk cmsg0(IotaVector(slot_count));
+  LattigoCt ct0 = Encrypt<LattigoCt>(cmsg0, param);
+  Level level(ct0.GetLevel().value() - 2);
+  LattigoCt result = ct0.DropLevelC(level);
+  ASSERT_EQ(result.GetLevel(), level);
+  TestCloseEnough(result.Decrypt().Values(), cmsg0.Values());
+  // The input may have other consumers, so it keeps its level
+  ASSERT_EQ(ct0.GetLevel().value(), level.value() + 2);
+}
+
 TEST(LattigoCt, MulCC) {
   PtChunk cmsg0(IotaVector(slot_count));
   PtChunk cmsg1(IotaVector(slot_count));
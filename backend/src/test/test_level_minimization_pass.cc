@@ -0,0 +1,136 @@
+/** $lic$
+ * Copyright (C) 2023-2024 by Massachusetts Institute of Technology
+ *
+ * This file is part of the Fhelipe compiler.
+ *
+ * Fhelipe is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * Fhelipe is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>. 
+ */
+
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "include/bootstrap_c.h"
+#include "include/constants.h"
+#include "include/ct_program.h"
+#include "include/drop_level_c.h"
+#include "include/input_c.h"
+#include "include/level_info.h"
+#include "include/level_minimization_pass.h"
+#include "include/mul_cp.h"
+#include "include/output_c.h"
+#include "test/test_constants.h"
+#include "test/test_utils.h"
+
+using namespace fhelipe;
+
+namespace {
+
+using CtNode = std::shared_ptr<Node<CtOp>>;
+
+LevelInfo AtLevel(int level) { return {level, kDefaultLogScale}; }
+
+DirectChunkIr AllOnesMask() {
+  return DirectChunkIr(
+      std::vector<PtVal>(ChunkSize(kDefaultLogChunkSize).value(), 1));
+}
+
+// `levels` rescales on top of `node`, ending at level 1
+CtNode RescaleDownToOne(ct_program::CtProgram& ct_program, CtNode node,
+                        int levels) {
+  for (int level = levels; level > 0; --level) {
+    node = ct_program::CreateRescaleC(ct_program, AtLevel(level), node);
+  }
+  return node;
+}
+
+}  // namespace
+
+TEST(LevelMinimizationPassTest, DropsInputsToTheLevelTheirConsumersNeed) {
+  auto ct_program = EmptyCtProgram();
+  auto product = ct_program::CreateMulCP(
+      ct_program, MakeInputChunk(ct_program, 0), AllOnesMask(),
+      kDefaultLogScale);
+  MakeOutputChunk(ct_program, RescaleDownToOne(ct_program, product, 2), 0);
+
+  auto minimized = LevelMinimizationPass().DoPass(ct_program);
+  auto drops = NodesOfType<DropLevelC>(minimized);
+  ASSERT_EQ(drops.size(), 1);
+  const auto& drop = drops.at(0);
+  ASSERT_EQ(drop->Parents().size(), 1);
+  EXPECT_TRUE(dynamic_cast<const InputC*>(&drop->Parents().at(0)->Value()));
+  EXPECT_EQ(drop->Ancestors(), drop->Parents().at(0)->Ancestors());
+  ASSERT_EQ(drop->Children().size(), 1);
+  EXPECT_TRUE(
+      dynamic_cast<const MulCP*>(&(*drop->Children().begin())->Value()));
+  EXPECT_EQ(drop->Value().GetLevel(), Level(3));
+  ExpectSameOutputsOnCleartext(ct_program, minimized, 1);
+}
+
+TEST(LevelMinimizationPassTest, LeavesEdgesIntoBootstrapsAlone) {
+  auto ct_program = EmptyCtProgram();
+  auto input = MakeInputChunk(ct_program, 0);
+  // Bootstraps to a level below the top one, which is all its consumers need
+  auto bootstrap =
+      ct_program::CreateBootstrapC(ct_program, AtLevel(3), input);
+  auto product = ct_program::CreateMulCP(ct_program, bootstrap, AllOnesMask(),
+                                         kDefaultLogScale);
+  MakeOutputChunk(ct_program, RescaleDownToOne(ct_program, product, 2), 0);
+  MakeOutputChunk(ct_program, input, 1);
+
+  auto minimized = LevelMinimizationPass().DoPass(ct_program);
+  auto bootstraps = NodesOfType<BootstrapC>(minimized);
+  ASSERT_EQ(bootstraps.size(), 1);
+  ASSERT_EQ(bootstraps.at(0)->Parents().size(), 1);
+  EXPECT_TRUE(dynamic_cast<const InputC*>(
+      &bootstraps.at(0)->Parents().at(0)->Value()));
+  // Only the output of the input is dropped; the bootstrap already produces
+  // the level its consumers need
+  auto drops = NodesOfType<DropLevelC>(minimized);
+  ASSERT_EQ(drops.size(), 1);
+  EXPECT_TRUE(
+      dynamic_cast<const InputC*>(&drops.at(0)->Parents().at(0)->Value()));
+  EXPECT_TRUE(dynamic_cast<const OutputC*>(
+      &(*drops.at(0)->Children().begin())->Value()));
+  ExpectSameOutputsOnCleartext(ct_program, minimized, 1);
+}
+
+TEST(LevelMinimizationPassTest, WritesDropsToTheSchedulableDataflowGraph) {
+  auto ct_program = EmptyCtProgram();
+  MakeOutputChunk(ct_program, MakeInputChunk(ct_program, 0), 0);
+  auto minimized = LevelMinimizationPass().DoPass(ct_program);
+  ASSERT_EQ(NodesOfType<DropLevelC>(minimized).size(), 1);
+
+  std::vector<int> level_map(kDefaultTestContext.UsableLevels().value() + 1);
+  for (int level = 0; level < level_map.size(); ++level) {
+    level_map.at(level) = level;
+  }
+  std::stringstream stream;
+  ct_program::WriteSchedulableDataflowGraph(stream, minimized, level_map,
+                                            level_map);
+  // Input, output and the drop (ids follow ancestor ids, so the drop added by
+  // the pass comes last; it is written as a MulCP like the output), then the
+  // edges from the input through the drop to the output
+  std::string line;
+  std::vector<std::string> lines;
+  while (std::getline(stream, line)) {
+    lines.push_back(line);
+  }
+  ASSERT_EQ(lines.size(), 6);
+  EXPECT_EQ(lines.at(1), "0\tCIPHERTEXT\tin_0\t2\tct");
+  EXPECT_EQ(lines.at(3), "2\tMUL_SIMPLE\tMulCP\t2\tct");
+  EXPECT_EQ(lines.at(4), "0\t2");
+  EXPECT_EQ(lines.at(5), "2\t1");
+}
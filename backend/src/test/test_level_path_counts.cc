@@ -0,0 +1,187 @@
+/** $lic$
+ * Copyright (C) 2023-2024 by Massachusetts Institute of Technology
+ *
+ * This file is part of the Fhelipe compiler.
+ *
+ * Fhelipe is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * Fhelipe is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>. 
+ */
+
+#include <limits>
+#include <random>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "include/add_cc.h"
+#include "include/ct_op.h"
+#include "include/dag.h"
+#include "include/input_c.h"
+#include "include/io_spec.h"
+#include "include/level_info.h"
+#include "include/level_path_counts.h"
+#include "include/mul_cc.h"
+#include "include/rescale_c.h"
+#include "test/test_constants.h"
+
+using namespace fhelipe;
+
+namespace {
+
+typedef LevelPathCounts::PathCount PathCount;
+
+const Level kUsableLevels = 3;
+
+LevelInfo TestLevelInfo() {
+  return LevelInfo{kUsableLevels, kDefaultTestContext.LogScale()};
+}
+
+// Random multiplies, adds and rescales, each reading from recent nodes
+Dag<CtOp> CreateRandomCtOpDag(int seed, int node_count) {
+  std::mt19937 generator(seed);
+  Dag<CtOp> dag;
+  std::vector<std::shared_ptr<Node<CtOp>>> nodes = {dag.AddNode(
+      std::make_unique<InputC>(TestLevelInfo(), IoSpec("in0", 0)), {})};
+  for (int idx : Estd::indices(node_count)) {
+    (void)idx;
+    auto recent = [&nodes, &generator] {
+      int window = std::min<int>(nodes.size(), 4);
+      return nodes.at(nodes.size() - 1 - generator() % window);
+    };
+    switch (generator() % 3) {
+      case 0:
+        nodes.push_back(dag.AddNode(std::make_unique<MulCC>(TestLevelInfo()),
+                                    {recent(), recent()}));
+        break;
+      case 1:
+        nodes.push_back(dag.AddNode(std::make_unique<AddCC>(TestLevelInfo()),
+                                    {recent(), recent()}));
+        break;
+      default:
+        nodes.push_back(dag.AddNode(
+            std::make_unique<RescaleC>(TestLevelInfo()), {recent()}));
+    }
+  }
+  return dag;
+}
+
+bool IsRescale(const Node<CtOp>& node) {
+  return dynamic_cast<const RescaleC*>(&node.Value()) != nullptr;
+}
+
+// Recounts all the paths from scratch
+std::unordered_map<const Node<CtOp>*, PathCount> ReferenceCounts(
+    const Dag<CtOp>& dag,
+    const std::unordered_set<const Node<CtOp>*>& bootstrapped) {
+  int levels = kUsableLevels.value();
+  std::unordered_map<const Node<CtOp>*, std::vector<PathCount>> backward;
+  for (const auto& node : dag.NodesInTopologicalOrder()) {
+    auto& counts = backward[node.get()] = std::vector<PathCount>(levels);
+    if (bootstrapped.contains(node.get())) {
+      continue;
+    }
+    if (IsRescale(*node)) {
+      counts.at(0) = 1;
+    }
+    for (const auto& parent : Estd::vector_to_set(node->Parents())) {
+      for (int level : Estd::indices(levels)) {
+        if (!IsRescale(*node)) {
+          counts.at(level) += backward.at(parent.get()).at(level);
+        } else if (level > 0) {
+          counts.at(level) += backward.at(parent.get()).at(level - 1);
+        }
+      }
+    }
+  }
+  std::unordered_map<const Node<CtOp>*, std::vector<PathCount>> forward;
+  for (const auto& node : dag.NodesInReverseTopologicalOrder()) {
+    auto& counts = forward[node.get()] = std::vector<PathCount>(levels);
+    if (bootstrapped.contains(node.get())) {
+      continue;
+    }
+    bool has_rescale_child = Estd::any_of(
+        node->Children(), [](const auto& child) { return IsRescale(*child); });
+    if (has_rescale_child) {
+      counts.at(0) = 1;
+    }
+    for (const auto& child : node->Children()) {
+      for (int level : Estd::indices(levels)) {
+        if (IsRescale(*node)) {
+          if (level > 0) {
+            counts.at(level) += forward.at(child.get()).at(level - 1);
+          }
+        } else if (level > 0 || !has_rescale_child) {
+          counts.at(level) += forward.at(child.get()).at(level);
+        }
+      }
+    }
+  }
+  std::unordered_map<const Node<CtOp>*, PathCount> result;
+  for (const auto& node : dag.NodesInTopologicalOrder()) {
+    for (int level : Estd::indices(levels)) {
+      result[node.get()] += backward.at(node.get()).at(level) *
+                            forward.at(node.get()).at(levels - 1 - level);
+    }
+  }
+  return result;
+}
+
+}  // namespace
+
+TEST(LevelPathCountsTest, BootstrapMatchesRecount) {
+  for (int seed : Estd::indices(5)) {
+    auto dag = CreateRandomCtOpDag(seed, 60);
+    LevelPathCounts path_counts(dag, kUsableLevels);
+    std::unordered_set<const Node<CtOp>*> bootstrapped;
+    int boot_count = 0;
+    while (path_counts.MaxCount() > 0) {
+      auto reference = ReferenceCounts(dag, bootstrapped);
+      for (const auto& node : dag.NodesInTopologicalOrder()) {
+        ASSERT_TRUE(path_counts.Count(*node) == reference.at(node.get()));
+        ASSERT_TRUE(path_counts.Count(*node) <= path_counts.MaxCount());
+      }
+      const auto& max_node = path_counts.MaxNode();
+      bootstrapped.insert(max_node.get());
+      path_counts.Bootstrap(*max_node);
+      boot_count++;
+    }
+    EXPECT_GT(boot_count, 0);
+    for (const auto& [node, count] : ReferenceCounts(dag, bootstrapped)) {
+      EXPECT_TRUE(count == 0);
+    }
+  }
+}
+
+TEST(LevelPathCountsTest, Saturates) {
+  // Every layer doubles the number of paths
+  Dag<CtOp> dag;
+  auto input = dag.AddNode(
+      std::make_unique<InputC>(TestLevelInfo(), IoSpec("in0", 0)), {});
+  std::vector<std::shared_ptr<Node<CtOp>>> layer = {
+      dag.AddNode(std::make_unique<RescaleC>(TestLevelInfo()), {input})};
+  for (int idx : Estd::indices(200)) {
+    (void)idx;
+    layer = {dag.AddNode(std::make_unique<AddCC>(TestLevelInfo()), layer),
+             dag.AddNode(std::make_unique<MulCC>(TestLevelInfo()), layer)};
+  }
+  auto last = dag.AddNode(std::make_unique<AddCC>(TestLevelInfo()), layer);
+  for (int idx : Estd::indices(kUsableLevels.value())) {
+    (void)idx;
+    last = dag.AddNode(std::make_unique<RescaleC>(TestLevelInfo()), {last});
+  }
+
+  LevelPathCounts path_counts(dag, kUsableLevels);
+  EXPECT_TRUE(path_counts.MaxCount() ==
+              std::numeric_limits<PathCount>::max());
+}
@@ -0,0 +1,136 @@
+/** $lic$
+ * Copyright (C) 2023-2024 by Massachusetts Institute of Technology
+ *
+ * This file is part of the Fhelipe compiler.
+ *
+ * Fhelipe is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * Fhelipe is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>. 
+ */
+
+#include <filesystem>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "include/compiled_program.h"
+#include "include/ct_program.h"
+#include "include/dag.h"
+#include "include/pass.h"
+#include "include/pass_stats.h"
+#include "include/pass_utils.h"
+#include "include/program.h"
+#include "include/t_op.h"
+#include "include/waterline_rescale.h"
+#include "test/test_constants.h"
+#include "test/test_utils.h"
+
+using namespace fhelipe;
+
+namespace {
+
+// Every kind of pass, in the order Compiler::Compile runs them
+CompiledProgram CompileByHand() {
+  CompiledProgramBuilder builder(nullptr,
+                                 Program(std::filesystem::path("unused")));
+  builder.RecordPassStats(PassName("preprocessor"));
+
+  auto* embrio_dag = builder.RecordPass(PassName("parser"), ParserOutput());
+  builder.RecordPassStats(PassName("embrio_optimizer"), *embrio_dag);
+
+  Dag<TOp> top_dag;
+  MakeOutputNode(top_dag, MakeInputNode(top_dag, RandomLayout(), "in0"),
+                 "out0");
+  auto* laid_out_dag =
+      builder.RecordPass(PassName("layout_pass"), std::move(top_dag));
+  auto* scaled_dag = builder.RecordPass(
+      PassName("rescaling_pass"),
+      WaterlineRescale(kDefaultTestContext).DoPass(*laid_out_dag));
+  builder.RecordPass(PassName("leveling_pass"),
+                     LazyBootstrappingPass(kDefaultTestContext)
+                         .DoPass(*scaled_dag));
+
+  auto ct_program = EmptyCtProgram();
+  MakeOutputChunk(ct_program, MakeInputChunk(ct_program, 0), 0);
+  builder.RecordPass(PassName("ct_op_pass"), std::move(ct_program));
+  return builder.GetCompiledProgram();
+}
+
+std::vector<std::string> JsonLines(const CompiledProgram& compiled_program) {
+  std::stringstream stream;
+  WriteCompileStatsJson(stream, compiled_program.GetPassStats());
+  std::vector<std::string> lines;
+  for (std::string line; std::getline(stream, line);) {
+    lines.push_back(line);
+  }
+  return lines;
+}
+
+}  // namespace
+
+TEST(PassStatsTest, RecordsEveryPassInOrder) {
+  auto compiled_program = CompileByHand();
+  std::vector<std::string> pass_names;
+  std::vector<int> pass_indices;
+  for (const auto& stats : compiled_program.GetPassStats()) {
+    pass_names.push_back(stats.GetPassName().String());
+    pass_indices.push_back(stats.PassIndex());
+  }
+  EXPECT_EQ(pass_names, (std::vector<std::string>{
+                            "preprocessor", "parser", "embrio_optimizer",
+                            "layout_pass", "rescaling_pass", "leveling_pass",
+                            "ct_op_pass"}));
+  EXPECT_EQ(pass_indices, (std::vector<int>{0, 1, 2, 3, 4, 5, 6}));
+}
+
+TEST(PassStatsTest, CountsNodesEdgesAndCtOps) {
+  const auto& pass_stats = CompileByHand().GetPassStats();
+  EXPECT_EQ(pass_stats.at(0).NodeCount(), 0);
+  EXPECT_EQ(pass_stats.at(3).NodeCount(), 2);
+  EXPECT_EQ(pass_stats.at(3).EdgeCount(), 1);
+  EXPECT_TRUE(pass_stats.at(3).CtOpCounts().empty());
+  const auto& ct_op_stats = pass_stats.at(6);
+  EXPECT_EQ(ct_op_stats.NodeCount(), 2);
+  EXPECT_EQ(ct_op_stats.CtOpCounts().size(), 2);
+  EXPECT_EQ(ct_op_stats.KeySwitchCount(), 0);
+  for (const auto& stats : pass_stats) {
+    EXPECT_GE(stats.WallTimeSeconds(), 0);
+    EXPECT_GE(stats.PeakRssDeltaKb(), 0);
+  }
+}
+
+TEST(PassStatsTest, WritesOneJsonObjectPerPass) {
+  auto lines = JsonLines(CompileByHand());
+  ASSERT_EQ(lines.size(), 9);
+  EXPECT_EQ(lines.front(), "[");
+  EXPECT_EQ(lines.back(), "]");
+  for (int idx = 1; idx + 1 < lines.size(); ++idx) {
+    const auto& line = lines.at(idx);
+    EXPECT_EQ(line.find("  {\"pass_idx\": " + std::to_string(idx - 1) +
+                        ", \"pass_name\": "),
+              0)
+        << line;
+    for (const auto* field :
+         {"\"wall_time_s\": ", "\"peak_rss_delta_kb\": ", "\"nodes\": ",
+          "\"edges\": "}) {
+      EXPECT_NE(line.find(field), std::string::npos) << line;
+    }
+    bool is_ct_op_pass = idx + 2 == lines.size();
+    EXPECT_EQ(line.find("\"key_switches\": 0, \"ct_ops\": {") !=
+                  std::string::npos,
+              is_ct_op_pass)
+        << line;
+    EXPECT_EQ(line.back(), is_ct_op_pass ? '}' : ',') << line;
+  }
+  EXPECT_NE(lines.at(1).find("\"pass_name\": \"preprocessor\""),
+            std::string::npos);
+}
@@ -0,0 +1,158 @@
+/** $lic$
+ * Copyright (C) 2023-2024 by Massachusetts Institute of Technology
+ *
+ * This file is part of the Fhelipe compiler.
+ *
+ * Fhelipe is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * Fhelipe is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>. 
+ */
+
+#include <functional>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+#include "include/cleartext.h"
+#include "include/constants.h"
+#include "include/evaluator.h"
+#include "include/io_manager.h"
+#include "include/paterson_stockmeyer_pass.h"
+#include "include/scaled_pt_val.h"
+#include "include/t_add_cc.h"
+#include "include/t_input_c.h"
+#include "include/t_mul_cc.h"
+#include "include/t_mul_csi.h"
+#include "include/t_output_c.h"
+#include "include/tensor_layout.h"
+#include "test/test_constants.h"
+#include "test/test_utils.h"
+
+using namespace fhelipe;
+
+namespace {
+
+// Integer coefficients keep the cleartext results exact under reordering. No
+// constant term: TAddCSI also writes the gaps of the layout.
+const std::vector<PtVal> kCoefficients = {0, 3, 0, -2, 0, 1, 0, 2};
+// The nonzero coefficient of x^4 becomes the constant term of the high half
+const std::vector<PtVal> kEvenCoefficients = {0, 1, 2, -1, 3, 0, 1, 2};
+
+PtVal EvaluatePolynomial(const std::vector<PtVal>& coefficients, PtVal x) {
+  PtVal result = 0;
+  for (PtVal coefficient : Estd::reverse(coefficients)) {
+    result = result * x + coefficient;
+  }
+  return result;
+}
+
+// The TOps that the frontend's poly_eval emits: x^e = x^(e/2) * x^(e - e/2)
+// for each power with a nonzero coefficient, then a chain of scaled terms
+Dag<TOp> CreatePolyEvalTOpDag(const std::vector<PtVal>& coefficients) {
+  auto layout = RandomLayout();
+  LogScale log_scale = kDefaultTestContext.LogScale();
+  Dag<TOp> top_dag;
+  std::map<int, std::shared_ptr<Node<TOp>>> powers = {
+      {1, MakeInputNode(top_dag, layout, "in0")}};
+  std::function<std::shared_ptr<Node<TOp>>(int)> power = [&](int exponent) {
+    if (!powers.contains(exponent)) {
+      powers[exponent] = top_dag.AddNode(
+          std::make_unique<TMulCC>(layout),
+          {power(exponent / 2), power(exponent - exponent / 2)});
+    }
+    return powers.at(exponent);
+  };
+  std::shared_ptr<Node<TOp>> sum;
+  for (int exponent = 1; exponent < coefficients.size(); ++exponent) {
+    if (coefficients[exponent] == 0) {
+      continue;
+    }
+    auto term = top_dag.AddNode(
+        std::make_unique<TMulCSI>(
+            layout, ScaledPtVal(log_scale, coefficients[exponent])),
+        {power(exponent)});
+    sum = sum ? top_dag.AddNode(std::make_unique<TAddCC>(layout), {sum, term})
+              : term;
+  }
+  MakeOutputNode(top_dag, sum, "out0");
+  return top_dag;
+}
+
+int MulCCCount(const Dag<TOp>& top_dag) {
+  return Estd::filter(top_dag.NodesInTopologicalOrder(), [](const auto& node) {
+           return dynamic_cast<const TMulCC*>(&node->Value()) != nullptr;
+         }).size();
+}
+
+// Longest chain of TMulCCs and TMulCSIs
+int MultiplicativeDepth(const Dag<TOp>& top_dag) {
+  std::unordered_map<const Node<TOp>*, int> depths;
+  int result = 0;
+  for (const auto& node : top_dag.NodesInTopologicalOrder()) {
+    int depth = 0;
+    for (const auto& parent : node->Parents()) {
+      depth = std::max(depth, depths[parent.get()]);
+    }
+    const auto& t_op = node->Value();
+    if (dynamic_cast<const TMulCC*>(&t_op) ||
+        dynamic_cast<const TMulCSI*>(&t_op)) {
+      ++depth;
+    }
+    depths[node.get()] = depth;
+    result = std::max(result, depth);
+  }
+  return result;
+}
+
+}  // namespace
+
+std::function<RamDictionary<Tensor<std::optional<PtVal>>>(
+    const Dictionary<Tensor<PtVal>>&)>
+CreatePolyEvalCheck(const std::vector<PtVal>& coefficients) {
+  return [coefficients](const Dictionary<Tensor<PtVal>>& tensor_dict) {
+    RamDictionary<Tensor<std::optional<PtVal>>> result;
+    const auto& input = tensor_dict.At("in0");
+    result.Record("out0", ToOptionalTensor(
+                              {input.GetShape(),
+                               Estd::transform(input.Values(), [&](PtVal x) {
+                                 return EvaluatePolynomial(coefficients, x);
+                               })}));
+    return result;
+  };
+}
+
+TEST(PatersonStockmeyerPassTest, Basic) {
+  DoTest<Cleartext>(
+      [] {
+        return PatersonStockmeyerPass().DoPass(
+            CreatePolyEvalTOpDag(kCoefficients));
+      },
+      CreatePolyEvalCheck(kCoefficients));
+}
+
+TEST(PatersonStockmeyerPassTest, SavesALevel) {
+  auto top_dag = CreatePolyEvalTOpDag(kCoefficients);
+  auto out_dag = PatersonStockmeyerPass().DoPass(top_dag);
+  EXPECT_EQ(MultiplicativeDepth(out_dag), MultiplicativeDepth(top_dag) - 1);
+  EXPECT_LE(MulCCCount(out_dag), MulCCCount(top_dag));
+}
+
+TEST(PatersonStockmeyerPassTest, EvenCoefficientsWithoutConstantTerm) {
+  auto top_dag = CreatePolyEvalTOpDag(kEvenCoefficients);
+  auto out_dag = PatersonStockmeyerPass().DoPass(top_dag);
+  EXPECT_LT(MultiplicativeDepth(out_dag), MultiplicativeDepth(top_dag));
+  DoTest<Cleartext>(
+      [] {
+        return PatersonStockmeyerPass().DoPass(
+            CreatePolyEvalTOpDag(kEvenCoefficients));
+      },
+      CreatePolyEvalCheck(kEvenCoefficients));
+}
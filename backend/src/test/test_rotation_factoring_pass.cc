@@ -0,0 +1,110 @@
+/** $lic$
+ * Copyright (C) 2023-2024 by Massachusetts Institute of Technology
+ *
+ * This file is part of the Fhelipe compiler.
+ *
+ * Fhelipe is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * Fhelipe is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>. 
+ */
+
+#include <memory>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "include/add_cc.h"
+#include "include/chunk_ir.h"
+#include "include/constants.h"
+#include "include/ct_program.h"
+#include "include/mul_cp.h"
+#include "include/rotate_c.h"
+#include "include/rotation_factoring_pass.h"
+#include "test/test_constants.h"
+#include "test/test_utils.h"
+
+using namespace fhelipe;
+
+namespace {
+
+DirectChunkIr RandomMask() {
+  std::vector<PtVal> values(ChunkSize(kDefaultLogChunkSize).value());
+  for (auto& value : values) {
+    value = rand() % 2;
+  }
+  return DirectChunkIr(values);
+}
+
+}  // namespace
+
+TEST(RotationFactoringPassTest, FactorsRotationsOfSummedOperands) {
+  auto ct_program = EmptyCtProgram();
+  auto lhs =
+      ct_program::CreateRotateC(ct_program, MakeInputChunk(ct_program, 0), 5);
+  auto rhs =
+      ct_program::CreateRotateC(ct_program, MakeInputChunk(ct_program, 1), 5);
+  auto sum = ct_program::CreateAddCC(ct_program, lhs, rhs);
+  MakeOutputChunk(ct_program, sum, 0);
+
+  auto factored = RotationFactoringPass().DoPass(ct_program);
+  ASSERT_EQ(NodesOfType<RotateC>(factored).size(), 1);
+  // The replacement nodes stand in for the AddCC
+  EXPECT_EQ(NodesOfType<RotateC>(factored).at(0)->Ancestors(),
+            std::vector<int>{sum->NodeId()});
+  EXPECT_EQ(NodesOfType<AddCC>(factored).at(0)->Ancestors(),
+            std::vector<int>{sum->NodeId()});
+  ExpectSameOutputsOnCleartext(ct_program, factored, 2);
+}
+
+TEST(RotationFactoringPassTest, FactorsPlaintextMultipliesOfOneOperand) {
+  auto ct_program = EmptyCtProgram();
+  auto input = MakeInputChunk(ct_program, 0);
+  auto sum = ct_program::CreateAddCC(
+      ct_program,
+      ct_program::CreateMulCP(ct_program, input, RandomMask(),
+                              kDefaultLogScale),
+      ct_program::CreateMulCP(ct_program, input, RandomMask(),
+                              kDefaultLogScale));
+  MakeOutputChunk(ct_program, sum, 0);
+
+  auto factored = RotationFactoringPass().DoPass(ct_program);
+  ASSERT_EQ(NodesOfType<MulCP>(factored).size(), 1);
+  EXPECT_EQ(NodesOfType<MulCP>(factored).at(0)->Ancestors(),
+            std::vector<int>{sum->NodeId()});
+  ExpectSameOutputsOnCleartext(ct_program, factored, 1);
+}
+
+TEST(RotationFactoringPassTest, KeepsOperandsWithOtherConsumers) {
+  auto ct_program = EmptyCtProgram();
+  auto lhs = MakeInputChunk(ct_program, 0);
+  auto rhs = MakeInputChunk(ct_program, 1);
+  auto lhs_rotated = ct_program::CreateRotateC(ct_program, lhs, 5);
+  MakeOutputChunk(ct_program,
+                  ct_program::CreateAddCC(
+                      ct_program, lhs_rotated,
+                      ct_program::CreateRotateC(ct_program, rhs, 5)),
+                  0);
+  MakeOutputChunk(ct_program, lhs_rotated, 1);
+  auto lhs_masked =
+      ct_program::CreateMulCP(ct_program, lhs, RandomMask(), kDefaultLogScale);
+  MakeOutputChunk(
+      ct_program,
+      ct_program::CreateAddCC(ct_program, lhs_masked,
+                              ct_program::CreateMulCP(ct_program, lhs,
+                                                      RandomMask(),
+                                                      kDefaultLogScale)),
+      2);
+  MakeOutputChunk(ct_program, lhs_masked, 3);
+
+  auto factored = RotationFactoringPass().DoPass(ct_program);
+  ASSERT_EQ(NodesOfType<RotateC>(factored).size(), 2);
+  ASSERT_EQ(NodesOfType<MulCP>(factored).size(), 2);
+  ExpectSameOutputsOnCleartext(ct_program, factored, 2);
+}
@@ -0,0 +1,91 @@
+/** $lic$
+ * Copyright (C) 2023-2024 by Massachusetts Institute of Technology
+ *
+ * This file is part of the Fhelipe compiler.
+ *
+ * Fhelipe is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * Fhelipe is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>. 
+ */
+
+#include <memory>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "include/constants.h"
+#include "include/ct_program.h"
+#include "include/level_info.h"
+#include "include/mul_cp.h"
+#include "include/rescale_c.h"
+#include "include/rotate_c.h"
+#include "include/rotation_sinking_pass.h"
+#include "test/test_constants.h"
+#include "test/test_utils.h"
+
+using namespace fhelipe;
+
+namespace {
+
+using CtNode = std::shared_ptr<Node<CtOp>>;
+
+DirectChunkIr AllOnesMask() {
+  return DirectChunkIr(
+      std::vector<PtVal>(ChunkSize(kDefaultLogChunkSize).value(), 1));
+}
+
+// One level below the inputs, at the default scale
+LevelInfo RescaledLevelInfo() {
+  return {kDefaultTestContext.UsableLevels().value() - 1, kDefaultLogScale};
+}
+
+// input -> MulCP -> RotateC -> RescaleC, with the rotation at twice the
+// default scale
+CtNode RotateThenRescale(ct_program::CtProgram& ct_program) {
+  auto product = ct_program::CreateMulCP(
+      ct_program, MakeInputChunk(ct_program, 0), AllOnesMask(),
+      kDefaultLogScale);
+  auto rotated = ct_program::CreateRotateC(ct_program, product, 3);
+  return ct_program::CreateRescaleC(ct_program, RescaledLevelInfo(), rotated);
+}
+
+}  // namespace
+
+TEST(RotationSinkingPassTest, SwapsRotationAndRescale) {
+  auto ct_program = EmptyCtProgram();
+  MakeOutputChunk(ct_program, RotateThenRescale(ct_program), 0);
+
+  auto sunk = RotationSinkingPass().DoPass(ct_program);
+  ASSERT_EQ(NodesOfType<RotateC>(sunk).size(), 1);
+  ASSERT_EQ(NodesOfType<RescaleC>(sunk).size(), 1);
+  auto rotate = NodesOfType<RotateC>(sunk).at(0);
+  auto rescale = NodesOfType<RescaleC>(sunk).at(0);
+  ASSERT_EQ(rotate->Parents(), std::vector<CtNode>{rescale});
+  ASSERT_TRUE(dynamic_cast<const MulCP*>(&rescale->Parents().at(0)->Value()));
+  EXPECT_EQ(rotate->Value().GetLevelInfo(), RescaledLevelInfo());
+  EXPECT_EQ(rescale->Value().GetLevelInfo(), RescaledLevelInfo());
+  ExpectSameOutputsOnCleartext(ct_program, sunk, 1);
+}
+
+TEST(RotationSinkingPassTest, KeepsRotationsWithOtherConsumers) {
+  auto ct_program = EmptyCtProgram();
+  auto rescale = RotateThenRescale(ct_program);
+  MakeOutputChunk(ct_program, rescale, 0);
+  MakeOutputChunk(ct_program, rescale->Parents().at(0), 1);
+
+  auto sunk = RotationSinkingPass().DoPass(ct_program);
+  ASSERT_EQ(NodesOfType<RotateC>(sunk).size(), 1);
+  auto rotate = NodesOfType<RotateC>(sunk).at(0);
+  ASSERT_TRUE(dynamic_cast<const MulCP*>(&rotate->Parents().at(0)->Value()));
+  EXPECT_EQ(rotate->Value().GetLevelInfo(),
+            LevelInfo(kDefaultTestContext.UsableLevels(),
+                      2 * kDefaultLogScale));
+  ExpectSameOutputsOnCleartext(ct_program, sunk, 1);
+}
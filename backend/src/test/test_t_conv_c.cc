@@ -0,0 +1,88 @@
+/** $lic$
+ * Copyright (C) 2023-2024 by Massachusetts Institute of Technology
+ *
+ * This file is part of the Fhelipe compiler.
+ *
+ * Fhelipe is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * Fhelipe is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>. 
+ */
+
+#include "include/cleartext.h"
+#include "include/constants.h"
+#include "include/evaluator.h"
+#include "include/io_manager.h"
+#include "include/t_conv_c.h"
+#include "include/t_input_c.h"
+#include "include/t_output_c.h"
+#include "include/tensor_index.h"
+#include "include/tensor_layout.h"
+#include "test/test_utils.h"
+
+using namespace fhelipe;
+
+namespace {
+
+constexpr int kTapCount = 3;
+
+std::vector<DiffTensorIndex> shifts;
+
+std::string WeightName(int tap) { return "w" + std::to_string(tap); }
+
+}  // namespace
+
+RamDictionary<Tensor<std::optional<PtVal>>> CreateConvCCheck(
+    const Dictionary<Tensor<PtVal>>& tensor_dict) {
+  RamDictionary<Tensor<std::optional<PtVal>>> result;
+  const auto& input = tensor_dict.At("in0");
+  Shape shape = input.GetShape();
+  std::vector<PtVal> sum(shape.ValueCnt());
+  for (int tap : Estd::indices(kTapCount)) {
+    const auto& weights = tensor_dict.At(WeightName(tap));
+    for (int flat_idx : Estd::indices(shape.ValueCnt())) {
+      auto src = TensorIndex(shape, flat_idx);
+      auto dest = shifts[tap].NonCyclicAdd(src);
+      if (dest.has_value()) {
+        sum[dest->Flat()] += input[src] * weights[dest.value()];
+      }
+    }
+  }
+  result.Record("out0", ToOptionalTensor({shape, sum}));
+  return result;
+}
+
+Dag<TOp> CreateConvCTOpDag() {
+  auto input_layout = RandomLayout();
+  Dag<TOp> top_dag;
+  const auto& a = MakeInputNode(top_dag, input_layout, "in0");
+  shifts.clear();
+  std::vector<std::string> names;
+  for (int tap : Estd::indices(kTapCount)) {
+    shifts.push_back(RandomDiffTensorIndex(input_layout.GetShape()));
+    names.push_back(WeightName(tap));
+  }
+  const auto& conv = top_dag.AddNode(
+      std::make_unique<TConvC>(input_layout, shifts, names, LogScale(50)), {a});
+  MakeOutputNode(top_dag, conv, "out0");
+  return top_dag;
+}
+
+TEST(TConvCTest, Basic) {
+  DoTest<Cleartext>(CreateConvCTOpDag, CreateConvCCheck);
+}
+
+TEST(TConvCTest, SharesRotationsAcrossTaps) {
+  auto layout = RandomLayout();
+  auto shift = RandomDiffTensorIndex(layout.GetShape());
+  auto single = TConvC(layout, {shift}, {"w0"}, LogScale(50));
+  auto repeated = TConvC(layout, {shift, shift}, {"w0", "w1"}, LogScale(50));
+  EXPECT_EQ(single.RotationCount(), repeated.RotationCount());
+}
@@ -19,7 +19,9 @@
 #include "include/cleartext.h"
 #include "include/constants.h"
 #include "include/dictionary.h"
+#include "include/dimension_bit.h"
 #include "include/evaluator.h"
+#include "include/extended_std.h"
 #include "include/io_manager.h"
 #include "include/laid_out_tensor.h"
 #include "include/laid_out_tensor_dictionary.h"
@@ -29,6 +31,7 @@
 #include "include/plaintext_chunk.h"
 #include "include/ram_dictionary.h"
 #include "include/shape.h"
+#include "include/t_add_csi.h"
 #include "include/t_layout_conversion_c.h"
 #include "include/tensor_index.h"
 #include "include/tensor_layout.h"
@@ -60,3 +63,63 @@ TEST(TLayoutConversionCTest, Basic) {
   DoTest<Cleartext>(CreateTLayoutConversionCTOpDag,
                     CreateTLayoutConversionCCheck);
 }
+
+namespace {
+
+// Every slot of both chunks holds a tensor element
+TensorLayout FullLayout() {
+  return {Shape({4, 4}),
+          {DimensionBit(0, 0), DimensionBit(0, 1), DimensionBit(1, 0)}};
+}
+
+// Slots 2, 3, 6 and 7 of the only chunk are outside the layout
+TensorLayout LayoutWithGaps() {
+  return {Shape({4}), {DimensionBit(0, 0), std::nullopt, DimensionBit(0, 1)}};
+}
+
+const PtVal kAddedScalar = 3;
+
+// TAddCSI also writes the slots outside the layout, so the conversion has to
+// clear them again
+Dag<TOp> CreateAddScalarThenIdentityTOpDag() {
+  Dag<TOp> top_dag;
+  auto layout = LayoutWithGaps();
+  const auto& input = MakeInputNode(top_dag, layout, "in0");
+  const auto& add = top_dag.AddNode(
+      std::make_unique<TAddCSI>(
+          layout, ScaledPtVal(kDefaultTestContext.LogScale(), kAddedScalar)),
+      {input});
+  const auto& node = top_dag.AddNode(
+      std::make_unique<TLayoutConversionC>(layout, layout), {add});
+  MakeOutputNode(top_dag, node, "out0");
+  return top_dag;
+}
+
+RamDictionary<Tensor<std::optional<PtVal>>> CreateAddScalarThenIdentityCheck(
+    const Dictionary<Tensor<PtVal>>& tensor_dict) {
+  const auto& input = tensor_dict.At("in0");
+  RamDictionary<Tensor<std::optional<PtVal>>> result;
+  result.Record("out0", ToOptionalTensor(
+                            {input.GetShape(),
+                             Estd::transform(input.Values(), [](PtVal value) {
+                               return value + kAddedScalar;
+                             })}));
+  return result;
+}
+
+}  // namespace
+
+TEST(TLayoutConversionCTest, IdentityNeedsNoMask) {
+  auto layout = FullLayout();
+  EXPECT_EQ(TLayoutConversionC(layout, layout).BackendMaskDepth(), 0);
+}
+
+TEST(TLayoutConversionCTest, IdentityWithGapsKeepsMask) {
+  auto layout = LayoutWithGaps();
+  EXPECT_EQ(TLayoutConversionC(layout, layout).BackendMaskDepth(), 1);
+}
+
+TEST(TLayoutConversionCTest, ClearsSlotsWrittenByAddScalar) {
+  DoTest<Cleartext>(CreateAddScalarThenIdentityTOpDag,
+                    CreateAddScalarThenIdentityCheck);
+}
@@ -0,0 +1,87 @@
+/** $lic$
+ * Copyright (C) 2023-2024 by Massachusetts Institute of Technology
+ *
+ * This file is part of the Fhelipe compiler.
+ *
+ * Fhelipe is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * Fhelipe is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>. 
+ */
+
+#include "include/cleartext.h"
+#include "include/constants.h"
+#include "include/evaluator.h"
+#include "include/fill_gaps_layout_pass.h"
+#include "include/io_manager.h"
+#include "include/layout_utils.h"
+#include "include/shape.h"
+#include "include/t_input_c.h"
+#include "include/t_mat_vec_c.h"
+#include "include/t_output_c.h"
+#include "include/tensor_index.h"
+#include "include/tensor_layout.h"
+#include "test/test_constants.h"
+#include "test/test_utils.h"
+
+using namespace fhelipe;
+
+namespace {
+
+constexpr int kMaxRows = 16;
+
+}  // namespace
+
+RamDictionary<Tensor<std::optional<PtVal>>> CreateMatVecCCheck(
+    const Dictionary<Tensor<PtVal>>& tensor_dict) {
+  RamDictionary<Tensor<std::optional<PtVal>>> result;
+  const auto& input = tensor_dict.At("in0");
+  const auto& weights = tensor_dict.At("w");
+  const int rows = weights.GetShape()[0];
+  const int row_size = input.GetShape().ValueCnt();
+  std::vector<PtVal> product(rows);
+  for (int row : Estd::indices(rows)) {
+    for (int col : Estd::indices(row_size)) {
+      product[row] +=
+          weights[TensorIndex(weights.GetShape(), row * row_size + col)] *
+          input[TensorIndex(input.GetShape(), col)];
+    }
+  }
+  result.Record("out0", ToOptionalTensor({Shape({rows}), product}));
+  return result;
+}
+
+Dag<TOp> CreateMatVecCTOpDag() {
+  auto input_layout = RandomLayout(RandomShape(1 + rand() % 2));
+  auto output_layout =
+      RandomLayout(Shape({1 + rand() % kMaxRows}), input_layout.ChunkSize());
+  Dag<TOp> top_dag;
+  const auto& a = MakeInputNode(top_dag, input_layout, "in0");
+  const auto& mat_vec = top_dag.AddNode(
+      std::make_unique<TMatVecC>(input_layout, output_layout, "w",
+                                 LogScale(50)),
+      {a});
+  MakeOutputNode(top_dag, mat_vec, "out0");
+  return top_dag;
+}
+
+TEST(TMatVecCTest, Basic) {
+  DoTest<Cleartext>(CreateMatVecCTOpDag, CreateMatVecCCheck);
+}
+
+TEST(TMatVecCTest, BabyStepGiantStepBeatsOneRotationPerDiagonal) {
+  ChunkSize chunk_size(1 << 10);
+  Shape shape({256});
+  auto layout_bits = FillGapsLayoutPass::DefaultLayoutBits(shape);
+  auto layout = TensorLayout(shape, ChunkBits(layout_bits, chunk_size));
+  auto t_mat_vec_c = TMatVecC(layout, layout, "w", LogScale(50));
+  // 511 diagonals, so about 2 * sqrt(511) rotations
+  EXPECT_LE(t_mat_vec_c.RotationCount(), 2 * 32);
+}
@@ -0,0 +1,90 @@
+/** $lic$
+ * Copyright (C) 2023-2024 by Massachusetts Institute of Technology
+ *
+ * This file is part of the Fhelipe compiler.
+ *
+ * Fhelipe is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * Fhelipe is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>. 
+ */
+
+#include "include/cleartext.h"
+#include "include/constants.h"
+#include "include/evaluator.h"
+#include "include/io_manager.h"
+#include "include/merge_mul_chains_pass.h"
+#include "include/t_input_c.h"
+#include "include/t_merged_mul_chain_cp.h"
+#include "include/t_mul_cp.h"
+#include "include/t_output_c.h"
+#include "include/tensor_layout.h"
+#include "test/test_utils.h"
+
+using namespace fhelipe;
+
+namespace {
+
+constexpr PtVal kScalar = 0.5;
+
+}  // namespace
+
+RamDictionary<Tensor<std::optional<PtVal>>> CreateMergedMulChainCPCheck(
+    const Dictionary<Tensor<PtVal>>& tensor_dict) {
+  RamDictionary<Tensor<std::optional<PtVal>>> result;
+  const auto& input = tensor_dict.At("in0");
+  auto product = Estd::transform(
+      input.Values(), tensor_dict.At("tensor0").Values(), std::multiplies<>());
+  product = Estd::transform(
+      product, tensor_dict.At("tensor1").Values(),
+      [](PtVal lhs, PtVal rhs) { return lhs * rhs * kScalar; });
+  result.Record("out0", ToOptionalTensor({input.GetShape(), product}));
+  return result;
+}
+
+Dag<TOp> CreateMergedMulChainCPTOpDag() {
+  auto input_layout = RandomLayout();
+  Dag<TOp> top_dag;
+  const auto& a = MakeInputNode(top_dag, input_layout, "in0");
+  const auto& merged = top_dag.AddNode(
+      std::make_unique<TMergedMulChainCP>(
+          input_layout, std::vector<std::string>{"tensor0", "tensor1"},
+          kScalar, LogScale(50)),
+      {a});
+  MakeOutputNode(top_dag, merged, "out0");
+  return top_dag;
+}
+
+TEST(TMergedMulChainCPTest, Basic) {
+  DoTest<Cleartext>(CreateMergedMulChainCPTOpDag, CreateMergedMulChainCPCheck);
+}
+
+// The merged TOp keeps the ancestor of the node it replaces, so that it is
+// ordered after its parents by NodesInAncestorIdOrder()
+TEST(TMergedMulChainCPTest, MergingKeepsAncestors) {
+  auto layout = RandomLayout();
+  Dag<TOp> top_dag;
+  auto first = top_dag.AddNode(
+      std::make_unique<TMulCP>(layout, "tensor0", LogScale(50)),
+      {MakeInputNode(top_dag, layout, "in0")});
+  auto second = top_dag.AddNode(
+      std::make_unique<TMulCP>(layout, "tensor1", LogScale(50)), {first});
+  MakeOutputNode(top_dag, second, "out0");
+
+  auto out_dag = MergeMulChainsPass().DoPass(top_dag);
+  int merged_count = 0;
+  for (const auto& node : out_dag.NodesInTopologicalOrder()) {
+    if (dynamic_cast<const TMergedMulChainCP*>(&node->Value())) {
+      ++merged_count;
+      EXPECT_EQ(node->Ancestors(), std::vector<int>{second->NodeId()});
+    }
+  }
+  EXPECT_EQ(merged_count, 1);
+}
@@ -20,6 +20,7 @@
 #include "include/cleartext.h"
 #include "include/constants.h"
 #include "include/dictionary.h"
+#include "include/dimension_bit.h"
 #include "include/evaluator.h"
 #include "include/io_manager.h"
 #include "include/laid_out_tensor.h"
@@ -64,6 +65,36 @@ RamDictionary<Tensor<std::optional<PtVal>>> CreateUnpaddedShiftCCheck(
   return result;
 }
 
+// Chunk 0 holds elements 0-3; chunk 1 holds 4 and 5 and two invalid slots
+TensorLayout PartiallyFilledLayout() {
+  return {Shape({6}), {DimensionBit(0, 0), DimensionBit(0, 1)}};
+}
+
+// Moves chunk 1 onto chunk 0 and drops chunk 0, so the only translation's
+// mask is all-zero on chunk 0
+DiffTensorIndex ShiftDownByAChunk() {
+  return {Shape({6}), Array(std::vector<int>{-4})};
+}
+
+Dag<TOp> CreateShiftDownByAChunkTOpDag() {
+  Dag<TOp> top_dag;
+  const auto& a = MakeInputNode(top_dag, PartiallyFilledLayout(), "in0");
+  const auto& node = top_dag.AddNode(
+      std::make_unique<TUnpaddedShiftC>(PartiallyFilledLayout(),
+                                        ShiftDownByAChunk()),
+      {a});
+  MakeOutputNode(top_dag, node, "out0");
+  return top_dag;
+}
+
+RamDictionary<Tensor<std::optional<PtVal>>> CreateShiftDownByAChunkCheck(
+    const Dictionary<Tensor<PtVal>>& tensor_dict) {
+  RamDictionary<Tensor<std::optional<PtVal>>> result;
+  result.Record("out0",
+                ComputeShifted(tensor_dict.At("in0"), ShiftDownByAChunk()));
+  return result;
+}
+
 }  // namespace
 
 Dag<TOp> CreateUnpaddedShiftCTOpDag() {
@@ -80,3 +111,15 @@ Dag<TOp> CreateUnpaddedShiftCTOpDag() {
 TEST(TUnpaddedShiftCTest, Basic) {
   DoTest<Cleartext>(CreateUnpaddedShiftCTOpDag, CreateUnpaddedShiftCCheck);
 }
+
+// Each mask chunk has to be checked against the slots of its own chunk, even
+// after an all-zero mask chunk: chunk 1 has no valid slot outside its mask,
+// but chunk 0 does
+TEST(TUnpaddedShiftCTest, MaskDepthSkipsAllZeroChunks) {
+  EXPECT_EQ(
+      TUnpaddedShiftC(PartiallyFilledLayout(), ShiftDownByAChunk())
+          .BackendMaskDepth(),
+      0);
+  DoTest<Cleartext>(CreateShiftDownByAChunkTOpDag,
+                    CreateShiftDownByAChunkCheck);
+}
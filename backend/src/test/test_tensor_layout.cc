@@ -0,0 +1,108 @@
+/** $lic$
+ * Copyright (C) 2023-2024 by Massachusetts Institute of Technology
+ *
+ * This file is part of the Fhelipe compiler.
+ *
+ * Fhelipe is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * Fhelipe is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>. 
+ */
+
+#include <optional>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "include/packer.h"
+#include "include/plaintext.h"
+#include "include/tensor_index.h"
+#include "include/tensor_layout.h"
+#include "include/utils.h"
+#include "test/test_utils.h"
+
+using namespace fhelipe;
+
+TEST(TensorLayoutTest, FlatTensorIndicesCoverTensorOnce) {
+  for (int iter = 0; iter < 10; ++iter) {
+    auto layout = RandomLayout();
+    const auto& shape = layout.GetShape();
+    std::vector<int> times_seen(shape.ValueCnt(), 0);
+    const auto& offsets = layout.ChunkOffsets();
+    for (int chunk_number : Estd::indices(offsets.size())) {
+      auto flat_indices = layout.FlatTensorIndices(offsets.at(chunk_number));
+      auto tensor_indices = layout.TensorIndices(offsets.at(chunk_number));
+      ASSERT_EQ(flat_indices.size(), layout.ChunkSize().value());
+      for (int slot : Estd::indices(flat_indices.size())) {
+        ASSERT_EQ(flat_indices.at(slot).has_value(),
+                  tensor_indices.at(slot).has_value());
+        if (!flat_indices.at(slot).has_value()) {
+          continue;
+        }
+        TensorIndex ti(shape, flat_indices.at(slot).value());
+        ASSERT_EQ(tensor_indices.at(slot).value().Flat(), ti.Flat());
+        ASSERT_EQ(layout.ChunkNumberAt(ti), chunk_number);
+        ASSERT_EQ(layout.ChunkIndexAt(ti), slot);
+        ASSERT_EQ(layout.ChunkOffsetAt(ti), offsets.at(chunk_number));
+        ++times_seen.at(ti.Flat());
+      }
+    }
+    for (int count : times_seen) {
+      ASSERT_EQ(count, 1);
+    }
+  }
+}
+
+TEST(TensorLayoutTest, PackUnpackRoundTrip) {
+  auto layout = RandomLayout();
+  std::vector<PtVal> values(layout.GetShape().ValueCnt());
+  for (int idx : Estd::indices(values.size())) {
+    values.at(idx) = idx + 1;
+  }
+  ASSERT_EQ(Unpack(Pack(values, layout)).Values(), values);
+}
+
+TEST(TensorLayoutTest, ConcurrentLookupsAgree) {
+  constexpr int kThreadCount = 8;
+  for (int iter = 0; iter < 10; ++iter) {
+    auto layout = RandomLayout();
+    const auto& shape = layout.GetShape();
+    std::vector<std::vector<int>> chunk_numbers(kThreadCount);
+    ParallelFor(kThreadCount, kThreadCount, [&](int thread) {
+      // Every thread starts from its own copy without cached tables
+      auto copy = TensorLayout(shape, layout.Bits());
+      for (int flat : Estd::indices(shape.ValueCnt())) {
+        chunk_numbers.at(thread).push_back(
+            copy.ChunkNumberAt(TensorIndex(shape, flat)));
+      }
+    });
+    for (const auto& numbers : chunk_numbers) {
+      ASSERT_EQ(numbers, chunk_numbers.front());
+    }
+  }
+}
+
+TEST(TensorLayoutTest, ConcurrentChunkOffsetsAndIndicesAgree) {
+  constexpr int kThreadCount = 8;
+  for (int iter = 0; iter < 10; ++iter) {
+    auto layout = RandomLayout();
+    std::vector<std::vector<MaybeTensorIndex>> indices(kThreadCount);
+    ParallelFor(kThreadCount, kThreadCount, [&](int thread) {
+      for (const auto& offset : layout.ChunkOffsets()) {
+        auto chunk_indices = layout.TensorIndices(offset);
+        indices.at(thread).insert(indices.at(thread).end(),
+                                  chunk_indices.begin(), chunk_indices.end());
+      }
+    });
+    for (const auto& thread_indices : indices) {
+      ASSERT_EQ(thread_indices, indices.front());
+    }
+  }
+}
@@ -0,0 +1,168 @@
+/** $lic$
+ * Copyright (C) 2023-2024 by Massachusetts Institute of Technology
+ *
+ * This file is part of the Fhelipe compiler.
+ *
+ * Fhelipe is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * Fhelipe is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>. 
+ */
+
+#include <map>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "include/array.h"
+#include "include/chunk_ir.h"
+#include "include/laid_out_tensor_index.h"
+#include "include/shape.h"
+#include "include/tensor_index.h"
+#include "include/tensor_layout.h"
+#include "include/translation_mask_utils.h"
+#include "test/test_utils.h"
+
+using namespace fhelipe;
+
+namespace {
+
+using SrcToDestFunc =
+    std::function<std::optional<TensorIndex>(const TensorIndex&)>;
+
+// (chunk number diff, chunk index diff) -> chunk number -> chunk indices
+using ReferenceMasks =
+    std::map<std::pair<int, int>, std::map<int, std::set<int>>>;
+
+ReferenceMasks ComputeReferenceMasks(const TensorLayout& input_layout,
+                                     const TensorLayout& output_layout,
+                                     const SrcToDestFunc& src_to_dest_func) {
+  ReferenceMasks result;
+  const Shape& shape = input_layout.GetShape();
+  for (int flat_idx : Estd::indices(shape.ValueCnt())) {
+    TensorIndex src_ti(shape, flat_idx);
+    auto dest_ti = src_to_dest_func(src_ti);
+    if (!dest_ti.has_value()) {
+      continue;
+    }
+    auto src = LaidOutTensorIndex(input_layout, src_ti);
+    auto dest = LaidOutTensorIndex(output_layout, dest_ti.value());
+    auto translation = TranslationSrcDest(src, dest);
+    result[{translation.ChunkNumberDiff(), translation.ChunkIndexDiff()}]
+          [src.ChunkNumber()]
+              .insert(src.ChunkIndex());
+  }
+  return result;
+}
+
+void CheckMasks(const TensorLayout& input_layout,
+                const TensorLayout& output_layout,
+                const SrcToDestFunc& src_to_dest_func,
+                const std::vector<TranslationMask>& masks) {
+  auto reference =
+      ComputeReferenceMasks(input_layout, output_layout, src_to_dest_func);
+  ASSERT_EQ(masks.size(), reference.size());
+  for (const auto& [translation, mask] : masks) {
+    auto key = std::make_pair(translation.ChunkNumberDiff(),
+                              translation.ChunkIndexDiff());
+    ASSERT_TRUE(reference.contains(key));
+    const auto& expected = reference.at(key);
+    ASSERT_EQ(mask.Chunks().size(), input_layout.TotalChunks());
+    for (int chunk_number : Estd::indices(mask.Chunks().size())) {
+      const ChunkIr& chunk = mask.Chunks().at(chunk_number).Chunk();
+      if (!expected.contains(chunk_number)) {
+        ASSERT_TRUE(std::holds_alternative<ZeroChunkIr>(chunk));
+        continue;
+      }
+      const auto& mask = std::get<DirectChunkIr>(chunk);
+      ASSERT_EQ(mask.Size(), input_layout.ChunkSize().value());
+      for (int chunk_index : Estd::indices(mask.Size())) {
+        ASSERT_EQ(mask.IsOne(chunk_index),
+                  expected.at(chunk_number).contains(chunk_index));
+      }
+    }
+  }
+}
+
+void CheckMasks(const TensorLayout& input_layout,
+                const TensorLayout& output_layout,
+                const SrcToDestFunc& src_to_dest_func) {
+  CheckMasks(
+      input_layout, output_layout, src_to_dest_func,
+      MakeTranslationMasks(input_layout, output_layout, src_to_dest_func));
+}
+
+}  // namespace
+
+TEST(TranslationMaskGeneratorTest, Identity) {
+  auto layout = RandomLayout();
+  CheckMasks(layout, layout, [](const TensorIndex& ti) { return ti; });
+}
+
+TEST(TranslationMaskGeneratorTest, LayoutConversion) {
+  auto input_layout = RandomLayout();
+  auto output_layout =
+      RandomLayout(input_layout.GetShape(), input_layout.ChunkSize());
+  CheckMasks(input_layout, output_layout,
+             [](const TensorIndex& ti) { return ti; });
+}
+
+TEST(TranslationMaskGeneratorTest, NonCyclicShift) {
+  auto layout = RandomLayout();
+  auto shift_by = RandomDiffTensorIndex(layout.GetShape());
+  CheckMasks(layout, layout, [&shift_by](const TensorIndex& ti) {
+    return shift_by.NonCyclicAdd(ti);
+  });
+}
+
+TEST(TranslationMaskGeneratorTest, LayoutConversionFromIndexBits) {
+  auto input_layout = RandomLayout();
+  auto output_layout =
+      RandomLayout(input_layout.GetShape(), input_layout.ChunkSize());
+  CheckMasks(input_layout, output_layout,
+             [](const TensorIndex& ti) { return ti; },
+             MakeTranslationMasks(
+                 input_layout, output_layout,
+                 IdentityIndexBitMap(input_layout.GetShape())));
+}
+
+TEST(TranslationMaskGeneratorTest, StrideFromIndexBits) {
+  auto input_layout = RandomLayout();
+  const Shape& input_shape = input_layout.GetShape();
+  std::vector<int> strides;
+  std::vector<int> output_dims;
+  for (int dim : input_shape) {
+    strides.push_back(1 << UniformRandom(0, 3));
+    output_dims.push_back((dim + strides.back() - 1) / strides.back());
+  }
+  auto output_layout =
+      RandomLayout(Shape(Array(output_dims)), input_layout.ChunkSize());
+  auto index_bit_map = StrideIndexBitMap(input_shape, strides);
+  ASSERT_TRUE(index_bit_map.has_value());
+  CheckMasks(
+      input_layout, output_layout,
+      [&](const TensorIndex& ti) -> std::optional<TensorIndex> {
+        std::vector<int> dest(input_shape.DimensionCount());
+        for (int dim : Estd::indices(dest.size())) {
+          if (ti[dim] % strides[dim] != 0) {
+            return std::nullopt;
+          }
+          dest[dim] = ti[dim] / strides[dim];
+        }
+        return TensorIndex(output_layout.GetShape(), Array(dest));
+      },
+      MakeTranslationMasks(input_layout, output_layout,
+                           index_bit_map.value()));
+  ASSERT_FALSE(StrideIndexBitMap(input_shape,
+                                 std::vector<int>(strides.size(), 3))
+                   .has_value());
+}
@@ -27,12 +27,14 @@
 #include <numeric>
 #include <optional>
 #include <random>
+#include <typeinfo>
 
 #include "gtest/gtest.h"
 
 #include "include/array.h"
 #include "include/chunk_size.h"
 #include "include/constants.h"
+#include "include/dp_bootstrapping_pass.h"
 #include "include/extended_std.h"
 #include "include/fill_gaps_layout_pass.h"
 #include "include/layout_utils.h"
@@ -41,7 +43,12 @@
 #include "include/plaintext.h"
 #include "include/ram_dictionary.h"
 #include "include/t_add_cp.h"
+#include "include/t_add_cc.h"
+#include "include/t_conv_c.h"
 #include "include/t_input_c.h"
+#include "include/t_mat_vec_c.h"
+#include "include/t_mul_cc.h"
+#include "include/t_merged_mul_chain_cp.h"
 #include "include/t_mul_cp.h"
 #include "include/t_output_c.h"
 #include "include/utils.h"
@@ -56,6 +63,18 @@ RamDictionary<Shape> GatherFrontendTensors(const Dag<TOp>& top_dag) {
       result.Record(ptr->PtTensorName(), ptr->OutputLayout().GetShape());
     } else if (const auto* ptr = dynamic_cast<const TMulCP*>(&node->Value())) {
       result.Record(ptr->PtTensorName(), ptr->OutputLayout().GetShape());
+    } else if (const auto* ptr =
+                   dynamic_cast<const TMergedMulChainCP*>(&node->Value())) {
+      for (const auto& name : ptr->PtTensorNames()) {
+        result.Record(name, ptr->OutputLayout().GetShape());
+      }
+    } else if (const auto* ptr = dynamic_cast<const TConvC*>(&node->Value())) {
+      for (const auto& name : ptr->PtTensorNames()) {
+        result.Record(name, ptr->OutputLayout().GetShape());
+      }
+    } else if (const auto* ptr =
+                   dynamic_cast<const TMatVecC*>(&node->Value())) {
+      result.Record(ptr->PtTensorName(), ptr->PtTensorShape());
     }
   }
   return result;
@@ -232,3 +251,92 @@ TensorIndex RandomTensorIndex(const Shape& shape) {
   }
   return {shape, indices};
 }
+
+std::map<std::string, std::vector<PtVal>> EvaluateOnCleartext(
+    const ct_program::CtProgram& ct_program,
+    const std::vector<std::vector<PtVal>>& input_chunks) {
+  RamDictionary<Cleartext> ct_inputs;
+  for (int idx : Estd::indices(input_chunks.size())) {
+    ct_inputs.Record(ToFilename(IoSpec("in", idx)),
+                     Encrypt<Cleartext>(PtChunk(input_chunks.at(idx)),
+                                        ct_program.GetProgramContext()));
+  }
+  auto outputs = Evaluator<Cleartext>::Evaluate(
+      IoManager<Cleartext>(ct_inputs, RamDictionary<Tensor<PtVal>>()),
+      ct_program, RamDictionary<Cleartext>());
+  std::map<std::string, std::vector<PtVal>> result;
+  for (const auto& key : outputs->Keys()) {
+    result.emplace(key, outputs->At(key).Decrypt().Values());
+  }
+  return result;
+}
+
+void ExpectSameOutputsOnCleartext(const ct_program::CtProgram& lhs,
+                                  const ct_program::CtProgram& rhs,
+                                  int input_chunk_count) {
+  int chunk_size = ChunkSize(lhs.GetProgramContext().GetLogChunkSize()).value();
+  // Small integers, so that reassociated sums and products stay exact
+  std::vector<std::vector<PtVal>> input_chunks(input_chunk_count);
+  for (auto& chunk : input_chunks) {
+    for (int idx : Estd::indices(chunk_size)) {
+      (void)idx;
+      chunk.push_back(rand() % 17 - 8);
+    }
+  }
+  auto lhs_outputs = EvaluateOnCleartext(lhs, input_chunks);
+  auto rhs_outputs = EvaluateOnCleartext(rhs, input_chunks);
+  ASSERT_EQ(lhs_outputs.size(), rhs_outputs.size());
+  for (const auto& [key, values] : lhs_outputs) {
+    ASSERT_EQ(values, rhs_outputs.at(key)) << key;
+  }
+}
+
+Dag<TOp> CreateDeepResidualTOpDag() {
+  auto layout = RandomLayout();
+  Dag<TOp> top_dag;
+  std::vector<std::shared_ptr<Node<TOp>>> steps = {
+      MakeInputNode(top_dag, layout, "in0")};
+  int step_count = 4 * kDefaultTestContext.UsableLevels().value();
+  for (int idx : Estd::indices(step_count)) {
+    auto square = top_dag.AddNode(std::make_unique<TMulCC>(layout),
+                                  {steps.back(), steps.back()});
+    steps.push_back(idx < 3 ? square
+                            : top_dag.AddNode(std::make_unique<TAddCC>(layout),
+                                              {square, steps.at(idx - 2)}));
+  }
+  MakeOutputNode(top_dag, steps.back(), "out0");
+  return top_dag;
+}
+
+std::vector<std::pair<std::string, int>> Levels(const Dag<LeveledTOp>& dag) {
+  std::vector<std::pair<std::string, int>> result;
+  for (const auto& node : dag.NodesInTopologicalOrder()) {
+    result.emplace_back(typeid(node->Value().GetTOp()).name(),
+                        node->Value().Level().value());
+  }
+  return result;
+}
+
+Dag<LeveledTOp> LevelWithDp(const Dag<TOp>& top_dag, int max_states) {
+  auto scaled_dag = WaterlineRescale(kDefaultTestContext).DoPass(top_dag);
+  return DpBootstrappingPass(kDefaultTestContext, max_states)
+      .DoPass(scaled_dag);
+}
+
+ct_program::CtProgram EmptyCtProgram() {
+  return {kDefaultTestContext, std::make_unique<RamDictionary<ChunkIr>>(),
+          Dag<CtOp>()};
+}
+
+std::shared_ptr<Node<CtOp>> MakeInputChunk(ct_program::CtProgram& ct_program,
+                                           int offset) {
+  return ct_program::CreateInputC(
+      ct_program, {kDefaultTestContext.UsableLevels(), kDefaultLogScale},
+      IoSpec("in", offset));
+}
+
+void MakeOutputChunk(ct_program::CtProgram& ct_program,
+                     const std::shared_ptr<Node<CtOp>>& node, int offset) {
+  ct_program::CreateOutputC(ct_program, node->Value().GetLevelInfo(),
+                            IoSpec("out", offset), node);
+}
@@ -23,9 +23,13 @@
 
 #include <cmath>
 #include <cstdlib>
+#include <map>
+#include <memory>
 #include <numeric>
 #include <random>
+#include <string>
 #include <tuple>
+#include <utility>
 #include <vector>
 
 #include "gtest/gtest.h"
@@ -41,6 +45,7 @@
 #include "include/laid_out_tensor.h"
 #include "include/laid_out_tensor_dictionary.h"
 #include "include/lazy_bootstrapping_pass.h"
+#include "include/leveled_t_op.h"
 #include "include/node.h"
 #include "include/packer.h"
 #include "include/persisted_dictionary.h"
@@ -193,6 +198,56 @@ void VerifyInvalidSlotsAreZero(const fhelipe::LaidOutTensor<fhelipe::PtChunk>& t
 fhelipe::RamDictionary<fhelipe::Tensor<fhelipe::PtVal>> MakeFrontendTensors(
     const fhelipe::Dictionary<fhelipe::Shape>& frontend_tensors);
 
+// A chain of squarings several times deeper than the usable levels, with
+// each step also adding the result from three steps back
+fhelipe::Dag<fhelipe::TOp> CreateDeepResidualTOpDag();
+
+// The TOp type and level of every node in topological order
+std::vector<std::pair<std::string, int>> Levels(
+    const fhelipe::Dag<fhelipe::LeveledTOp>& dag);
+
+// `top_dag` rescaled and leveled by DpBootstrappingPass in
+// kDefaultTestContext
+fhelipe::Dag<fhelipe::LeveledTOp> LevelWithDp(
+    const fhelipe::Dag<fhelipe::TOp>& top_dag, int max_states = 0);
+
+// Evaluates `ct_program` on Cleartext, with IoSpec("in", idx) holding
+// `input_chunks.at(idx)`, and returns the decrypted outputs by file name
+std::map<std::string, std::vector<fhelipe::PtVal>> EvaluateOnCleartext(
+    const fhelipe::ct_program::CtProgram& ct_program,
+    const std::vector<std::vector<fhelipe::PtVal>>& input_chunks);
+
+// Expects both programs to compute the same outputs from the same random
+// inputs (see EvaluateOnCleartext)
+void ExpectSameOutputsOnCleartext(const fhelipe::ct_program::CtProgram& lhs,
+                                  const fhelipe::ct_program::CtProgram& rhs,
+                                  int input_chunk_count);
+
+// Empty CtProgram in kDefaultTestContext that keeps its chunks in memory
+fhelipe::ct_program::CtProgram EmptyCtProgram();
+
+// InputC of IoSpec("in", offset) at the top level and the default scale
+std::shared_ptr<fhelipe::Node<fhelipe::CtOp>> MakeInputChunk(
+    fhelipe::ct_program::CtProgram& ct_program, int offset);
+
+// OutputC of IoSpec("out", offset) at the level info of `node`
+void MakeOutputChunk(fhelipe::ct_program::CtProgram& ct_program,
+                     const std::shared_ptr<fhelipe::Node<fhelipe::CtOp>>& node,
+                     int offset);
+
+// Nodes of `ct_program` whose CtOp is a T, in topological order
+template <class T>
+std::vector<std::shared_ptr<fhelipe::Node<fhelipe::CtOp>>> NodesOfType(
+    const fhelipe::ct_program::CtProgram& ct_program) {
+  std::vector<std::shared_ptr<fhelipe::Node<fhelipe::CtOp>>> result;
+  for (const auto& node : ct_program.NodesInTopologicalOrder()) {
+    if (dynamic_cast<const T*>(&node->Value())) {
+      result.push_back(node);
+    }
+  }
+  return result;
+}
+
 template <class CtType>
 std::pair<fhelipe::RamDictionary<CtType>,
           fhelipe::RamDictionary<fhelipe::Tensor<fhelipe::PtVal>>>
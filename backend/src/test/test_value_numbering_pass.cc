@@ -0,0 +1,114 @@
+/** $lic$
+ * Copyright (C) 2023-2024 by Massachusetts Institute of Technology
+ *
+ * This file is part of the Fhelipe compiler.
+ *
+ * Fhelipe is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * Fhelipe is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>. 
+ */
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "include/constants.h"
+#include "include/dag.h"
+#include "include/dimension_bit.h"
+#include "include/shape.h"
+#include "include/t_add_cc.h"
+#include "include/t_add_cp.h"
+#include "include/t_input_c.h"
+#include "include/t_mul_cc.h"
+#include "include/t_mul_cp.h"
+#include "include/t_op.h"
+#include "include/t_rotate_c.h"
+#include "include/tensor_layout.h"
+#include "include/value_numbering_pass.h"
+#include "test/test_constants.h"
+#include "test/test_utils.h"
+
+using namespace fhelipe;
+
+namespace {
+
+template <class T>
+int CountOf(const Dag<TOp>& top_dag) {
+  int count = 0;
+  for (const auto& node : top_dag.NodesInTopologicalOrder()) {
+    count += dynamic_cast<const T*>(&node->Value()) != nullptr;
+  }
+  return count;
+}
+
+// TRotateC only rotates single-chunk tensors
+TensorLayout SingleChunkLayout() {
+  return {Shape({4}), {DimensionBit(0, 0), DimensionBit(0, 1)}};
+}
+
+void ExpectSameValue(const TOp& lhs, const TOp& rhs) {
+  ASSERT_TRUE(lhs == rhs);
+  EXPECT_EQ(lhs.Hash(), rhs.Hash());
+}
+
+}  // namespace
+
+TEST(ValueNumberingPassTest, MergesCommutedAddCC) {
+  auto layout = RandomLayout();
+  Dag<TOp> top_dag;
+  auto a = MakeInputNode(top_dag, layout, "in0");
+  auto b = MakeInputNode(top_dag, layout, "in1");
+  MakeOutputNode(top_dag,
+                 top_dag.AddNode(std::make_unique<TAddCC>(layout), {a, b}),
+                 "out0");
+  MakeOutputNode(top_dag,
+                 top_dag.AddNode(std::make_unique<TAddCC>(layout), {b, a}),
+                 "out1");
+
+  auto numbered = ValueNumberingPass().DoPass(top_dag);
+  EXPECT_EQ(CountOf<TAddCC>(numbered), 1);
+  EXPECT_EQ(CountOf<TOutputC>(numbered), 2);
+}
+
+TEST(ValueNumberingPassTest, KeepsMulCPWithDifferentWeights) {
+  auto layout = RandomLayout();
+  Dag<TOp> top_dag;
+  auto input = MakeInputNode(top_dag, layout, "in0");
+  for (const auto& weights : {"w0", "w1", "w0"}) {
+    MakeOutputNode(
+        top_dag,
+        top_dag.AddNode(
+            std::make_unique<TMulCP>(layout, weights, kDefaultLogScale),
+            {input}),
+        "out_" + std::to_string(top_dag.NodesInTopologicalOrder().size()));
+  }
+
+  auto numbered = ValueNumberingPass().DoPass(top_dag);
+  EXPECT_EQ(CountOf<TMulCP>(numbered), 2);
+  EXPECT_EQ(CountOf<TOutputC>(numbered), 3);
+}
+
+TEST(ValueNumberingPassTest, EqualTOpsHashEqually) {
+  auto layout = SingleChunkLayout();
+  ExpectSameValue(TAddCC(layout), TAddCC(layout));
+  ExpectSameValue(TMulCC(layout), TMulCC(layout));
+  ExpectSameValue(TMulCP(layout, "w0", kDefaultLogScale),
+                  TMulCP(layout, "w0", kDefaultLogScale));
+  ExpectSameValue(TAddCP(layout, "w0", kDefaultLogScale),
+                  TAddCP(layout, "w0", kDefaultLogScale));
+  ExpectSameValue(TRotateC(layout, 3), TRotateC(layout, 3));
+  ExpectSameValue(TInputC(layout, "in0", kDefaultLogScale),
+                  TInputC(layout, "in0", kDefaultLogScale));
+  EXPECT_FALSE(TMulCP(layout, "w0", kDefaultLogScale) ==
+               TMulCP(layout, "w1", kDefaultLogScale));
+  EXPECT_FALSE(TRotateC(layout, 3) == TRotateC(layout, 4));
+}
@@ -0,0 +1,93 @@
+/** $lic$
+ * Copyright (C) 2023-2024 by Massachusetts Institute of Technology
+ *
+ * This file is part of the Fhelipe compiler.
+ *
+ * Fhelipe is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * Fhelipe is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>. 
+ */
+
+#include <memory>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "include/constants.h"
+#include "include/dag.h"
+#include "include/dimension_bit.h"
+#include "include/program_context.h"
+#include "include/scaled_t_op.h"
+#include "include/shape.h"
+#include "include/t_unpadded_shift_c.h"
+#include "include/tensor_index.h"
+#include "include/tensor_layout.h"
+#include "include/waterline_rescale.h"
+#include "test/test_constants.h"
+#include "test/test_utils.h"
+
+using namespace fhelipe;
+
+namespace {
+
+// Two full chunks of four elements each
+TensorLayout TwoChunkLayout() {
+  return {Shape({8}), {DimensionBit(0, 0), DimensionBit(0, 1)}};
+}
+
+// Moves one element of every chunk into the other chunk, so both
+// translations need a mask
+TUnpaddedShiftC ShiftByOne() {
+  return {TwoChunkLayout(),
+          DiffTensorIndex(Shape({8}), Array(std::vector<int>{1}))};
+}
+
+// kDefaultTestContext, with masks encoded at `mask_log_scale` as with
+// --mask_log_scale
+ProgramContext ContextWithMaskLogScale(int mask_log_scale) {
+  return {kDefaultTestContext.GetLogChunkSize(), kDefaultTestContext.LogScale(),
+          kDefaultTestContext.UsableLevels(),
+          kDefaultTestContext.GetBootstrappingPrecision(), mask_log_scale};
+}
+
+// Log scale WaterlineRescale assigns to the shift, before rescaling it
+LogScale ShiftLogScale(const ProgramContext& context) {
+  Dag<TOp> top_dag;
+  auto input = MakeInputNode(top_dag, TwoChunkLayout(), "in0");
+  MakeOutputNode(
+      top_dag, top_dag.AddNode(std::make_unique<TUnpaddedShiftC>(ShiftByOne()),
+                               {input}),
+      "out0");
+  for (const auto& node :
+       WaterlineRescale(context).DoPass(top_dag).NodesInTopologicalOrder()) {
+    if (dynamic_cast<const TUnpaddedShiftC*>(&node->Value().GetTOp())) {
+      return node->Value().LogScale();
+    }
+  }
+  LOG(FATAL);
+}
+
+}  // namespace
+
+TEST(WaterlineRescaleTest, ChargesMasksAtTheContextScale) {
+  int mask_depth = ShiftByOne().BackendMaskDepth();
+  ASSERT_GT(mask_depth, 0);
+  EXPECT_EQ(ShiftLogScale(kDefaultTestContext).value(),
+            (mask_depth + 1) * kDefaultTestContext.LogScale().value());
+}
+
+TEST(WaterlineRescaleTest, ChargesMasksAtTheMaskLogScale) {
+  int mask_depth = ShiftByOne().BackendMaskDepth();
+  ASSERT_GT(mask_depth, 0);
+  int mask_log_scale = 10;
+  EXPECT_EQ(ShiftLogScale(ContextWithMaskLogScale(mask_log_scale)).value(),
+            kDefaultTestContext.LogScale().value() +
+                mask_depth * mask_log_scale);
+}
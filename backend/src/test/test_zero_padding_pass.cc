@@ -0,0 +1,131 @@
+/** $lic$
+ * Copyright (C) 2023-2024 by Massachusetts Institute of Technology
+ *
+ * This file is part of the Fhelipe compiler.
+ *
+ * Fhelipe is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * Fhelipe is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>. 
+ */
+
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "include/cleartext.h"
+#include "include/dag.h"
+#include "include/dag_io.h"
+#include "include/dictionary.h"
+#include "include/dimension_bit.h"
+#include "include/fill_gaps_layout_pass.h"
+#include "include/ram_dictionary.h"
+#include "include/scaled_pt_val.h"
+#include "include/shape.h"
+#include "include/t_add_csi.h"
+#include "include/t_resize_dim_c.h"
+#include "include/tensor_index.h"
+#include "include/tensor_layout.h"
+#include "include/zero_padding_pass.h"
+#include "test/test_constants.h"
+#include "test/test_utils.h"
+
+using namespace fhelipe;
+
+namespace {
+
+const Shape kInputShape = {5, 3};
+const Shape kOutputShape = {7, 3};
+
+// One chunk of 8 x 4 slots, so that every chunk has padding
+TensorLayout InputLayout() {
+  return TensorLayout(kInputShape,
+                      {DimensionBit(0, 0), DimensionBit(0, 1),
+                       DimensionBit(0, 2), DimensionBit(1, 0),
+                       DimensionBit(1, 1)});
+}
+
+// Grows the input, or the input plus a scalar if `add_scalar`: the grown
+// slots come from the padding of the input
+Dag<TOp> CreateResizeDag(bool add_scalar) {
+  const auto layout = InputLayout();
+  Dag<TOp> top_dag;
+  auto input = MakeInputNode(top_dag, layout, "in0");
+  if (add_scalar) {
+    input = top_dag.AddNode(
+        std::make_unique<TAddCSI>(layout, ScaledPtVal(kDefaultLogScale, 1)),
+        {input});
+  }
+  const auto& resized = top_dag.AddNode(
+      std::make_unique<TResizeDimC>(
+          layout, FillGapsLayoutPass::GetTResizeDimsCOutputLayout(
+                      layout, kOutputShape)),
+      {input});
+  MakeOutputNode(top_dag, resized, "out0");
+  return top_dag;
+}
+
+const TResizeDimC& GetResize(const Dag<TOp>& dag) {
+  for (const auto& node : dag.NodesInTopologicalOrder()) {
+    if (const auto* t_resize_dim_c =
+            dynamic_cast<const TResizeDimC*>(&node->Value())) {
+      return *t_resize_dim_c;
+    }
+  }
+  LOG(FATAL);
+}
+
+RamDictionary<Tensor<std::optional<PtVal>>> CreateResizeCheck(
+    const Dictionary<Tensor<PtVal>>& tensor_dict) {
+  const auto& input = tensor_dict.At("in0");
+  std::vector<PtVal> values(kOutputShape.ValueCnt());
+  for (int flat_idx : Estd::indices(kInputShape.ValueCnt())) {
+    const auto& input_index = TensorIndex(kInputShape, flat_idx);
+    values[TensorIndex(kOutputShape, input_index.DimensionIndices()).Flat()] =
+        input[input_index];
+  }
+  RamDictionary<Tensor<std::optional<PtVal>>> result;
+  result.Record("out0", ToOptionalTensor({kOutputShape, values}));
+  return result;
+}
+
+}  // namespace
+
+TEST(ZeroPaddingPassTest, SkipsMasksOfInputsWithZeroPadding) {
+  auto dag = CreateResizeDag(/*add_scalar=*/false);
+  ASSERT_EQ(GetResize(dag).BackendMaskDepth(), 1);
+
+  auto out_dag = ZeroPaddingPass().DoPass(dag);
+  EXPECT_TRUE(GetResize(out_dag).InputPaddingIsZero());
+  EXPECT_EQ(GetResize(out_dag).BackendMaskDepth(), 0);
+}
+
+TEST(ZeroPaddingPassTest, KeepsMasksAfterScalarAdd) {
+  auto out_dag = ZeroPaddingPass().DoPass(CreateResizeDag(/*add_scalar=*/true));
+  EXPECT_FALSE(GetResize(out_dag).InputPaddingIsZero());
+  EXPECT_EQ(GetResize(out_dag).BackendMaskDepth(), 1);
+}
+
+TEST(ZeroPaddingPassTest, SerializesTheFlag) {
+  auto out_dag =
+      ZeroPaddingPass().DoPass(CreateResizeDag(/*add_scalar=*/false));
+  std::stringstream stream;
+  WriteStream<Dag<TOp>>(stream, out_dag);
+  auto read_dag = ReadStream<Dag<TOp>>(stream);
+  EXPECT_TRUE(GetResize(read_dag).InputPaddingIsZero());
+}
+
+TEST(ZeroPaddingPassTest, ResizeWithoutMasks) {
+  DoTest<Cleartext>(
+      [] { return ZeroPaddingPass().DoPass(CreateResizeDag(false)); },
+      CreateResizeCheck);
+}
@@ -27,28 +27,20 @@
 namespace fhelipe {
 
 LaidOutTensor<ChunkIr> TranslationMaskGenerator::GetMask(
-    const LaidOutTensorTranslation& diff) const {
-  const auto& nonzeros = diff_map_.at(diff);
-
-  std::unordered_map<TensorIndex, std::vector<PtVal>> result;
-  for (const LaidOutTensorIndex& ti : nonzeros) {
-    auto curr_offset = layout_.ChunkOffsets().at(ti.ChunkNumber());
-    if (!result.contains(curr_offset)) {
-      result.emplace(curr_offset,
-                     std::vector<PtVal>(layout_.ChunkSize().value()));
-    }
-    result.at(curr_offset)[ti.ChunkIndex()] = 1;
-  }
-
+    const MaskBits& mask_bits) const {
   std::vector<LaidOutChunk<ChunkIr>> mask_chunks;
-  for (const auto& offset : layout_.ChunkOffsets()) {
-    if (result.contains(offset)) {
-      mask_chunks.emplace_back(layout_, offset,
-                               DirectChunkIr(result.at(offset)));
-    } else {
-      mask_chunks.emplace_back(layout_, offset,
+  const auto& offsets = layout_.ChunkOffsets();
+  for (int chunk_number = 0; chunk_number < offsets.size(); ++chunk_number) {
+    const auto& words = mask_bits.at(chunk_number);
+    if (words.empty()) {
+      mask_chunks.emplace_back(layout_, offsets[chunk_number],
                                ZeroChunkIr(layout_.ChunkSize()));
+      continue;
     }
+    mask_chunks.emplace_back(
+        layout_, offsets[chunk_number],
+        DirectChunkIr(layout_.ChunkSize().value(),
+                      std::vector<uint64_t>(words)));
   }
   return LaidOutTensor<ChunkIr>{mask_chunks};
 }
@@ -57,14 +49,23 @@ std::vector<TranslationMask> TranslationMaskGenerator::GetTranslationMasks()
     const {
   std::vector<TranslationMask> result;
   for (const auto& [key, value] : diff_map_) {
-    result.emplace_back(key, GetMask(key));
+    result.emplace_back(key, GetMask(value));
   }
   return result;
 }
 
 void TranslationMaskGenerator::RegisterTranslation(
-    const LaidOutTensorTranslation& diff, const LaidOutTensorIndex& ti) {
-  diff_map_[diff].push_back(ti);
+    const LaidOutTensorTranslation& diff, int chunk_number, int chunk_index) {
+  auto& mask_bits = diff_map_[diff];
+  if (mask_bits.empty()) {
+    mask_bits.resize(layout_.TotalChunks());
+  }
+  auto& words = mask_bits.at(chunk_number);
+  if (words.empty()) {
+    words.resize(DirectChunkIr::WordCount(layout_.ChunkSize().value()), 0);
+  }
+  words[chunk_index / DirectChunkIr::kWordBits] |=
+      uint64_t{1} << (chunk_index % DirectChunkIr::kWordBits);
 }
 
 }  // namespace fhelipe
@@ -19,11 +19,15 @@
 #include "include/translation_mask_utils.h"
 
 #include <algorithm>
+#include <bit>
 #include <chrono>
+#include <cstdint>
 #include <iterator>
 #include <memory>
 #include <string>
 #include <type_traits>
+#include <unordered_map>
+#include <variant>
 #include <vector>
 
 #include "include/chunk_ir.h"
@@ -85,11 +89,6 @@ TOp::LaidOutTensorCt ZeroOutWhereZeroMask(ct_program::CtProgram& ct_program,
                 const LaidOutChunk<ChunkIr>& rhs) {
         CHECK(lhs.Offset() == rhs.Offset());
         CHECK(lhs.Layout() == rhs.Layout());
-        // TODO(nsamar): We almost surely do not want the scale
-        // of backend-generated masks to be
-        // ct_program.GetProgramContext().LogScale(). Because a
-        // mask is all 1s and 0s, this scale can be much smaller
-        // and still yield good precision.
         auto chunk = std::holds_alternative<ZeroChunkIr>(rhs.Chunk())
                          ? zero_c
                          : lhs.Chunk();
@@ -102,24 +101,19 @@ TOp::LaidOutTensorCt ZeroOutWhereZeroMask(ct_program::CtProgram& ct_program,
 TOp::LaidOutTensorCt ApplyMask(ct_program::CtProgram& ct_program,
                                const TOp::LaidOutTensorCt& ct,
                                const LaidOutTensor<ChunkIr>& pt) {
+  auto mask_log_scale = ct_program.GetProgramContext().MaskLogScale();
   auto zero_c = ct_program::FetchZeroCThatIsAtSameLevelInfoAsAMulCPChildOf(
-      ct.Chunks().at(0).Chunk(), ct_program.GetProgramContext().LogScale());
+      ct.Chunks().at(0).Chunk(), mask_log_scale);
   auto chunks = Estd::transform(
       ct.Chunks(), pt.Chunks(),
-      [&ct_program, &zero_c](const TOp::LaidOutChunk& lhs,
-                             const LaidOutChunk<ChunkIr>& rhs) {
+      [&ct_program, &zero_c, mask_log_scale](
+          const TOp::LaidOutChunk& lhs, const LaidOutChunk<ChunkIr>& rhs) {
         CHECK(lhs.Offset() == rhs.Offset());
         CHECK(lhs.Layout() == rhs.Layout());
-        // TODO(nsamar): We almost surely do not want the scale
-        // of backend-generated masks to be
-        // ct_program.GetProgramContext().LogScale(). Because a
-        // mask is all 1s and 0s, this scale can be much smaller
-        // and still yield good precision.
         auto chunk = std::holds_alternative<ZeroChunkIr>(rhs.Chunk())
                          ? zero_c
-                         : ct_program::CreateMulCP(
-                               ct_program, lhs.Chunk(), rhs.Chunk(),
-                               ct_program.GetProgramContext().LogScale());
+                         : ct_program::CreateMulCP(ct_program, lhs.Chunk(),
+                                                   rhs.Chunk(), mask_log_scale);
 
         return TOp::LaidOutChunk{lhs.Layout(), lhs.Offset(), chunk};
       });
@@ -206,21 +200,286 @@ std::vector<TOp::LaidOutChunk> ApplyTranslationsButNotMasks(
   return sum;
 }
 
+namespace {
+
+// Multiplying by such a mask cannot change any slot, whatever the slots
+// outside the layout hold: TAddCSI, for one, writes them too. If they are
+// known to hold zero, the mask need only be one on the tensor elements.
+bool MaskIsAllOnes(const LaidOutChunk<ChunkIr>& mask_chunk,
+                   bool input_padding_is_zero) {
+  const auto* direct = std::get_if<DirectChunkIr>(&mask_chunk.Chunk());
+  if (direct == nullptr) {
+    // ZeroChunkIr masks are applied for free by ZeroOutWhereZeroMask
+    return true;
+  }
+  if (input_padding_is_zero) {
+    const auto flat_indices =
+        mask_chunk.Layout().FlatTensorIndices(mask_chunk.Offset());
+    for (int slot = 0; slot < flat_indices.size(); ++slot) {
+      if (flat_indices[slot].has_value() && !direct->IsOne(slot)) {
+        return false;
+      }
+    }
+    return true;
+  }
+  const auto& words = direct->Words();
+  for (int word = 0; word < words.size(); ++word) {
+    const int bits = std::min(DirectChunkIr::kWordBits,
+                              direct->Size() - word * DirectChunkIr::kWordBits);
+    const uint64_t ones = bits == DirectChunkIr::kWordBits
+                              ? ~uint64_t{0}
+                              : (uint64_t{1} << bits) - 1;
+    if (words[word] != ones) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+int TranslationMaskDepth(const std::vector<TranslationMask>& trans_masks,
+                         bool input_padding_is_zero) {
+  for (const auto& [translation, mask_tensor] : trans_masks) {
+    for (const auto& mask_chunk : mask_tensor.Chunks()) {
+      if (!MaskIsAllOnes(mask_chunk, input_padding_is_zero)) {
+        return 1;
+      }
+    }
+  }
+  return 0;
+}
+
+int TranslationMaskDepthCache::Get(
+    const std::function<std::vector<TranslationMask>()>& make_masks) const {
+  if (!depth_.has_value()) {
+    depth_ = TranslationMaskDepth(make_masks(), input_padding_is_zero_);
+  }
+  return depth_.value();
+}
+
+std::vector<TOp::LaidOutChunk> ApplyTranslations(
+    ct_program::CtProgram& ct_program, const TOp::LaidOutTensorCt& input_tensor,
+    const std::vector<TranslationMask>& trans_masks,
+    const TensorLayout& output_layout, bool input_padding_is_zero) {
+  if (TranslationMaskDepth(trans_masks, input_padding_is_zero) > 0) {
+    return ApplyTranslationMasks(ct_program, input_tensor, trans_masks,
+                                 output_layout);
+  }
+  return ApplyTranslationsButNotMasks(ct_program, input_tensor, trans_masks,
+                                      output_layout);
+}
+
 std::vector<TranslationMask> MakeTranslationMasks(
     const TensorLayout& input_layout, const TensorLayout& output_layout,
     const std::function<std::optional<TensorIndex>(const TensorIndex&)>&
         src_to_dest_func) {
+  CHECK(input_layout.ChunkSize() == output_layout.ChunkSize());
+  auto trans_mask_gen = TranslationMaskGenerator(input_layout);
+  const int total_chunks =
+      std::max(input_layout.TotalChunks(), output_layout.TotalChunks());
+  const Shape& shape = input_layout.GetShape();
+  const auto& offsets = input_layout.ChunkOffsets();
+  // Walks the slots of each input chunk, so the source chunk number and index
+  // come for free; only the destination is looked up per element
+  for (int src_chunk_number = 0; src_chunk_number < offsets.size();
+       ++src_chunk_number) {
+    const auto flat_indices =
+        input_layout.FlatTensorIndices(offsets[src_chunk_number]);
+    for (int src_chunk_index = 0; src_chunk_index < flat_indices.size();
+         ++src_chunk_index) {
+      const auto& flat_idx = flat_indices[src_chunk_index];
+      if (!flat_idx.has_value()) {
+        continue;
+      }
+      std::optional<TensorIndex> dest_ti =
+          src_to_dest_func(TensorIndex(shape, flat_idx.value()));
+      if (!dest_ti.has_value()) {
+        continue;
+      }
+      auto translation = LaidOutTensorTranslation(
+          total_chunks, input_layout.ChunkSize(),
+          output_layout.ChunkNumberAt(dest_ti.value()) - src_chunk_number,
+          output_layout.ChunkIndexAt(dest_ti.value()) - src_chunk_index);
+      trans_mask_gen.RegisterTranslation(translation, src_chunk_number,
+                                         src_chunk_index);
+    }
+  }
+  return trans_mask_gen.GetTranslationMasks();
+}
+
+namespace {
+
+// Number of bits that the indices of a dimension of `size` span
+int IndexBitCount(int size) {
+  int bit_count = 0;
+  while ((1 << bit_count) < size) {
+    ++bit_count;
+  }
+  return bit_count;
+}
+
+// Where the set bits of a source index take its element: slot bits and flat
+// chunk offset in the output layout, or nowhere
+struct BitDestination {
+  int chunk_index = 0;
+  int offset_flat = 0;
+  bool dropped = false;
+
+  // The bits of an index are disjoint, so their flat offsets add up
+  BitDestination& operator|=(const BitDestination& other) {
+    chunk_index |= other.chunk_index;
+    offset_flat += other.offset_flat;
+    dropped = dropped || other.dropped;
+    return *this;
+  }
+};
+
+class BitDestinations {
+ public:
+  BitDestinations(const TensorLayout& output_layout,
+                  const IndexBitMap& index_bit_map)
+      : index_bit_map_(index_bit_map) {
+    const Shape& shape = output_layout.GetShape();
+    strides_.resize(shape.DimensionCount());
+    int stride = 1;
+    for (int dim = shape.DimensionCount() - 1; dim >= 0; --dim) {
+      strides_[dim] = stride;
+      stride *= shape[dim];
+    }
+    slot_bits_.resize(shape.DimensionCount());
+    for (int dim = 0; dim < shape.DimensionCount(); ++dim) {
+      slot_bits_[dim].resize(IndexBitCount(shape[dim]), -1);
+    }
+    const auto& bits = output_layout.Bits();
+    for (int slot_bit = 0; slot_bit < bits.size(); ++slot_bit) {
+      if (bits[slot_bit].has_value()) {
+        slot_bits_[bits[slot_bit]->dimension][bits[slot_bit]->bit_index] =
+            slot_bit;
+      }
+    }
+  }
+
+  BitDestination Of(const DimensionBit& source_bit) const {
+    const auto& dest =
+        index_bit_map_.at(source_bit.dimension).at(source_bit.bit_index);
+    if (!dest.has_value()) {
+      return {0, 0, true};
+    }
+    int slot_bit = slot_bits_.at(dest->dimension).at(dest->bit_index);
+    if (slot_bit >= 0) {
+      return {1 << slot_bit, 0, false};
+    }
+    return {0, (1 << dest->bit_index) * strides_[dest->dimension], false};
+  }
+
+  BitDestination Of(const TensorIndex& ti) const {
+    BitDestination result;
+    for (int dim = 0; dim < ti.GetShape().DimensionCount(); ++dim) {
+      for (int bit = 0; (ti[dim] >> bit) != 0; ++bit) {
+        if ((ti[dim] >> bit) & 1) {
+          result |= Of(DimensionBit(dim, bit));
+        }
+      }
+    }
+    return result;
+  }
+
+ private:
+  const IndexBitMap& index_bit_map_;
+  // Row-major strides of the output shape
+  std::vector<int> strides_;
+  // [dim][bit] -> output slot bit holding the index bit, or -1
+  std::vector<std::vector<int>> slot_bits_;
+};
+
+}  // namespace
+
+IndexBitMap IdentityIndexBitMap(const Shape& shape) {
+  IndexBitMap result(shape.DimensionCount());
+  for (int dim = 0; dim < shape.DimensionCount(); ++dim) {
+    for (int bit = 0; bit < IndexBitCount(shape[dim]); ++bit) {
+      result[dim].emplace_back(DimensionBit(dim, bit));
+    }
+  }
+  return result;
+}
+
+std::optional<IndexBitMap> StrideIndexBitMap(const Shape& shape,
+                                             const std::vector<int>& strides) {
+  CHECK(strides.size() == shape.DimensionCount());
+  IndexBitMap result(shape.DimensionCount());
+  for (int dim = 0; dim < shape.DimensionCount(); ++dim) {
+    if (strides[dim] <= 0 || (strides[dim] & (strides[dim] - 1)) != 0) {
+      return std::nullopt;
+    }
+    const int log_stride = IndexBitCount(strides[dim]);
+    for (int bit = 0; bit < IndexBitCount(shape[dim]); ++bit) {
+      result[dim].push_back(
+          bit < log_stride
+              ? std::nullopt
+              : std::make_optional(DimensionBit(dim, bit - log_stride)));
+    }
+  }
+  return result;
+}
+
+std::vector<TranslationMask> MakeTranslationMasks(
+    const TensorLayout& input_layout, const TensorLayout& output_layout,
+    const IndexBitMap& index_bit_map) {
+  CHECK(input_layout.ChunkSize() == output_layout.ChunkSize());
+  CHECK(index_bit_map.size() == input_layout.GetShape().DimensionCount());
+  BitDestinations bit_destinations(output_layout, index_bit_map);
+
+  // Every slot is one slot bit away from a slot with fewer bits set
+  const int chunk_size = input_layout.ChunkSize().value();
+  std::vector<BitDestination> slot_destinations(chunk_size);
+  const auto& input_bits = input_layout.Bits();
+  for (int slot = 1; slot < chunk_size; ++slot) {
+    const int slot_bit = std::countr_zero(static_cast<unsigned>(slot));
+    slot_destinations[slot] = slot_destinations[slot & (slot - 1)];
+    // Slots with a gap bit set hold no element
+    if (input_bits[slot_bit].has_value()) {
+      slot_destinations[slot] |=
+          bit_destinations.Of(input_bits[slot_bit].value());
+    }
+  }
+
+  std::unordered_map<int, int> output_chunk_numbers;
+  const auto& output_offsets = output_layout.ChunkOffsets();
+  for (int chunk_number = 0; chunk_number < output_offsets.size();
+       ++chunk_number) {
+    output_chunk_numbers.emplace(output_offsets[chunk_number].Flat(),
+                                 chunk_number);
+  }
+
   auto trans_mask_gen = TranslationMaskGenerator(input_layout);
-  Shape shape = input_layout.GetShape();
-  for (int flat_idx = 0; flat_idx < shape.ValueCnt(); ++flat_idx) {
-    TensorIndex src_ti = TensorIndex(input_layout.GetShape(), flat_idx);
-    std::optional<TensorIndex> dest_ti = src_to_dest_func(src_ti);
-    if (!dest_ti.has_value()) {
-      continue;
-    }
-    auto src = LaidOutTensorIndex{input_layout, src_ti};
-    auto dest = LaidOutTensorIndex{output_layout, dest_ti.value()};
-    trans_mask_gen.RegisterTranslation(TranslationSrcDest(src, dest), src);
+  const int total_chunks =
+      std::max(input_layout.TotalChunks(), output_layout.TotalChunks());
+  const auto& offsets = input_layout.ChunkOffsets();
+  for (int src_chunk_number = 0; src_chunk_number < offsets.size();
+       ++src_chunk_number) {
+    const auto offset_destination =
+        bit_destinations.Of(offsets[src_chunk_number]);
+    const auto flat_indices =
+        input_layout.FlatTensorIndices(offsets[src_chunk_number]);
+    for (int src_chunk_index = 0; src_chunk_index < flat_indices.size();
+         ++src_chunk_index) {
+      if (!flat_indices[src_chunk_index].has_value()) {
+        continue;
+      }
+      auto dest = offset_destination;
+      dest |= slot_destinations[src_chunk_index];
+      if (dest.dropped) {
+        continue;
+      }
+      auto translation = LaidOutTensorTranslation(
+          total_chunks, input_layout.ChunkSize(),
+          output_chunk_numbers.at(dest.offset_flat) - src_chunk_number,
+          dest.chunk_index - src_chunk_index);
+      trans_mask_gen.RegisterTranslation(translation, src_chunk_number,
+                                         src_chunk_index);
+    }
   }
   return trans_mask_gen.GetTranslationMasks();
 }
@@ -18,9 +18,12 @@
 
 #include "include/utils.h"
 
+#include <algorithm>
+#include <atomic>
 #include <optional>
 #include <ostream>
 #include <random>
+#include <thread>
 #include <vector>
 
 #include "include/chunk_size.h"
@@ -39,4 +42,22 @@ double GetUniformRandom() {
   return unif(re);
 }
 
+void ParallelFor(int count, int thread_count,
+                 const std::function<void(int)>& func) {
+  std::atomic<int> next_idx = 0;
+  auto work = [&] {
+    for (int idx = next_idx++; idx < count; idx = next_idx++) {
+      func(idx);
+    }
+  };
+  std::vector<std::thread> threads;
+  for (int i = 1; i < std::min(thread_count, count); ++i) {
+    threads.emplace_back(work);
+  }
+  work();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
 }  // namespace fhelipe
@@ -18,61 +18,71 @@
 
 #include "include/value_numbering_pass.h"
 
+#include <algorithm>
+#include <unordered_map>
+
 #include "include/dag.h"
 #include "include/extended_std.h"
-#include "include/fill_gaps_layout_pass.h"
-#include "include/layout_utils.h"
 #include "include/node.h"
-#include "include/t_layout_conversion_c.h"
+#include "include/t_op.h"
 
 namespace fhelipe {
 
 namespace {
 
-std::vector<std::shared_ptr<Node<TOp>>> OnlyNodesWithAllParentsFrom(
-    const std::vector<std::shared_ptr<Node<TOp>>>& nodes,
-    const std::vector<std::shared_ptr<Node<TOp>>>& allowed_parents) {
-  return Estd::filter(nodes, [&allowed_parents](const auto& node) {
-    return Estd::all_of(node->Parents(),
-                        [&allowed_parents](const auto& parent) {
-                          return Estd::contains(allowed_parents, parent);
-                        });
-  });
-}
+using TOpNode = std::shared_ptr<Node<TOp>>;
 
-std::vector<std::shared_ptr<Node<TOp>>> NodesWithSameParents(
-    const std::shared_ptr<Node<TOp>>& t_op) {
-  CHECK(!t_op->Parents().empty());
+// Parents in the order that determines the node's value: commutative TOps
+// compare their inputs as a multiset
+std::vector<TOpNode> ValueParents(const Node<TOp>& node) {
+  auto parents = node.Parents();
+  if (node.Value().IsCommutative()) {
+    std::sort(parents.begin(), parents.end());
+  }
+  return parents;
+}
 
-  const auto& parents = t_op->Parents();
-  std::set<std::shared_ptr<Node<TOp>>> result = parents.at(0)->Children();
-  for (const auto& parent : parents) {
-    result = Estd::set_intersection(result, parent->Children());
+std::size_t ValueHash(const Node<TOp>& node) {
+  std::size_t result = node.Value().Hash();
+  for (const auto& parent : ValueParents(node)) {
+    result = TOp::HashCombine(result, std::hash<TOpNode>()(parent));
   }
-  return OnlyNodesWithAllParentsFrom(
-      Estd::set_to_vector(Estd::set_difference(result, {t_op})),
-      t_op->Parents());
+  return result;
+}
+
+bool SameValue(const Node<TOp>& lhs, const Node<TOp>& rhs) {
+  return lhs.Value() == rhs.Value() && ValueParents(lhs) == ValueParents(rhs);
 }
 
 }  // namespace
 
+// Hash-consing: nodes are visited in topological order, so by the time a node
+// is visited its parents have already been replaced by their value numbers
+// (the first node seen with that value), and a single table lookup keyed by
+// the TOp and its parents finds any earlier duplicate.
 LayoutOptimizerOutput ValueNumberingPass::DoPass(
     const LayoutOptimizerInput& in_dag) {
   auto out_dag = CloneFromAncestor(in_dag);
+  std::unordered_multimap<std::size_t, TOpNode> value_numbers;
   for (const auto& node : out_dag.NodesInTopologicalOrder()) {
     if (node->Parents().empty()) {
       continue;
     }
-    for (const auto& deduplication_candidate : NodesWithSameParents(node)) {
-      if (node->Value() == deduplication_candidate->Value()) {
-        InheritChildren(*node, deduplication_candidate);
-        for (int ancestor : node->Ancestors()) {
-          deduplication_candidate->AddAncestor(ancestor);
-        }
-        RemoveNodeWithoutReassaigningChildren(node);
-        break;
-      }
+    auto hash = ValueHash(*node);
+    auto [begin, end] = value_numbers.equal_range(hash);
+    auto it = std::find_if(begin, end, [&node](const auto& entry) {
+      return SameValue(*entry.second, *node);
+    });
+    if (it == end) {
+      value_numbers.emplace(hash, node);
+      continue;
+    }
+    const auto& value_number = it->second;
+    InheritChildren(*node, value_number);
+    for (int ancestor : node->Ancestors()) {
+      value_number->AddAncestor(ancestor);
     }
+    RemoveNodeWithoutReassaigningChildren(node);
   }
   return out_dag;
 }
@@ -62,7 +62,7 @@ std::shared_ptr<Node<ScaledTOp>> WaterlineRescale(
 LogScale NodeLogScale(
     const TOp* old_node,
     const std::vector<std::shared_ptr<Node<ScaledTOp>>>& parents,
-    LogScale ct_log_scale) {
+    LogScale mask_log_scale) {
   const std::vector<LogScale>& parents_log_scales = Estd::transform(
       parents, [](const auto& node) { return node->Value().LogScale(); });
 
@@ -82,24 +82,22 @@ LogScale NodeLogScale(
     return Estd::sum(parents_log_scales);
   }
 
-  // TODO(nsamar): BackendMaskDepth() should be multiplied by the log scale of
-  // backend-generated masks, not ct_log_scale. This scale of
-  // backend-generated masks could be stored as part of the context
   return parents_log_scales[0] + old_node->AddedLogScale() +
-         old_node->BackendMaskDepth() * ct_log_scale;
+         old_node->BackendMaskDepth() * mask_log_scale;
 }
 
 std::pair<std::shared_ptr<Node<ScaledTOp>>, std::shared_ptr<Node<ScaledTOp>>>
 BuildNewNode(Dag<ScaledTOp>& dag, const std::shared_ptr<Node<TOp>>& old_node,
              const std::vector<std::shared_ptr<Node<ScaledTOp>>>& parents,
-             LogScale ct_log_scale) {
-  LogScale log_scale = NodeLogScale(&old_node->Value(), parents, ct_log_scale);
+             const ProgramContext& context) {
+  LogScale log_scale =
+      NodeLogScale(&old_node->Value(), parents, context.MaskLogScale());
   auto new_node = dag.AddNode(
       std::make_unique<ScaledTOp>(old_node->Value().CloneUniq(), log_scale),
       parents, {old_node->NodeId()});
 
-  return std::make_pair(new_node,
-                        WaterlineRescale(dag, new_node, ct_log_scale));
+  return std::make_pair(
+      new_node, WaterlineRescale(dag, new_node, context.LogScale()));
 }
 
 }  // namespace
@@ -113,7 +111,7 @@ RescalingPassOutput WaterlineRescale::DoPass(const RescalingPassInput& in_dag) {
     const auto& parents =
         Estd::values_from_keys(old_to_new_nodes, old_node->Parents());
     const auto [match_node, new_node] =
-        BuildNewNode(dag, old_node, parents, context_.LogScale());
+        BuildNewNode(dag, old_node, parents, context_);
     old_to_new_nodes.emplace(old_node.get(), new_node);
   }
 
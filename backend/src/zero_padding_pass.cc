@@ -0,0 +1,118 @@
+/** $lic$
+ * Copyright (C) 2023-2024 by Massachusetts Institute of Technology
+ *
+ * This file is part of the Fhelipe compiler.
+ *
+ * Fhelipe is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, version 3.
+ *
+ * Fhelipe is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program. If not, see <http://www.gnu.org/licenses/>. 
+ */
+
+#include "include/zero_padding_pass.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+#include "include/node.h"
+#include "include/pass_utils.h"
+#include "include/t_add_cc.h"
+#include "include/t_cyclic_shift_c.h"
+#include "include/t_input_c.h"
+#include "include/t_layout_conversion_c.h"
+#include "include/t_merged_mul_chain_cp.h"
+#include "include/t_mul_cc.h"
+#include "include/t_mul_cp.h"
+#include "include/t_mul_csi.h"
+#include "include/t_reduce_dim_c.h"
+#include "include/t_reorder_dims_c.h"
+#include "include/t_replicate_dim_c.h"
+#include "include/t_rescale_c.h"
+#include "include/t_resize_dim_c.h"
+#include "include/t_stride_c.h"
+#include "include/t_unpadded_shift_c.h"
+#include "include/utils.h"
+
+namespace fhelipe {
+
+namespace {
+
+template <class T>
+bool SetInputPaddingIsZero(TOp& t_op, bool input_padding_is_zero) {
+  auto* derived = dynamic_cast<T*>(&t_op);
+  if (derived) {
+    derived->SetInputPaddingIsZero(input_padding_is_zero);
+  }
+  return derived;
+}
+
+// Whether the padding of the output of `t_op` is zero, given that of its
+// parents; tells TOps that translate their input about its padding
+bool OutputPaddingIsZero(TOp& t_op, const std::vector<bool>& parents) {
+  if (dynamic_cast<const TInputC*>(&t_op)) {
+    // Packed with zeros in the padding
+    return true;
+  }
+  if (parents.empty()) {
+    return false;
+  }
+  if (dynamic_cast<const TAddCC*>(&t_op)) {
+    return std::count(parents.begin(), parents.end(), false) == 0;
+  }
+  if (dynamic_cast<const TMulCC*>(&t_op)) {
+    return std::count(parents.begin(), parents.end(), true) > 0;
+  }
+  if (dynamic_cast<const TMulCP*>(&t_op) ||
+      dynamic_cast<const TMulCSI*>(&t_op) ||
+      dynamic_cast<const TMergedMulChainCP*>(&t_op) ||
+      dynamic_cast<const TRescaleC*>(&t_op)) {
+    return parents[0];
+  }
+  // Masked translations only move tensor elements, so they leave zeros in
+  // the padding; unmasked ones move the padding of the input along
+  if (SetInputPaddingIsZero<TLayoutConversionC>(t_op, parents[0]) ||
+      SetInputPaddingIsZero<TStrideC>(t_op, parents[0]) ||
+      SetInputPaddingIsZero<TReorderDimsC>(t_op, parents[0]) ||
+      SetInputPaddingIsZero<TCyclicShiftC>(t_op, parents[0]) ||
+      SetInputPaddingIsZero<TResizeDimC>(t_op, parents[0]) ||
+      dynamic_cast<const TUnpaddedShiftC*>(&t_op)) {
+    return parents[0] || t_op.BackendMaskDepth() > 0;
+  }
+  // Both finish with a masked resize or a mask of all invalid slots, if any
+  if (dynamic_cast<const TReduceDimC*>(&t_op)) {
+    return t_op.BackendMaskDepth() > 0;
+  }
+  if (const auto* t_replicate_dim_c =
+          dynamic_cast<const TReplicateDimC*>(&t_op)) {
+    return !IsPowerOfTwo(t_replicate_dim_c->Multiple());
+  }
+  return false;
+}
+
+}  // namespace
+
+LayoutOptimizerOutput ZeroPaddingPass::DoPass(
+    const LayoutOptimizerInput& in_dag) {
+  Dag<TOp> out_dag = CloneFromAncestor(in_dag);
+
+  std::unordered_map<const Node<TOp>*, bool> padding_is_zero;
+  for (auto node : out_dag.NodesInTopologicalOrder()) {
+    std::vector<bool> parents;
+    for (const auto& parent : node->Parents()) {
+      parents.push_back(padding_is_zero.at(parent.get()));
+    }
+    padding_is_zero.emplace(node.get(),
+                            OutputPaddingIsZero(node->Value(), parents));
+  }
+  return out_dag;
+}
+
+}  // namespace fhelipe